@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace DX
+{
+	namespace Bench
+	{
+		struct Benchmark
+		{
+			const char* Name;
+			void (*Body)();
+		};
+
+		std::vector<Benchmark>& GetBenchmarks();
+
+		struct Registrar
+		{
+			Registrar(const char* name, void (*body)()) { GetBenchmarks().push_back({ name, body }); }
+		};
+
+		// Prints one result line: label, value and unit in aligned columns.
+		void Report(const char* label, double value, const char* unit);
+
+		// Keeps the optimizer from dropping work whose result is never read.
+		void DoNotOptimize(const void* p);
+
+		// Calls body once to warm up, then in rounds of at least minSeconds,
+		// and returns the fastest round in nanoseconds per call.
+		template <class Body>
+		double MeasureNs(Body&& body, const double minSeconds = 0.05, const int rounds = 5)
+		{
+			using Clock = std::chrono::steady_clock;
+
+			body();
+
+			double best = 1e300;
+			for (int round = 0; round < rounds; ++round)
+			{
+				size_t calls = 0;
+				const auto start = Clock::now();
+				auto elapsed = Clock::duration::zero();
+				do
+				{
+					body();
+					++calls;
+					elapsed = Clock::now() - start;
+				} while (std::chrono::duration<double>(elapsed).count() < minSeconds);
+
+				best = std::min(best, std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(calls));
+			}
+			return best;
+		}
+	}
+}
+
+// Defines and registers a benchmark, which prints its own results through Report.
+#define DX_BENCH(name) \
+	static void name(); \
+	static const ::DX::Bench::Registrar name##Registrar(#name, name); \
+	static void name()
@@ -0,0 +1,40 @@
+#include "BenchHarness.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const void* volatile gSink = nullptr;
+}
+
+std::vector<DX::Bench::Benchmark>& DX::Bench::GetBenchmarks()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+void DX::Bench::Report(const char* label, const double value, const char* unit)
+{
+	std::printf("  %-48s %12.3f %s\n", label, value, unit);
+}
+
+void DX::Bench::DoNotOptimize(const void* p)
+{
+	gSink = p;
+}
+
+// Runs every benchmark, or only those whose name contains the first argument.
+int main(const int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	for (const auto& benchmark : DX::Bench::GetBenchmarks())
+	{
+		if (filter != nullptr && std::strstr(benchmark.Name, filter) == nullptr) continue;
+
+		std::printf("%s\n", benchmark.Name);
+		benchmark.Body();
+	}
+	return 0;
+}
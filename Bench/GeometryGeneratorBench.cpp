@@ -0,0 +1,43 @@
+#include "BenchHarness.h"
+
+#include "GeometryGenerator.h"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace
+{
+	using DX::GeometryGenerator;
+
+	// CreateGeosphere caps the depth here.
+	constexpr std::uint32_t MAX_DEPTH = 8;
+}
+
+// Vertex count, mesh size and build time of CreateGeosphere at every depth
+// it accepts.
+DX_BENCH(Geosphere)
+{
+	for (std::uint32_t depth = 0; depth <= MAX_DEPTH; ++depth)
+	{
+		GeometryGenerator geoGen;
+		GeometryGenerator::MeshData mesh;
+		const bool large = depth >= 7;
+
+		const double ns = DX::Bench::MeasureNs([&geoGen, &mesh, depth]
+		{
+			mesh = geoGen.CreateGeosphere(1.0f, depth);
+			DX::Bench::DoNotOptimize(mesh.Vertices.data());
+		}, large ? 0.0 : 0.1, large ? 1 : 3);
+
+		const double bytes = static_cast<double>(mesh.Vertices.size() * sizeof(GeometryGenerator::Vertex) +
+			mesh.Indices32.size() * sizeof(std::uint32_t));
+
+		char label[64];
+		std::snprintf(label, sizeof(label), "depth %u, vertices", depth);
+		DX::Bench::Report(label, static_cast<double>(mesh.Vertices.size()), "verts");
+		std::snprintf(label, sizeof(label), "depth %u, vertices and 32-bit indices", depth);
+		DX::Bench::Report(label, bytes / (1024.0 * 1024.0), "MB");
+		std::snprintf(label, sizeof(label), "depth %u, CreateGeosphere", depth);
+		DX::Bench::Report(label, ns * 1e-6, "ms");
+	}
+}
@@ -0,0 +1,184 @@
+#include "BenchHarness.h"
+
+#include "MathHelper.h"
+
+#include <DirectXMath.h>
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	using namespace DirectX;
+	using DX::MathHelper;
+	using DX::TransformClass;
+
+	constexpr size_t TRANSFORM_COUNT = 1 << 20;
+
+	// Small enough that the batch benchmark measures the kernels, not memory.
+	constexpr size_t BATCH_COUNT = 1 << 14;
+
+	XMMATRIX RandomRotation(DX::Random& random)
+	{
+		return XMMatrixRotationX(random.NextFloat(-XM_PI, XM_PI)) *
+			XMMatrixRotationY(random.NextFloat(-XM_PI, XM_PI)) *
+			XMMatrixRotationZ(random.NextFloat(-XM_PI, XM_PI));
+	}
+
+	// A scene-like mix: 60% rigid, 20% uniformly scaled, 10% affine and 10% projective.
+	std::vector<XMFLOAT4X4> MakeTransforms()
+	{
+		DX::Random random(11);
+		std::vector<XMFLOAT4X4> transforms(TRANSFORM_COUNT);
+
+		for (size_t i = 0; i < TRANSFORM_COUNT; ++i)
+		{
+			const XMMATRIX translation = XMMatrixTranslation(
+				random.NextFloat(-100.0f, 100.0f), random.NextFloat(-100.0f, 100.0f), random.NextFloat(-100.0f, 100.0f));
+			const float scale = random.NextFloat(0.1f, 10.0f);
+			const size_t bucket = i % 10;
+
+			XMMATRIX m = RandomRotation(random) * translation;
+			if (bucket >= 6) m = XMMatrixScaling(scale, scale, scale) * m;
+			if (bucket == 8) m = XMMatrixScaling(1.0f, 2.0f, 0.5f) * m;
+			if (bucket == 9) m.r[0] = XMVectorSet(XMVectorGetX(m.r[0]), XMVectorGetY(m.r[0]), XMVectorGetZ(m.r[0]), 0.05f);
+			XMStoreFloat4x4(&transforms[i], m);
+		}
+		return transforms;
+	}
+}
+
+// Inverse-transposes of a million world matrices, per transform.
+DX_BENCH(InverseTranspose)
+{
+	const std::vector<XMFLOAT4X4> transforms = MakeTransforms();
+	std::vector<XMFLOAT4X4> results(TRANSFORM_COUNT);
+	std::vector<TransformClass> classes(TRANSFORM_COUNT);
+	const double count = static_cast<double>(TRANSFORM_COUNT);
+
+	const double classifyNs = DX::Bench::MeasureNs([&]
+	{
+		for (size_t i = 0; i < TRANSFORM_COUNT; ++i) classes[i] = MathHelper::ClassifyTransform(XMLoadFloat4x4(&transforms[i]));
+		DX::Bench::DoNotOptimize(classes.data());
+	}, 0.2, 3);
+	DX::Bench::Report("ClassifyTransform", classifyNs / count, "ns/transform");
+
+	const double classifiedNs = DX::Bench::MeasureNs([&]
+	{
+		for (size_t i = 0; i < TRANSFORM_COUNT; ++i)
+		{
+			XMStoreFloat4x4(&results[i], MathHelper::InverseTranspose(XMLoadFloat4x4(&transforms[i]), classes[i]));
+		}
+		DX::Bench::DoNotOptimize(results.data());
+	}, 0.2, 3);
+	DX::Bench::Report("InverseTranspose, classified", classifiedNs / count, "ns/transform");
+
+	const double generalNs = DX::Bench::MeasureNs([&]
+	{
+		for (size_t i = 0; i < TRANSFORM_COUNT; ++i)
+		{
+			XMStoreFloat4x4(&results[i], MathHelper::InverseTranspose(XMLoadFloat4x4(&transforms[i])));
+		}
+		DX::Bench::DoNotOptimize(results.data());
+	}, 0.2, 3);
+	DX::Bench::Report("InverseTranspose, general", generalNs / count, "ns/transform");
+
+	std::vector<float> soaData(16 * TRANSFORM_COUNT);
+	const DX::MatrixSoa soa{ soaData.data(), TRANSFORM_COUNT };
+	for (size_t i = 0; i < TRANSFORM_COUNT; ++i) MathHelper::StoreSoa(soa, i, transforms[i]);
+
+	std::vector<float> outData(16 * TRANSFORM_COUNT);
+	const DX::MatrixSoa out{ outData.data(), TRANSFORM_COUNT };
+	const double batchNs = DX::Bench::MeasureNs([&]
+	{
+		MathHelper::InverseTransposeBatch(soa, out, TRANSFORM_COUNT);
+		DX::Bench::DoNotOptimize(outData.data());
+	}, 0.2, 3);
+	DX::Bench::Report("InverseTransposeBatch", batchNs / count, "ns/transform");
+}
+
+// The batch kernels per matrix on each instruction set the processor has,
+// next to the per-matrix DirectXMath loop they replace.
+DX_BENCH(MatrixBatch)
+{
+	std::vector<XMFLOAT4X4> transforms = MakeTransforms();
+	transforms.resize(BATCH_COUNT);
+	const double count = static_cast<double>(BATCH_COUNT);
+
+	std::vector<XMFLOAT4X4> results(BATCH_COUNT);
+	// One of the projective transforms, standing in for a view-projection.
+	const XMMATRIX viewProj = XMLoadFloat4x4(&transforms[9]);
+
+	const double multiplyNs = DX::Bench::MeasureNs([&]
+	{
+		for (size_t i = 0; i < BATCH_COUNT; ++i)
+		{
+			XMStoreFloat4x4(&results[i], XMMatrixMultiply(XMLoadFloat4x4(&transforms[i]), XMLoadFloat4x4(&transforms[BATCH_COUNT - 1 - i])));
+		}
+		DX::Bench::DoNotOptimize(results.data());
+	}, 0.1, 3);
+	DX::Bench::Report("Multiply, per matrix", multiplyNs / count, "ns/matrix");
+
+	const double multiplyByNs = DX::Bench::MeasureNs([&]
+	{
+		for (size_t i = 0; i < BATCH_COUNT; ++i) XMStoreFloat4x4(&results[i], XMLoadFloat4x4(&transforms[i]) * viewProj);
+		DX::Bench::DoNotOptimize(results.data());
+	}, 0.1, 3);
+	DX::Bench::Report("MultiplyBy, per matrix", multiplyByNs / count, "ns/matrix");
+
+	const double inverseNs = DX::Bench::MeasureNs([&]
+	{
+		for (size_t i = 0; i < BATCH_COUNT; ++i) XMStoreFloat4x4(&results[i], MathHelper::InverseTranspose(XMLoadFloat4x4(&transforms[i])));
+		DX::Bench::DoNotOptimize(results.data());
+	}, 0.1, 3);
+	DX::Bench::Report("InverseTranspose, per matrix", inverseNs / count, "ns/matrix");
+
+	std::vector<float> aData(16 * BATCH_COUNT), bData(16 * BATCH_COUNT), outData(16 * BATCH_COUNT);
+	const DX::MatrixSoa a{ aData.data(), BATCH_COUNT };
+	const DX::MatrixSoa b{ bData.data(), BATCH_COUNT };
+	const DX::MatrixSoa out{ outData.data(), BATCH_COUNT };
+	for (size_t i = 0; i < BATCH_COUNT; ++i)
+	{
+		MathHelper::StoreSoa(a, i, transforms[i]);
+		MathHelper::StoreSoa(b, i, transforms[BATCH_COUNT - 1 - i]);
+	}
+
+	const DX::BatchIsa supported = MathHelper::GetBatchIsa();
+	const struct
+	{
+		DX::BatchIsa Isa;
+		const char* Name;
+	} paths[] = { { DX::BatchIsa::Scalar, "scalar" }, { DX::BatchIsa::Avx2, "AVX2" }, { DX::BatchIsa::Avx512, "AVX-512" } };
+
+	for (const auto& path : paths)
+	{
+		if (path.Isa > supported) break;
+		MathHelper::SetBatchIsa(path.Isa);
+		char label[64];
+
+		const double batchMultiplyNs = DX::Bench::MeasureNs([&]
+		{
+			MathHelper::MultiplyBatch(a, b, out, BATCH_COUNT);
+			DX::Bench::DoNotOptimize(outData.data());
+		}, 0.1, 3);
+		std::snprintf(label, sizeof(label), "MultiplyBatch, %s", path.Name);
+		DX::Bench::Report(label, batchMultiplyNs / count, "ns/matrix");
+
+		const double batchMultiplyByNs = DX::Bench::MeasureNs([&]
+		{
+			MathHelper::MultiplyBatch(a, viewProj, out, BATCH_COUNT);
+			DX::Bench::DoNotOptimize(outData.data());
+		}, 0.1, 3);
+		std::snprintf(label, sizeof(label), "MultiplyBatch by one matrix, %s", path.Name);
+		DX::Bench::Report(label, batchMultiplyByNs / count, "ns/matrix");
+
+		const double batchInverseNs = DX::Bench::MeasureNs([&]
+		{
+			MathHelper::InverseTransposeBatch(a, out, BATCH_COUNT);
+			DX::Bench::DoNotOptimize(outData.data());
+		}, 0.1, 3);
+		std::snprintf(label, sizeof(label), "InverseTransposeBatch, %s", path.Name);
+		DX::Bench::Report(label, batchInverseNs / count, "ns/matrix");
+	}
+	MathHelper::SetBatchIsa(supported);
+}
@@ -0,0 +1,56 @@
+#include "BenchHarness.h"
+
+#include "GeometryGenerator.h"
+#include "MeshLod.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using DX::GeometryGenerator;
+
+	// Levels of the chains the original measurements used.
+	constexpr std::uint32_t LEVEL_COUNT = 6;
+
+	struct NamedMesh
+	{
+		const char* Name;
+		GeometryGenerator::MeshData Mesh;
+	};
+
+	std::vector<NamedMesh> MakeMeshes()
+	{
+		GeometryGenerator geoGen;
+		std::vector<NamedMesh> meshes;
+		meshes.push_back({ "grid 50x50", geoGen.CreateGrid(50.0f, 50.0f, 50, 50) });
+		meshes.push_back({ "sphere 40x40", geoGen.CreateSphere(1.0f, 40, 40) });
+		meshes.push_back({ "geosphere d5", geoGen.CreateGeosphere(1.0f, 5) });
+		meshes.push_back({ "geosphere d8", geoGen.CreateGeosphere(1.0f, 8) });
+		return meshes;
+	}
+}
+
+// Input triangles simplified per second by BuildLodChain, single-threaded.
+DX_BENCH(MeshLod)
+{
+	for (const auto& [name, mesh] : MakeMeshes())
+	{
+		const double triangles = static_cast<double>(mesh.Indices32.size() / 3);
+		const bool large = triangles > 1e6;
+
+		size_t levels = 0;
+		const double ns = DX::Bench::MeasureNs([&mesh, &levels]
+		{
+			const DX::MeshLodChain chain = DX::BuildLodChain(mesh, LEVEL_COUNT);
+			levels = chain.Levels.size();
+			DX::Bench::DoNotOptimize(chain.Indices.data());
+		}, large ? 0.0 : 0.2, large ? 1 : 3);
+
+		const std::string prefix = name;
+		DX::Bench::Report((prefix + ", triangles").c_str(), triangles, "tris");
+		DX::Bench::Report((prefix + ", levels").c_str(), static_cast<double>(levels), "levels");
+		DX::Bench::Report((prefix + ", BuildLodChain").c_str(), triangles / ns * 1e3, "Mtri/s");
+	}
+}
@@ -0,0 +1,60 @@
+#include "BenchHarness.h"
+
+#include "GeometryGenerator.h"
+#include "MeshOptimizer.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using DX::GeometryGenerator;
+
+	struct NamedMesh
+	{
+		const char* Name;
+		GeometryGenerator::MeshData Mesh;
+	};
+
+	std::vector<NamedMesh> MakeMeshes()
+	{
+		GeometryGenerator geoGen;
+		std::vector<NamedMesh> meshes;
+		meshes.push_back({ "grid 256x256", geoGen.CreateGrid(160.0f, 160.0f, 256, 256) });
+		meshes.push_back({ "sphere 64x64", geoGen.CreateSphere(1.0f, 64, 64) });
+		meshes.push_back({ "geosphere d5", geoGen.CreateGeosphere(1.0f, 5) });
+		meshes.push_back({ "cylinder 64x32", geoGen.CreateCylinder(1.0f, 0.5f, 3.0f, 64, 32) });
+		meshes.push_back({ "box subdiv 4", geoGen.CreateBox(1.0f, 1.0f, 1.0f, 4) });
+		return meshes;
+	}
+}
+
+// ACMR and ATVR with the 16-entry FIFO cache, before and after OptimizeMesh,
+// and the time OptimizeMesh takes on a single thread.
+DX_BENCH(MeshOptimizer)
+{
+	for (const auto& [name, mesh] : MakeMeshes())
+	{
+		const auto before = DX::AnalyzeVertexCache(mesh.Indices32.data(), mesh.Indices32.size(), mesh.Vertices.size());
+
+		GeometryGenerator::MeshData optimized = mesh;
+		DX::OptimizeMesh(optimized);
+		const auto after = DX::AnalyzeVertexCache(optimized.Indices32.data(), optimized.Indices32.size(),
+			optimized.Vertices.size());
+
+		const double ns = DX::Bench::MeasureNs([&mesh]
+		{
+			GeometryGenerator::MeshData copy = mesh;
+			DX::OptimizeMesh(copy);
+			DX::Bench::DoNotOptimize(copy.Indices32.data());
+		}, 0.2, 3);
+
+		const std::string prefix = name;
+		DX::Bench::Report((prefix + ", ACMR before").c_str(), before.Acmr, "misses/tri");
+		DX::Bench::Report((prefix + ", ACMR after").c_str(), after.Acmr, "misses/tri");
+		DX::Bench::Report((prefix + ", ATVR before").c_str(), before.Atvr, "misses/vertex");
+		DX::Bench::Report((prefix + ", ATVR after").c_str(), after.Atvr, "misses/vertex");
+		DX::Bench::Report((prefix + ", OptimizeMesh").c_str(), ns / 1e6, "ms");
+	}
+}
@@ -0,0 +1,41 @@
+#include "BenchHarness.h"
+
+#include "GeometryGenerator.h"
+#include "MeshTangents.h"
+#include "ThreadPool.h"
+
+#include <DirectXMath.h>
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	using DX::GeometryGenerator;
+}
+
+// Tangents for a 1.31M-triangle geosphere, on one thread and on a pool
+// with a worker per hardware thread.
+DX_BENCH(MeshTangents)
+{
+	GeometryGenerator geoGen;
+	const GeometryGenerator::MeshData mesh = geoGen.CreateGeosphere(1.0f, 8);
+	const double triangles = static_cast<double>(mesh.Indices32.size() / 3);
+	std::vector<DirectX::XMFLOAT4> tangents(mesh.Vertices.size());
+
+	DX::ThreadPool threadPool;
+	for (DX::ThreadPool* pool : { static_cast<DX::ThreadPool*>(nullptr), &threadPool })
+	{
+		const double ns = DX::Bench::MeasureNs([&mesh, &tangents, pool]
+		{
+			DX::GenerateTangents(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices32.data(),
+				mesh.Indices32.size(), tangents.data(), pool);
+			DX::Bench::DoNotOptimize(tangents.data());
+		}, 0.5, 3);
+
+		char label[64];
+		std::snprintf(label, sizeof(label), "geosphere d8, %u thread(s)",
+			pool == nullptr ? 1u : static_cast<unsigned>(pool->GetThreadCount()));
+		DX::Bench::Report(label, triangles / ns * 1e3, "Mtri/s");
+	}
+}
@@ -0,0 +1,39 @@
+#include "BenchHarness.h"
+
+#include "Profiler.h"
+
+#include <cstdint>
+
+namespace
+{
+	using DX::Profiler;
+
+	constexpr int ZONES_PER_CALL = 4096;
+}
+
+// Cost of an empty zone next to the counter read it makes twice, which
+// sets its floor; the difference is the ring write.
+DX_BENCH(ProfileZone)
+{
+	const double ticksNs = DX::Bench::MeasureNs([]
+	{
+		std::uint64_t sum = 0;
+		for (int i = 0; i < ZONES_PER_CALL; ++i) sum += Profiler::GetTicks();
+		DX::Bench::DoNotOptimize(&sum);
+	}, 0.1);
+	DX::Bench::Report("GetTicks", ticksNs / ZONES_PER_CALL, "ns/read");
+
+	const double zoneNs = DX::Bench::MeasureNs([]
+	{
+		for (int i = 0; i < ZONES_PER_CALL; ++i)
+		{
+			DX_PROFILE_ZONE("ProfileZone bench");
+		}
+	}, 0.1);
+	DX::Bench::Report("DX_PROFILE_ZONE, empty scope", zoneNs / ZONES_PER_CALL, "ns/zone");
+#if DX_PROFILER
+	DX::Bench::Report("DX_PROFILE_ZONE less two GetTicks", (zoneNs - 2.0 * ticksNs) / ZONES_PER_CALL, "ns/zone");
+#endif
+
+	Profiler::Clear();
+}
@@ -0,0 +1,84 @@
+#include "BenchHarness.h"
+
+#include "CpuFeatures.h"
+#include "Random.h"
+#include "RandomKernels.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+	using DX::Random;
+	using uint32 = std::uint32_t;
+
+	constexpr size_t VALUE_COUNT = 4096;
+	constexpr size_t BLOCK_COUNT = VALUE_COUNT / Random::LANE_COUNT;
+
+	// Eight xoshiro128** states laid out as Random keeps them.
+	struct Lanes
+	{
+		Lanes()
+		{
+			for (size_t word = 0; word < 4; ++word)
+			{
+				for (size_t lane = 0; lane < Random::LANE_COUNT; ++lane)
+				{
+					State[word][lane] = 0x9e3779b9u * static_cast<uint32>(word * Random::LANE_COUNT + lane + 1);
+				}
+			}
+		}
+
+		alignas(32) uint32 State[4][Random::LANE_COUNT];
+	};
+
+	void ReportPerValue(const char* label, const double ns)
+	{
+		DX::Bench::Report(label, ns / VALUE_COUNT, "ns/value");
+	}
+}
+
+// 4096 32-bit draws per call from rand(), from Random one at a time, and
+// from the eight-lane block stepper with and without AVX2.
+DX_BENCH(RandomDraws)
+{
+	static uint32 values[VALUE_COUNT];
+
+	ReportPerValue("rand()", DX::Bench::MeasureNs([]
+	{
+		for (uint32& value : values) value = static_cast<uint32>(std::rand());
+		DX::Bench::DoNotOptimize(values);
+	}));
+
+	Random generator;
+	ReportPerValue("Random::NextUInt", DX::Bench::MeasureNs([&generator]
+	{
+		for (uint32& value : values) value = generator.NextUInt();
+		DX::Bench::DoNotOptimize(values);
+	}));
+
+	ReportPerValue("Random::Fill", DX::Bench::MeasureNs([&generator]
+	{
+		generator.Fill(values, VALUE_COUNT);
+		DX::Bench::DoNotOptimize(values);
+	}));
+
+	Lanes lanes;
+	ReportPerValue("NextBlocks, scalar", DX::Bench::MeasureNs([&lanes]
+	{
+		DX::RandomKernels::NextBlocksScalar(&lanes.State[0][0], values, BLOCK_COUNT);
+		DX::Bench::DoNotOptimize(values);
+	}));
+
+	const auto avx2 = DX::GetCpuFeatures().Avx2 ? DX::RandomKernels::GetAvx2NextBlocks() : nullptr;
+	if (avx2 == nullptr)
+	{
+		DX::Bench::Report("NextBlocks, AVX2 (not available)", 0.0, "ns/value");
+		return;
+	}
+	ReportPerValue("NextBlocks, AVX2", DX::Bench::MeasureNs([&lanes, avx2]
+	{
+		avx2(&lanes.State[0][0], values, BLOCK_COUNT);
+		DX::Bench::DoNotOptimize(values);
+	}));
+}
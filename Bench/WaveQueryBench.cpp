@@ -0,0 +1,111 @@
+#include "BenchHarness.h"
+
+#include "CpuWaves.h"
+#include "WaveQuery.h"
+#include "WaveSurface.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	using DX::CpuWaves;
+	using DX::WaveQueryBatch;
+	using DX::WaveSurface;
+
+	constexpr int GRID_SIZE = 1024;
+	constexpr float SPATIAL_STEP = 0.25f;
+	constexpr size_t QUERY_COUNT = 100000;
+
+	// Outputs of one batch, allocated once so the bench times only the sampling.
+	struct QueryBuffers
+	{
+		std::vector<float> X = std::vector<float>(QUERY_COUNT);
+		std::vector<float> Z = std::vector<float>(QUERY_COUNT);
+		std::vector<float> Heights = std::vector<float>(QUERY_COUNT);
+		std::vector<float> Velocities = std::vector<float>(QUERY_COUNT);
+		std::vector<float> NormalX = std::vector<float>(QUERY_COUNT);
+		std::vector<float> NormalY = std::vector<float>(QUERY_COUNT);
+		std::vector<float> NormalZ = std::vector<float>(QUERY_COUNT);
+	};
+
+	// Positions spread uniformly over the grid, in no particular order.
+	void FillRandomPositions(QueryBuffers& buffers)
+	{
+		const float halfExtent = 0.5f * SPATIAL_STEP * (GRID_SIZE - 1);
+		std::uint32_t state = 2463534242u;
+		const auto next = [&state]
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return static_cast<float>(state >> 8) / 16777216.0f;
+		};
+
+		for (size_t q = 0; q < QUERY_COUNT; ++q)
+		{
+			buffers.X[q] = (2.0f * next() - 1.0f) * halfExtent;
+			buffers.Z[q] = (2.0f * next() - 1.0f) * halfExtent;
+		}
+	}
+}
+
+// 100k random queries on a 1024x1024 surface, the size of a physics or AI
+// frame's worth of probes, for each combination of outputs a caller asks for.
+DX_BENCH(WaveQueries)
+{
+	auto waves = std::make_unique<CpuWaves>(GRID_SIZE, GRID_SIZE, SPATIAL_STEP, 0.03f, 2.0f, 0.2f);
+	for (int k = 0; k < 64; ++k)
+	{
+		waves->Disturb(16 + 61 * k % (GRID_SIZE - 32), 16 + 37 * k % (GRID_SIZE - 32), 1.0f);
+		waves->Step();
+	}
+	auto surface = std::make_unique<WaveSurface>(*waves);
+	surface->Update(*waves);
+
+	QueryBuffers buffers;
+	FillRandomPositions(buffers);
+
+	WaveQueryBatch heights;
+	heights.X = buffers.X.data();
+	heights.Z = buffers.Z.data();
+	heights.Count = QUERY_COUNT;
+	heights.Heights = buffers.Heights.data();
+
+	WaveQueryBatch withVelocities = heights;
+	withVelocities.Velocities = buffers.Velocities.data();
+
+	WaveQueryBatch normals = heights;
+	normals.Heights = nullptr;
+	normals.NormalX = buffers.NormalX.data();
+	normals.NormalY = buffers.NormalY.data();
+	normals.NormalZ = buffers.NormalZ.data();
+
+	WaveQueryBatch all = withVelocities;
+	all.NormalX = buffers.NormalX.data();
+	all.NormalY = buffers.NormalY.data();
+	all.NormalZ = buffers.NormalZ.data();
+
+	const struct
+	{
+		const char* Label;
+		const WaveQueryBatch* Batch;
+	} cases[] =
+	{
+		{ "100k queries, heights", &heights },
+		{ "100k queries, heights and velocities", &withVelocities },
+		{ "100k queries, normals", &normals },
+		{ "100k queries, all outputs", &all },
+	};
+
+	for (const auto& c : cases)
+	{
+		const double ns = DX::Bench::MeasureNs([&surface, &c]
+		{
+			DX::QueryWaveSurface(*surface, *c.Batch);
+		}, 0.1);
+		DX::Bench::DoNotOptimize(buffers.Heights.data());
+		DX::Bench::Report(c.Label, ns * 1e-6, "ms");
+	}
+}
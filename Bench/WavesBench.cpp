@@ -0,0 +1,221 @@
+#include "BenchHarness.h"
+
+#include "CpuWaves.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using DX::CpuWaves;
+	using DX::WaveDisturbance;
+
+	// Grid and constants of the waves in MyGame.
+	constexpr int GRID_SIZE = 256;
+
+	std::unique_ptr<CpuWaves> MakeWaves(const int size = GRID_SIZE)
+	{
+		return std::make_unique<CpuWaves>(size, size, 0.25f, 0.03f, 2.0f, 0.2f);
+	}
+
+	// 1, 2 and 4 threads and one per hardware thread, without repeats.
+	std::vector<unsigned> GetThreadCounts()
+	{
+		std::vector<unsigned> counts = { 1, 2, 4 };
+		const unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+		if (std::find(counts.begin(), counts.end(), hardware) == counts.end()) counts.push_back(hardware);
+		return counts;
+	}
+
+	// Cells updated per second by a solver stepping stepsPerCall steps per call.
+	double MeasureMcellsPerSecond(CpuWaves& waves, const std::uint32_t stepsPerCall = 1)
+	{
+		waves.Disturb(waves.GetRowCount() / 2, waves.GetColumnCount() / 2, 1.0f);
+		const double ns = DX::Bench::MeasureNs([&waves, stepsPerCall] { waves.Step(stepsPerCall); }, 0.1, 3);
+		return static_cast<double>(waves.GetRowCount()) * waves.GetColumnCount() * stepsPerCall / ns * 1e3;
+	}
+
+	// Frames of random drops, cycled so every call sees a different frame.
+	// Magnitudes alternate in sign so heights stay bounded over many calls.
+	std::vector<std::vector<WaveDisturbance>> MakeFrames(const size_t dropsPerFrame)
+	{
+		std::uint32_t state = 2463534242u;
+		const auto next = [&state](const std::uint32_t bound)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state % bound;
+		};
+
+		std::vector<std::vector<WaveDisturbance>> frames(16);
+		for (auto& frame : frames)
+		{
+			frame.resize(dropsPerFrame);
+			for (size_t k = 0; k < dropsPerFrame; ++k)
+			{
+				frame[k].Row = 4 + next(GRID_SIZE - 8);
+				frame[k].Col = 4 + next(GRID_SIZE - 8);
+				frame[k].Magnitude = (k % 2 == 0 ? 1.0f : -1.0f) * (0.2f + 0.001f * next(300));
+			}
+		}
+		return frames;
+	}
+}
+
+DX_BENCH(WaveDisturbances)
+{
+	for (const size_t drops : { size_t{ 1 }, size_t{ 64 }, size_t{ 4096 } })
+	{
+		const auto frames = MakeFrames(drops);
+		char label[64];
+
+		{
+			auto waves = MakeWaves();
+			size_t frame = 0;
+			const double ns = DX::Bench::MeasureNs([&]
+			{
+				for (const auto& drop : frames[frame++ % frames.size()]) waves->Disturb(drop.Row, drop.Col, drop.Magnitude);
+			});
+			std::snprintf(label, sizeof(label), "%zu drops/frame, Disturb per drop", drops);
+			DX::Bench::Report(label, ns / 1000.0, "us/frame");
+		}
+
+		{
+			auto waves = MakeWaves();
+			size_t frame = 0;
+			const double ns = DX::Bench::MeasureNs([&]
+			{
+				const auto& drops = frames[frame++ % frames.size()];
+				waves->DisturbBatch(drops.data(), drops.size());
+			});
+			std::snprintf(label, sizeof(label), "%zu drops/frame, DisturbBatch", drops);
+			DX::Bench::Report(label, ns / 1000.0, "us/frame");
+		}
+
+		// What Waves::DisturbBatch spends on the CPU before its dispatch.
+		{
+			std::vector<DX::WaveCellDelta> cells;
+			size_t frame = 0;
+			const double ns = DX::Bench::MeasureNs([&]
+			{
+				const auto& drops = frames[frame++ % frames.size()];
+				DX::CompactDisturbances(drops.data(), drops.size(), GRID_SIZE, GRID_SIZE, cells);
+				DX::Bench::DoNotOptimize(cells.data());
+			});
+			std::snprintf(label, sizeof(label), "%zu drops/frame, CompactDisturbances", drops);
+			DX::Bench::Report(label, ns / 1000.0, "us/frame");
+		}
+	}
+}
+
+// Dense fp32 sweep, one step per call, on 1 to N threads; one thread runs
+// without a pool.
+DX_BENCH(WaveStep)
+{
+	for (const int size : { 256, 1024, 2048 })
+	{
+		for (const unsigned threads : GetThreadCounts())
+		{
+			DX::ThreadPool pool(threads);
+			auto waves = MakeWaves(size);
+			if (threads > 1) waves->SetThreadPool(&pool);
+
+			char label[64];
+			std::snprintf(label, sizeof(label), "%dx%d, %u thread(s)", size, size, threads);
+			DX::Bench::Report(label, MeasureMcellsPerSecond(*waves), "Mcells/s");
+		}
+	}
+}
+
+// Temporal blocking at 0 to 8 steps per block on grids past L2, single
+// thread. SetStepsPerBatch takes 0 as 1, the unblocked sweep; each call
+// runs one full block.
+DX_BENCH(WaveTemporalBlocking)
+{
+	for (const int size : { 1024, 2048 })
+	{
+		for (std::uint32_t stepsPerBlock = 0; stepsPerBlock <= 8; ++stepsPerBlock)
+		{
+			auto waves = MakeWaves(size);
+			waves->SetStepsPerBatch(stepsPerBlock);
+
+			char label[64];
+			std::snprintf(label, sizeof(label), "%dx%d, %u steps per block", size, size, stepsPerBlock);
+			DX::Bench::Report(label, MeasureMcellsPerSecond(*waves, waves->GetStepsPerBatch()), "Mcells/s");
+		}
+	}
+}
+
+// fp16 and int16 storage against fp32 on a 1024x1024 grid: sweep speed,
+// and height error after running the same drops for 300 steps.
+DX_BENCH(WaveStorageFormats)
+{
+	constexpr int SIZE = 1024;
+	constexpr uint32_t STEP_COUNT = 300;
+
+	const auto run = [](CpuWaves& waves)
+	{
+		std::uint32_t state = 2463534242u;
+		for (uint32_t step = 0; step < STEP_COUNT; ++step)
+		{
+			if (step % 10 == 0)
+			{
+				state = state * 1664525u + 1013904223u;
+				waves.Disturb(8 + (state >> 8) % (SIZE - 16), 8 + (state >> 20) % (SIZE - 16), 1.0f);
+			}
+			waves.Step();
+		}
+	};
+
+	CpuWaves reference(SIZE, SIZE, 0.25f, 0.03f, 2.0f, 0.2f);
+	run(reference);
+
+	float peak = 0.0f;
+	std::vector<float> expected(SIZE), actual(SIZE);
+	for (uint32_t i = 0; i < SIZE; ++i)
+	{
+		reference.GetSolutionRow(i, expected.data());
+		for (const float height : expected) peak = std::max(peak, std::abs(height));
+	}
+	DX::Bench::Report("peak |height|, fp32", peak, "");
+
+	for (const auto storage : { DX::WaveStorage::Float32, DX::WaveStorage::Float16, DX::WaveStorage::Int16 })
+	{
+		const char* name = storage == DX::WaveStorage::Float32 ? "fp32" : storage == DX::WaveStorage::Float16 ? "fp16" : "int16";
+		CpuWaves waves(SIZE, SIZE, 0.25f, 0.03f, 2.0f, 0.2f, storage);
+		char label[64];
+
+		std::snprintf(label, sizeof(label), "%s, dense step", name);
+		DX::Bench::Report(label, MeasureMcellsPerSecond(waves), "Mcells/s");
+		if (storage == DX::WaveStorage::Float32) continue;
+
+		CpuWaves compared(SIZE, SIZE, 0.25f, 0.03f, 2.0f, 0.2f, storage);
+		run(compared);
+
+		double maxError = 0.0;
+		double sumSquares = 0.0;
+		for (uint32_t i = 0; i < SIZE; ++i)
+		{
+			reference.GetSolutionRow(i, expected.data());
+			compared.GetSolutionRow(i, actual.data());
+			for (int j = 0; j < SIZE; ++j)
+			{
+				const double error = std::abs(static_cast<double>(actual[j]) - expected[j]);
+				maxError = std::max(maxError, error);
+				sumSquares += error * error;
+			}
+		}
+
+		std::snprintf(label, sizeof(label), "%s, max |error| vs fp32", name);
+		DX::Bench::Report(label, maxError * 1e3, "x 1e-3");
+		std::snprintf(label, sizeof(label), "%s, RMS error vs fp32", name);
+		DX::Bench::Report(label, std::sqrt(sumSquares / (static_cast<double>(SIZE) * SIZE)) * 1e3, "x 1e-3");
+	}
+}
@@ -0,0 +1,47 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace
+{
+	DX::CpuFeatures DetectCpuFeatures()
+	{
+		DX::CpuFeatures features;
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return features;
+
+		// AVX needs OSXSAVE to read which register state the OS saves.
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return features;
+		const bool f16c = (info[2] & (1 << 29)) != 0;
+		const unsigned long long xcr0 = _xgetbv(0);
+
+		__cpuidex(info, 7, 0);
+		features.Avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+		features.F16c = f16c && (xcr0 & 0x06) == 0x06;
+		features.Avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		features.Avx2 = __builtin_cpu_supports("avx2");
+		features.Avx512 = __builtin_cpu_supports("avx512f");
+
+		// No __builtin_cpu_supports name for F16C; CPUID.1:ECX bit 29.
+		unsigned int eax, ebx, ecx, edx;
+		__asm__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+		features.F16c = features.Avx2 && (ecx & (1u << 29)) != 0;
+#endif
+
+		return features;
+	}
+}
+
+const DX::CpuFeatures& DX::GetCpuFeatures()
+{
+	static const CpuFeatures features = DetectCpuFeatures();
+	return features;
+}
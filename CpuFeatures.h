@@ -0,0 +1,17 @@
+#pragma once
+
+namespace DX
+{
+	// Instruction sets that both the processor and the operating system
+	// support. Code built with /arch:AVX2 or /arch:AVX512 lives in its own
+	// translation units (the *Avx2.cpp and *Avx512.cpp files) and is only
+	// called once these report the matching set.
+	struct CpuFeatures
+	{
+		bool Avx2 = false;
+		bool F16c = false;
+		bool Avx512 = false;
+	};
+
+	[[nodiscard]] const CpuFeatures& GetCpuFeatures();
+}
@@ -0,0 +1,694 @@
+#include "CpuWaves.h"
+#include "CpuFeatures.h"
+#include "CpuWavesKernels.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_WAVES_SSE2
+#endif
+
+namespace
+{
+	using DX::CpuWavesKernels::Kernels;
+
+	// The AVX2 row kernels when both the processor and the build have them.
+	const Kernels* SelectAvx2Kernels()
+	{
+		return DX::GetCpuFeatures().Avx2 ? DX::CpuWavesKernels::GetAvx2Kernels() : nullptr;
+	}
+
+	const Kernels* const gAvx2Kernels = SelectAvx2Kernels();
+	const auto gAvx2HalfRow = gAvx2Kernels != nullptr && DX::GetCpuFeatures().F16c ? gAvx2Kernels->StencilRowHalf : nullptr;
+
+	std::uint16_t EncodeInt16(const float height, const float invScale)
+	{
+		const float q = std::min(std::max(height * invScale, -32768.0f), 32767.0f);
+		return static_cast<std::uint16_t>(static_cast<std::int16_t>(std::nearbyint(q)));
+	}
+
+	float DecodeInt16(const std::uint16_t value, const float scale)
+	{
+		return static_cast<float>(static_cast<std::int16_t>(value)) * scale;
+	}
+}
+
+DX::CpuWaves::CpuWaves(const int m, const int n, const float dx, const float dt, const float speed, const float damping,
+	const WaveStorage storage, const float heightRange) :
+	mNumRows(m),
+	mNumCols(n),
+	mVertexCount(m * n),
+	mTriangleCount((m - 1) * (n - 1) * 2),
+	mRowPitch((static_cast<size_t>(n) + 2 + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT),
+	mTimeStep(dt),
+	mSpatialStep(dx),
+	mClock(dt),
+	mStorage(storage)
+{
+	assert(m > 0 && n > 0);
+	assert(heightRange > 0.0f);
+
+	const float d = damping * dt + 2.0f;
+	const float e = (speed * speed) * (dt * dt) / (dx * dx);
+	mSimulationConstants[0] = (damping * dt - 2.0f) / d;
+	mSimulationConstants[1] = (4.0f - 8.0f * e) / d;
+	mSimulationConstants[2] = (2.0f * e) / d;
+
+	// One extra row above and below the grid, at least one extra column left
+	// and right. Columns past the right border are padding and stay zero too.
+	// Zero encodes as 0 in every storage mode.
+	const size_t planeSize = (static_cast<size_t>(m) + 2) * mRowPitch;
+	size_t elementSize = sizeof(float);
+	if (mStorage == WaveStorage::Float32)
+	{
+		mPrevSol.assign(planeSize, 0.0f);
+		mCurrSol.assign(planeSize, 0.0f);
+		mNextSol.assign(planeSize, 0.0f);
+	}
+	else
+	{
+		mPrevPacked.assign(planeSize, 0);
+		mCurrPacked.assign(planeSize, 0);
+		mNextPacked.assign(planeSize, 0);
+		elementSize = sizeof(std::uint16_t);
+	}
+
+	if (mStorage == WaveStorage::Int16)
+	{
+		mHeightScale = heightRange / 32767.0f;
+		mInvHeightScale = 32767.0f / heightRange;
+	}
+
+	// prev, curr and next rows of a tile should fit in L2 together.
+	const size_t rowBytes = mRowPitch * elementSize;
+	const auto l2Rows = static_cast<uint32>(L2_CACHE_BYTES / (3 * rowBytes));
+	mTileRows = std::min(std::max(l2Rows, MIN_TILE_ROWS), mNumRows);
+}
+
+const float* DX::CpuWaves::GetSolution() const
+{
+	assert(mStorage == WaveStorage::Float32);
+	return &mCurrSol[Index(0, 0)];
+}
+
+const float* DX::CpuWaves::GetPrevSolution() const
+{
+	assert(mStorage == WaveStorage::Float32);
+	return &mPrevSol[Index(0, 0)];
+}
+
+float DX::CpuWaves::GetHeight(const uint32 i, const uint32 j) const
+{
+	switch (mStorage)
+	{
+	case WaveStorage::Float16:
+		return HalfToFloat(mCurrPacked[Index(i, j)]);
+	case WaveStorage::Int16:
+		return DecodeInt16(mCurrPacked[Index(i, j)], mHeightScale);
+	default:
+		return mCurrSol[Index(i, j)];
+	}
+}
+
+void DX::CpuWaves::GetSolutionRow(const uint32 i, float* heights) const
+{
+	DecodeRow(mCurrSol, mCurrPacked, i, heights);
+}
+
+void DX::CpuWaves::GetPrevSolutionRow(const uint32 i, float* heights) const
+{
+	DecodeRow(mPrevSol, mPrevPacked, i, heights);
+}
+
+void DX::CpuWaves::DecodeRow(const std::vector<float>& plane, const std::vector<std::uint16_t>& packedPlane,
+	const uint32 i, float* heights) const
+{
+	const size_t index = Index(i, 0);
+
+	switch (mStorage)
+	{
+	case WaveStorage::Float16:
+		std::transform(&packedPlane[index], &packedPlane[index] + mNumCols, heights, HalfToFloat);
+		break;
+	case WaveStorage::Int16:
+		std::transform(&packedPlane[index], &packedPlane[index] + mNumCols, heights,
+			[this](const std::uint16_t value) { return DecodeInt16(value, mHeightScale); });
+		break;
+	default:
+		std::copy_n(&plane[index], mNumCols, heights);
+		break;
+	}
+}
+
+void DX::CpuWaves::SetStepsPerBatch(const uint32 steps)
+{
+	assert(mStorage == WaveStorage::Float32 || steps <= 1);
+	mStepsPerBatch = std::clamp(steps, 1u, MAX_STEPS_PER_BATCH);
+
+	if (mStepsPerBatch > 1 && mBlockSol.empty())
+	{
+		mBlockSol.assign(mCurrSol.size(), 0.0f);
+	}
+}
+
+void DX::CpuWaves::SetActiveThreshold(const float threshold)
+{
+	assert(mStorage == WaveStorage::Float32 || threshold <= 0.0f);
+	mActiveThreshold = std::max(threshold, 0.0f);
+	mActiveTiles.clear();
+
+	if (mActiveThreshold == 0.0f)
+	{
+		mTileAwake.clear();
+		mTileLevels.clear();
+		return;
+	}
+
+	mActiveTileRows = (mNumRows + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+	mActiveTileCols = (mNumCols + ACTIVE_TILE_SIZE - 1) / ACTIVE_TILE_SIZE;
+
+	// Everything starts awake; tiles that are already quiet fall asleep after one step.
+	const size_t tileCount = static_cast<size_t>(mActiveTileRows) * mActiveTileCols;
+	mTileAwake.assign(tileCount, 1);
+	mTileLevels.assign(tileCount, 0.0f);
+}
+
+void DX::CpuWaves::Update(const GameTimer& gameTimer)
+{
+	DX_PROFILE_ZONE("CpuWaves::Update");
+	Step(mClock.Advance(gameTimer.DeltaTime()));
+}
+
+void DX::CpuWaves::Step(uint32 stepCount)
+{
+	mStepCount += stepCount;
+
+	if (mStorage != WaveStorage::Float32)
+	{
+		for (; stepCount > 0; --stepCount)
+		{
+			StepTilesPacked();
+		}
+		return;
+	}
+
+	if (mActiveThreshold > 0.0f)
+	{
+		for (; stepCount > 0; --stepCount)
+		{
+			StepActiveTiles();
+		}
+		return;
+	}
+
+	while (stepCount > 0)
+	{
+		const uint32 steps = std::min(stepCount, mStepsPerBatch);
+		if (steps == 1)
+		{
+			StepTiles();
+		}
+		else
+		{
+			StepTilesBlocked(steps);
+		}
+		stepCount -= steps;
+	}
+}
+
+void DX::CpuWaves::StepTiles()
+{
+	ForEachTile([this](const uint32 tile)
+	{
+		const uint32 first = tile * mTileRows;
+		const uint32 rowCount = std::min(mTileRows, mNumRows - first);
+		const size_t offset = Index(first, 0);
+
+		StencilRows(&mPrevSol[offset], &mCurrSol[offset], &mNextSol[offset], rowCount);
+	});
+
+	// Same rotation as the GPU path, the vectors only exchange their buffers.
+	std::swap(mPrevSol, mCurrSol);
+	std::swap(mCurrSol, mNextSol);
+}
+
+void DX::CpuWaves::StepTilesPacked()
+{
+	const bool simd = mKernel == Kernel::Simd;
+	const PackedStencilRow stencilRow = mStorage == WaveStorage::Float16 ?
+		(simd ? StencilRowHalfSimd : StencilRowHalfScalar) :
+		(simd ? StencilRowInt16Simd : StencilRowInt16Scalar);
+
+	ForEachTile([this, stencilRow](const uint32 tile)
+	{
+		const uint32 first = tile * mTileRows;
+		const uint32 last = std::min(first + mTileRows, mNumRows);
+
+		for (uint32 i = first; i < last; ++i)
+		{
+			const size_t offset = Index(i, 0);
+			stencilRow(&mPrevPacked[offset], &mCurrPacked[offset], &mNextPacked[offset],
+				mNumCols, mRowPitch, mSimulationConstants, mHeightScale, mInvHeightScale);
+		}
+	});
+
+	std::swap(mPrevPacked, mCurrPacked);
+	std::swap(mCurrPacked, mNextPacked);
+}
+
+void DX::CpuWaves::StepTilesBlocked(const uint32 stepCount)
+{
+	// Tiles read prev/curr and write the solutions of the last two steps of
+	// the batch into next/block, so they never see each other's output.
+	ForEachTile([this, stepCount](const uint32 tile)
+	{
+		StepTileBlocked(tile, stepCount);
+	});
+
+	std::swap(mPrevSol, mNextSol);
+	std::swap(mCurrSol, mBlockSol);
+}
+
+void DX::CpuWaves::StepTileBlocked(const uint32 tile, const uint32 stepCount)
+{
+	// Rows [first, last) are owned by the tile, [haloFirst, haloLast) are
+	// copied. Every fused step invalidates one more halo row on each side
+	// that borders another tile; sides on the grid edge see the zero border.
+	const uint32 first = tile * mTileRows;
+	const uint32 last = std::min(first + mTileRows, mNumRows);
+	const uint32 haloFirst = first > stepCount ? first - stepCount : 0;
+	const uint32 haloLast = std::min(last + stepCount, mNumRows);
+	const uint32 localRows = haloLast - haloFirst;
+
+	// Local planes keep the layout of the global ones, pad rows included.
+	// Every plane starts on a row boundary and only interior columns are
+	// ever written, so the border columns stay zero across reuses and only
+	// the pad rows need clearing.
+	const size_t planeSize = (static_cast<size_t>(localRows) + 2) * mRowPitch;
+	thread_local std::vector<float> scratch;
+	thread_local size_t scratchPitch = 0;
+	if (scratchPitch != mRowPitch)
+	{
+		scratch.assign(3 * planeSize, 0.0f);
+		scratchPitch = mRowPitch;
+	}
+	else if (scratch.size() < 3 * planeSize)
+	{
+		scratch.resize(3 * planeSize, 0.0f);
+	}
+
+	float* prev = scratch.data();
+	float* curr = prev + planeSize;
+	float* next = curr + planeSize;
+
+	for (float* plane : { prev, curr, next })
+	{
+		std::fill_n(plane, mRowPitch, 0.0f);
+		std::fill_n(plane + planeSize - mRowPitch, mRowPitch, 0.0f);
+	}
+
+	const size_t haloOffset = Index(haloFirst, 0) - 1;
+	std::copy_n(&mPrevSol[haloOffset], localRows * mRowPitch, prev + mRowPitch);
+	std::copy_n(&mCurrSol[haloOffset], localRows * mRowPitch, curr + mRowPitch);
+
+	for (uint32 step = 1; step <= stepCount; ++step)
+	{
+		const uint32 lo = haloFirst == 0 ? 0 : step;
+		const uint32 hi = haloLast == mNumRows ? localRows : localRows - step;
+		const size_t offset = (static_cast<size_t>(lo) + 1) * mRowPitch + 1;
+
+		StencilRows(prev + offset, curr + offset, next + offset, hi - lo);
+
+		float* oldPrev = prev;
+		prev = curr;
+		curr = next;
+		next = oldPrev;
+	}
+
+	const size_t localOffset = (static_cast<size_t>(first - haloFirst) + 1) * mRowPitch;
+	const size_t globalOffset = Index(first, 0) - 1;
+	const size_t ownedSize = (last - first) * mRowPitch;
+	std::copy_n(prev + localOffset, ownedSize, &mNextSol[globalOffset]);
+	std::copy_n(curr + localOffset, ownedSize, &mBlockSol[globalOffset]);
+}
+
+void DX::CpuWaves::StepActiveTiles()
+{
+	// Step every tile that is awake or borders an awake tile.
+	mActiveTiles.clear();
+	for (uint32 ty = 0; ty < mActiveTileRows; ++ty)
+	{
+		for (uint32 tx = 0; tx < mActiveTileCols; ++tx)
+		{
+			const uint32 y0 = ty > 0 ? ty - 1 : 0;
+			const uint32 y1 = std::min(ty + 1, mActiveTileRows - 1);
+			const uint32 x0 = tx > 0 ? tx - 1 : 0;
+			const uint32 x1 = std::min(tx + 1, mActiveTileCols - 1);
+
+			bool active = false;
+			for (uint32 y = y0; y <= y1 && !active; ++y)
+			{
+				for (uint32 x = x0; x <= x1 && !active; ++x)
+				{
+					active = mTileAwake[y * mActiveTileCols + x] != 0;
+				}
+			}
+
+			if (active) mActiveTiles.push_back(ty * mActiveTileCols + tx);
+		}
+	}
+
+	const auto stencilRow = mKernel == Kernel::Simd ? StencilRowSimd : StencilRowScalar;
+
+	ForEach(static_cast<uint32>(mActiveTiles.size()), [this, stencilRow](const uint32 k)
+	{
+		const uint32 tile = mActiveTiles[k];
+		const uint32 first = tile / mActiveTileCols * ACTIVE_TILE_SIZE;
+		const uint32 last = std::min(first + ACTIVE_TILE_SIZE, mNumRows);
+		const uint32 left = tile % mActiveTileCols * ACTIVE_TILE_SIZE;
+		const uint32 width = std::min(ACTIVE_TILE_SIZE, mNumCols - left);
+
+		// Largest height of the new curr and prev, the two planes the next step reads.
+		float level = 0.0f;
+		for (uint32 i = first; i < last; ++i)
+		{
+			const size_t offset = Index(i, left);
+			stencilRow(&mPrevSol[offset], &mCurrSol[offset], &mNextSol[offset], width, mRowPitch, mSimulationConstants);
+
+			for (uint32 j = 0; j < width; ++j)
+			{
+				level = std::max(level, std::max(std::abs(mNextSol[offset + j]), std::abs(mCurrSol[offset + j])));
+			}
+		}
+		mTileLevels[tile] = level;
+	});
+
+	std::swap(mPrevSol, mCurrSol);
+	std::swap(mCurrSol, mNextSol);
+
+	// Skipped tiles must read as zero in every plane, so a tile going to
+	// sleep drops whatever is left below the threshold.
+	for (const uint32 tile : mActiveTiles)
+	{
+		mTileAwake[tile] = mTileLevels[tile] >= mActiveThreshold ? 1 : 0;
+	}
+
+	ForEach(static_cast<uint32>(mActiveTiles.size()), [this](const uint32 k)
+	{
+		const uint32 tile = mActiveTiles[k];
+		if (mTileAwake[tile] == 0) ClearTile(tile);
+	});
+}
+
+void DX::CpuWaves::ForEachTile(const std::function<void(uint32)>& body) const
+{
+	ForEach(GetTileCount(), body);
+}
+
+void DX::CpuWaves::ForEach(const uint32 count, const std::function<void(uint32)>& body) const
+{
+	if (mThreadPool != nullptr)
+	{
+		mThreadPool->ParallelFor(count, body);
+		return;
+	}
+
+	for (uint32 index = 0; index < count; ++index)
+	{
+		body(index);
+	}
+}
+
+void DX::CpuWaves::WakeTile(const uint32 i, const uint32 j)
+{
+	if (mActiveThreshold == 0.0f) return;
+
+	mTileAwake[i / ACTIVE_TILE_SIZE * mActiveTileCols + j / ACTIVE_TILE_SIZE] = 1;
+}
+
+void DX::CpuWaves::AddHeight(const size_t index, const float delta)
+{
+	switch (mStorage)
+	{
+	case WaveStorage::Float16:
+		mCurrPacked[index] = FloatToHalf(HalfToFloat(mCurrPacked[index]) + delta);
+		break;
+	case WaveStorage::Int16:
+		mCurrPacked[index] = EncodeInt16(DecodeInt16(mCurrPacked[index], mHeightScale) + delta, mInvHeightScale);
+		break;
+	default:
+		mCurrSol[index] += delta;
+		break;
+	}
+}
+
+void DX::CpuWaves::ClearTile(const uint32 tile)
+{
+	const uint32 first = tile / mActiveTileCols * ACTIVE_TILE_SIZE;
+	const uint32 last = std::min(first + ACTIVE_TILE_SIZE, mNumRows);
+	const uint32 left = tile % mActiveTileCols * ACTIVE_TILE_SIZE;
+	const uint32 width = std::min(ACTIVE_TILE_SIZE, mNumCols - left);
+
+	for (uint32 i = first; i < last; ++i)
+	{
+		const size_t offset = Index(i, left);
+		std::fill_n(&mPrevSol[offset], width, 0.0f);
+		std::fill_n(&mCurrSol[offset], width, 0.0f);
+		std::fill_n(&mNextSol[offset], width, 0.0f);
+	}
+}
+
+void DX::CpuWaves::StencilRows(const float* prev, const float* curr, float* next, const uint32 rowCount) const
+{
+	const auto stencilRow = mKernel == Kernel::Simd ? StencilRowSimd : StencilRowScalar;
+
+	for (uint32 row = 0; row < rowCount; ++row)
+	{
+		const size_t offset = row * mRowPitch;
+		stencilRow(prev + offset, curr + offset, next + offset, mNumCols, mRowPitch, mSimulationConstants);
+	}
+}
+
+void DX::CpuWaves::Disturb(const uint32 i, const uint32 j, const float magnitude)
+{
+	assert(i < mNumRows && j < mNumCols);
+
+	// Writes that fall outside the grid are dropped like out-of-bounds UAV
+	// writes are, which also keeps the zero border intact.
+	const float halfMag = 0.5f * magnitude;
+
+	// The footprint reaches at most one cell into a neighbouring tile, which
+	// is stepped as part of the border around this one.
+	WakeTile(i, j);
+
+	AddHeight(Index(i, j), magnitude);
+	if (j + 1 < mNumCols) AddHeight(Index(i, j + 1), halfMag);
+	if (j > 0)            AddHeight(Index(i, j - 1), halfMag);
+	if (i + 1 < mNumRows) AddHeight(Index(i + 1, j), halfMag);
+	if (i > 0)            AddHeight(Index(i - 1, j), halfMag);
+}
+
+void DX::CpuWaves::DisturbBatch(const WaveDisturbance* disturbances, const size_t count)
+{
+	// One thread has no write conflicts to avoid, so the footprints are
+	// scattered straight into the plane in drop order, which also gives the
+	// same bits as a Disturb loop. Merging them first, as Waves does so GPU
+	// threads never share a cell, costs more than it saves here. Cells
+	// outside the grid are dropped like CompactDisturbances drops them.
+	const auto scatter = [this, disturbances, count](auto&& addHeight)
+	{
+		const auto addHit = [this, &addHeight](const std::int64_t i, const std::int64_t j, const float delta)
+		{
+			if (i < 0 || j < 0 || i >= mNumRows || j >= mNumCols) return;
+
+			const auto row = static_cast<uint32>(i);
+			const auto col = static_cast<uint32>(j);
+			WakeTile(row, col);
+			addHeight(Index(row, col), delta);
+		};
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			const std::int64_t i = disturbances[k].Row;
+			const std::int64_t j = disturbances[k].Col;
+			const float magnitude = disturbances[k].Magnitude;
+			const float halfMag = 0.5f * magnitude;
+
+			addHit(i, j, magnitude);
+			addHit(i, j + 1, halfMag);
+			addHit(i, j - 1, halfMag);
+			addHit(i + 1, j, halfMag);
+			addHit(i - 1, j, halfMag);
+		}
+	};
+
+	if (mStorage == WaveStorage::Float32)
+	{
+		float* plane = mCurrSol.data();
+		scatter([plane](const size_t index, const float delta) { plane[index] += delta; });
+	}
+	else
+	{
+		scatter([this](const size_t index, const float delta) { AddHeight(index, delta); });
+	}
+}
+
+void DX::CpuWaves::Capture(WaveSnapshot& snapshot) const
+{
+	snapshot.Rows = mNumRows;
+	snapshot.Cols = mNumCols;
+	snapshot.Storage = mStorage;
+	snapshot.HeightScale = mHeightScale;
+	std::copy_n(mSimulationConstants, 3, snapshot.SimulationConstants);
+	snapshot.TimeStep = mTimeStep;
+	snapshot.SpatialStep = mSpatialStep;
+	snapshot.StepCount = mStepCount;
+
+	snapshot.PrevPlane.resize(snapshot.GetPlaneSize());
+	snapshot.CurrPlane.resize(snapshot.GetPlaneSize());
+
+	const size_t rowBytes = mNumCols * snapshot.GetElementSize();
+	for (uint32 i = 0; i < mNumRows; ++i)
+	{
+		const size_t index = Index(i, 0);
+		const auto* prev = mStorage == WaveStorage::Float32 ?
+			reinterpret_cast<const std::uint8_t*>(&mPrevSol[index]) : reinterpret_cast<const std::uint8_t*>(&mPrevPacked[index]);
+		const auto* curr = mStorage == WaveStorage::Float32 ?
+			reinterpret_cast<const std::uint8_t*>(&mCurrSol[index]) : reinterpret_cast<const std::uint8_t*>(&mCurrPacked[index]);
+
+		std::copy_n(prev, rowBytes, &snapshot.PrevPlane[i * rowBytes]);
+		std::copy_n(curr, rowBytes, &snapshot.CurrPlane[i * rowBytes]);
+	}
+}
+
+void DX::CpuWaves::Restore(const WaveSnapshot& snapshot)
+{
+	assert(snapshot.Rows == mNumRows && snapshot.Cols == mNumCols && snapshot.Storage == mStorage);
+	assert(snapshot.PrevPlane.size() == snapshot.GetPlaneSize() && snapshot.CurrPlane.size() == snapshot.GetPlaneSize());
+
+	const size_t rowBytes = mNumCols * snapshot.GetElementSize();
+	for (uint32 i = 0; i < mNumRows; ++i)
+	{
+		const size_t index = Index(i, 0);
+		auto* prev = mStorage == WaveStorage::Float32 ?
+			reinterpret_cast<std::uint8_t*>(&mPrevSol[index]) : reinterpret_cast<std::uint8_t*>(&mPrevPacked[index]);
+		auto* curr = mStorage == WaveStorage::Float32 ?
+			reinterpret_cast<std::uint8_t*>(&mCurrSol[index]) : reinterpret_cast<std::uint8_t*>(&mCurrPacked[index]);
+
+		std::copy_n(&snapshot.PrevPlane[i * rowBytes], rowBytes, prev);
+		std::copy_n(&snapshot.CurrPlane[i * rowBytes], rowBytes, curr);
+	}
+
+	mStepCount = snapshot.StepCount;
+
+	// Sleeping tiles are exactly zero, so waking all of them steps the same
+	// values the original run did and they fall back asleep on their own.
+	std::fill(mTileAwake.begin(), mTileAwake.end(), std::uint8_t{ 1 });
+}
+
+// Both kernels evaluate the sum in the order wavesUpdateCS.hlsl does:
+//   k0 * prev + k1 * curr + k2 * (((down + up) + right) + left)
+// so that the SIMD path reproduces the scalar path bit for bit.
+void DX::CpuWaves::StencilRowScalar(const float* prev, const float* curr, float* next,
+	const size_t count, const size_t pitch, const float* k)
+{
+	for (size_t x = 0; x < count; ++x)
+	{
+		const float neighbours = curr[x + pitch] + curr[x - pitch] + curr[x + 1] + curr[x - 1];
+		next[x] = k[0] * prev[x] + k[1] * curr[x] + k[2] * neighbours;
+	}
+}
+
+void DX::CpuWaves::StencilRowSimd(const float* prev, const float* curr, float* next,
+	const size_t count, const size_t pitch, const float* k)
+{
+	size_t x = 0;
+
+	if (gAvx2Kernels != nullptr)
+	{
+		x = gAvx2Kernels->StencilRow(prev, curr, next, count, pitch, k);
+	}
+#if defined(CPU_WAVES_SSE2)
+	else
+	{
+		const __m128 k0 = _mm_set1_ps(k[0]);
+		const __m128 k1 = _mm_set1_ps(k[1]);
+		const __m128 k2 = _mm_set1_ps(k[2]);
+
+		for (; x + 4 <= count; x += 4)
+		{
+			__m128 neighbours = _mm_add_ps(
+				_mm_loadu_ps(curr + x + pitch), _mm_loadu_ps(curr + x - pitch));
+			neighbours = _mm_add_ps(neighbours, _mm_loadu_ps(curr + x + 1));
+			neighbours = _mm_add_ps(neighbours, _mm_loadu_ps(curr + x - 1));
+
+			__m128 result = _mm_add_ps(
+				_mm_mul_ps(k0, _mm_loadu_ps(prev + x)),
+				_mm_mul_ps(k1, _mm_loadu_ps(curr + x)));
+			result = _mm_add_ps(result, _mm_mul_ps(k2, neighbours));
+
+			_mm_storeu_ps(next + x, result);
+		}
+	}
+#endif
+
+	// Remainder, and the whole row on targets without SIMD.
+	StencilRowScalar(prev + x, curr + x, next + x, count - x, pitch, k);
+}
+
+// The packed kernels run the same fp32 expression as the float ones, so
+// each SIMD path matches its scalar path bit for bit.
+void DX::CpuWaves::StencilRowHalfScalar(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+	const size_t count, const size_t pitch, const float* k, float, float)
+{
+	for (size_t x = 0; x < count; ++x)
+	{
+		const float neighbours = HalfToFloat(curr[x + pitch]) + HalfToFloat(curr[x - pitch]) +
+			HalfToFloat(curr[x + 1]) + HalfToFloat(curr[x - 1]);
+		next[x] = FloatToHalf(k[0] * HalfToFloat(prev[x]) + k[1] * HalfToFloat(curr[x]) + k[2] * neighbours);
+	}
+}
+
+void DX::CpuWaves::StencilRowHalfSimd(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+	const size_t count, const size_t pitch, const float* k, const float scale, const float invScale)
+{
+	size_t x = 0;
+
+	if (gAvx2HalfRow != nullptr)
+	{
+		x = gAvx2HalfRow(prev, curr, next, count, pitch, k);
+	}
+
+	StencilRowHalfScalar(prev + x, curr + x, next + x, count - x, pitch, k, scale, invScale);
+}
+
+void DX::CpuWaves::StencilRowInt16Scalar(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+	const size_t count, const size_t pitch, const float* k, const float scale, const float invScale)
+{
+	for (size_t x = 0; x < count; ++x)
+	{
+		const float neighbours = DecodeInt16(curr[x + pitch], scale) + DecodeInt16(curr[x - pitch], scale) +
+			DecodeInt16(curr[x + 1], scale) + DecodeInt16(curr[x - 1], scale);
+		const float height = k[0] * DecodeInt16(prev[x], scale) + k[1] * DecodeInt16(curr[x], scale) + k[2] * neighbours;
+		next[x] = EncodeInt16(height, invScale);
+	}
+}
+
+void DX::CpuWaves::StencilRowInt16Simd(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+	const size_t count, const size_t pitch, const float* k, const float scale, const float invScale)
+{
+	size_t x = 0;
+
+	if (gAvx2Kernels != nullptr)
+	{
+		x = gAvx2Kernels->StencilRowInt16(prev, curr, next, count, pitch, k, scale, invScale);
+	}
+
+	StencilRowInt16Scalar(prev + x, curr + x, next + x, count - x, pitch, k, scale, invScale);
+}
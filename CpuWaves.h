@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "FixedStepClock.h"
+#include "GameTimer.h"
+#include "ThreadPool.h"
+#include "WaveDisturbance.h"
+#include "WaveSnapshot.h"
+#include "WaveStorage.h"
+
+namespace DX
+{
+	/**
+	 * \brief CPU counterpart of Waves, for machines without a D3D12 device.
+	 * Runs the same three-coefficient update as wavesUpdateCS.hlsl. Every
+	 * solution plane keeps a one-cell zero border so the stencil never
+	 * branches, and cells outside the grid read as 0 just like out-of-bounds
+	 * UAV loads do on the GPU. Any grid size works; the row pitch is padded
+	 * to a multiple of ROW_ALIGNMENT cells so rows start on a fixed stride.
+	 *
+	 * The grid is swept in blocks of rows sized to stay in L2. Several steps
+	 * can be fused per block (temporal blocking): a block copies its rows
+	 * plus a halo of one row per fused step, advances them locally and
+	 * writes back only the rows it owns, which are exact after the batch.
+	 *
+	 * With an activity threshold set, the grid is instead split into square
+	 * tiles and only awake tiles plus a one-tile border are stepped. A tile
+	 * falls asleep once no height in it reaches the threshold, at which point
+	 * it is cleared to exactly zero; waves travel one cell per step, so a
+	 * sleeping tile only needs stepping again once a neighbour is awake.
+	 *
+	 * Heights can also be kept as fp16 or as int16 fixed point. The packed
+	 * planes are swept tile by tile like fp32 ones, converting to fp32 on
+	 * load and back on store; temporal blocking and active tiles need fp32.
+	 */
+	class CpuWaves
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+
+		enum class Kernel
+		{
+			Scalar,
+			Simd,
+		};
+
+		// heightRange is the largest |height| Int16 storage can hold, heights beyond it saturate.
+		CpuWaves(int m, int n, float dx, float dt, float speed, float damping,
+			WaveStorage storage = WaveStorage::Float32, float heightRange = 8.0f);
+		CpuWaves(const CpuWaves&) = delete;
+		CpuWaves(const CpuWaves&&) = delete;
+		CpuWaves& operator=(const CpuWaves&) = delete;
+		CpuWaves& operator=(const CpuWaves&&) = delete;
+		~CpuWaves() = default;
+
+		[[nodiscard]] auto GetRowCount()      const { return mNumRows; }
+		[[nodiscard]] auto GetColumnCount()   const { return mNumCols; }
+		[[nodiscard]] auto GetVertexCount()   const { return mVertexCount; }
+		[[nodiscard]] auto GetTriangleCount() const { return mTriangleCount; }
+		[[nodiscard]] auto GetWidth()         const { return static_cast<float>(mNumCols) * mSpatialStep; }
+		[[nodiscard]] auto GetDepth()         const { return static_cast<float>(mNumRows) * mSpatialStep; }
+		[[nodiscard]] auto GetSpatialStep()   const { return mSpatialStep; }
+		[[nodiscard]] auto GetTimeStep()      const { return mTimeStep; }
+		[[nodiscard]] auto GetKernel()        const { return mKernel; }
+		[[nodiscard]] auto GetStepsPerBatch() const { return mStepsPerBatch; }
+		[[nodiscard]] auto GetTileRowCount()  const { return mTileRows; }
+		[[nodiscard]] auto GetInterpolationAlpha() const { return mClock.GetAlpha(); }
+		[[nodiscard]] auto GetActiveThreshold() const { return mActiveThreshold; }
+		[[nodiscard]] auto GetStorage()       const { return mStorage; }
+		[[nodiscard]] auto GetStepCount()     const { return mStepCount; }
+
+		// Tiles stepped by the last update, border included.
+		[[nodiscard]] auto GetActiveTileCount() const { return static_cast<uint32>(mActiveTiles.size()); }
+
+		// Row i of the current solution starts at GetSolution() + i * GetRowPitch().
+		// Blend with GetPrevSolution() by GetInterpolationAlpha() for smooth motion.
+		// Only Float32 storage exposes its planes; GetHeight works for all of them.
+		[[nodiscard]] const float* GetSolution() const;
+		[[nodiscard]] const float* GetPrevSolution() const;
+		[[nodiscard]] size_t GetRowPitch()       const { return mRowPitch; }
+		[[nodiscard]] float GetHeight(uint32 i, uint32 j) const;
+
+		// Decode row i of the current or previous solution into GetColumnCount() floats.
+		void GetSolutionRow(uint32 i, float* heights) const;
+		void GetPrevSolutionRow(uint32 i, float* heights) const;
+
+		void SetKernel(Kernel kernel) { mKernel = kernel; }
+		void SetMaxSubsteps(uint32 maxSubsteps) { mClock.SetMaxSubsteps(maxSubsteps); }
+
+		// Tiles run on the pool when one is set, otherwise on the calling thread.
+		void SetThreadPool(ThreadPool* threadPool) { mThreadPool = threadPool; }
+		[[nodiscard]] ThreadPool* GetThreadPool() const { return mThreadPool; }
+
+		// Number of steps fused per sweep over a tile; 1 disables temporal blocking.
+		void SetStepsPerBatch(uint32 steps);
+
+		// Tiles whose heights all stay below threshold are put to sleep and
+		// skipped. 0 restores the dense sweep. Temporal blocking is not used
+		// while tiles are tracked.
+		void SetActiveThreshold(float threshold);
+
+		void Update(const GameTimer& gameTimer);
+
+		// Advances the simulation by exactly stepCount time steps.
+		void Step(uint32 stepCount = 1);
+
+		void Disturb(uint32 i, uint32 j, float magnitude);
+
+		// Same heights as calling Disturb for each drop in order, in one pass
+		// over the footprints. Drops may reach outside the grid; those cells
+		// are skipped.
+		void DisturbBatch(const WaveDisturbance* disturbances, size_t count);
+
+		// Restore expects a snapshot of a solver with the same size and
+		// storage; stepping on from it repeats the captured run exactly.
+		void Capture(WaveSnapshot& snapshot) const;
+		void Restore(const WaveSnapshot& snapshot);
+
+	private:
+		[[nodiscard]] size_t Index(uint32 i, uint32 j) const { return (i + 1) * mRowPitch + (j + 1); }
+		[[nodiscard]] uint32 GetTileCount() const { return (mNumRows + mTileRows - 1) / mTileRows; }
+
+		void StepTiles();
+		void StepTilesBlocked(uint32 stepCount);
+		void StepTileBlocked(uint32 tile, uint32 stepCount);
+		void StepActiveTiles();
+		void StepTilesPacked();
+		void ForEachTile(const std::function<void(uint32)>& body) const;
+		void ForEach(uint32 count, const std::function<void(uint32)>& body) const;
+
+		void WakeTile(uint32 i, uint32 j);
+		void ClearTile(uint32 tile);
+		void AddHeight(size_t index, float delta);
+		void DecodeRow(const std::vector<float>& plane, const std::vector<std::uint16_t>& packedPlane,
+			uint32 i, float* heights) const;
+
+		void StencilRows(const float* prev, const float* curr, float* next, uint32 rowCount) const;
+
+		static void StencilRowScalar(const float* prev, const float* curr, float* next,
+			size_t count, size_t pitch, const float* k);
+		static void StencilRowSimd(const float* prev, const float* curr, float* next,
+			size_t count, size_t pitch, const float* k);
+
+		// Packed rows, scale converts an int16 to a height and invScale back.
+		using PackedStencilRow = void (*)(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+			size_t count, size_t pitch, const float* k, float scale, float invScale);
+
+		static void StencilRowHalfScalar(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+			size_t count, size_t pitch, const float* k, float scale, float invScale);
+		static void StencilRowHalfSimd(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+			size_t count, size_t pitch, const float* k, float scale, float invScale);
+		static void StencilRowInt16Scalar(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+			size_t count, size_t pitch, const float* k, float scale, float invScale);
+		static void StencilRowInt16Simd(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+			size_t count, size_t pitch, const float* k, float scale, float invScale);
+
+	private:
+		uint32 mNumRows;
+		uint32 mNumCols;
+		uint32 mVertexCount;
+		uint32 mTriangleCount;
+		size_t mRowPitch;
+
+		float mSimulationConstants[3]{};
+		float mTimeStep;
+		float mSpatialStep;
+		FixedStepClock mClock;
+		std::uint64_t mStepCount = 0;
+
+		WaveStorage mStorage;
+		float mHeightScale = 1.0f;
+		float mInvHeightScale = 1.0f;
+
+		Kernel mKernel = Kernel::Simd;
+
+		// Budget for the planes a tile touches, a typical per-core L2.
+		static constexpr size_t L2_CACHE_BYTES = 256 * 1024;
+		static constexpr uint32 MIN_TILE_ROWS = 8;
+		static constexpr uint32 MAX_STEPS_PER_BATCH = 16;
+		static constexpr uint32 ACTIVE_TILE_SIZE = 64;
+		static constexpr size_t ROW_ALIGNMENT = 16;
+
+		uint32 mTileRows = MIN_TILE_ROWS;
+		uint32 mStepsPerBatch = 1;
+		ThreadPool* mThreadPool = nullptr;
+
+		std::vector<float> mPrevSol;
+		std::vector<float> mCurrSol;
+		std::vector<float> mNextSol;
+
+		// Second output plane for temporal blocking, which produces prev and curr at once.
+		std::vector<float> mBlockSol;
+
+		// Used instead of the float planes by the 16-bit storage modes.
+		std::vector<std::uint16_t> mPrevPacked;
+		std::vector<std::uint16_t> mCurrPacked;
+		std::vector<std::uint16_t> mNextPacked;
+
+		float mActiveThreshold = 0.0f;
+		uint32 mActiveTileRows = 0;
+		uint32 mActiveTileCols = 0;
+		std::vector<std::uint8_t> mTileAwake;
+		std::vector<float> mTileLevels;
+		std::vector<uint32> mActiveTiles;
+	};
+}
@@ -0,0 +1,118 @@
+#include "CpuWavesKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+	using std::uint16_t;
+
+	// k0 * prev + k1 * curr + k2 * (((down + up) + right) + left), as in wavesUpdateCS.hlsl.
+	size_t StencilRow(const float* prev, const float* curr, float* next,
+		const size_t count, const size_t pitch, const float* k)
+	{
+		const __m256 k0 = _mm256_set1_ps(k[0]);
+		const __m256 k1 = _mm256_set1_ps(k[1]);
+		const __m256 k2 = _mm256_set1_ps(k[2]);
+
+		size_t x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			__m256 neighbours = _mm256_add_ps(
+				_mm256_loadu_ps(curr + x + pitch), _mm256_loadu_ps(curr + x - pitch));
+			neighbours = _mm256_add_ps(neighbours, _mm256_loadu_ps(curr + x + 1));
+			neighbours = _mm256_add_ps(neighbours, _mm256_loadu_ps(curr + x - 1));
+
+			__m256 result = _mm256_add_ps(
+				_mm256_mul_ps(k0, _mm256_loadu_ps(prev + x)),
+				_mm256_mul_ps(k1, _mm256_loadu_ps(curr + x)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(k2, neighbours));
+
+			_mm256_storeu_ps(next + x, result);
+		}
+		return x;
+	}
+
+#if defined(__F16C__) || defined(_MSC_VER)
+	__m256 LoadHalf(const uint16_t* p)
+	{
+		return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+	}
+
+	size_t StencilRowHalf(const uint16_t* prev, const uint16_t* curr, uint16_t* next,
+		const size_t count, const size_t pitch, const float* k)
+	{
+		const __m256 k0 = _mm256_set1_ps(k[0]);
+		const __m256 k1 = _mm256_set1_ps(k[1]);
+		const __m256 k2 = _mm256_set1_ps(k[2]);
+
+		size_t x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			__m256 neighbours = _mm256_add_ps(LoadHalf(curr + x + pitch), LoadHalf(curr + x - pitch));
+			neighbours = _mm256_add_ps(neighbours, LoadHalf(curr + x + 1));
+			neighbours = _mm256_add_ps(neighbours, LoadHalf(curr + x - 1));
+
+			__m256 result = _mm256_add_ps(_mm256_mul_ps(k0, LoadHalf(prev + x)), _mm256_mul_ps(k1, LoadHalf(curr + x)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(k2, neighbours));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(next + x), _mm256_cvtps_ph(result, _MM_FROUND_TO_NEAREST_INT));
+		}
+		return x;
+	}
+#endif
+
+	__m256 LoadInt16(const uint16_t* p, const __m256 scales)
+	{
+		const __m256i widened = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		return _mm256_mul_ps(_mm256_cvtepi32_ps(widened), scales);
+	}
+
+	size_t StencilRowInt16(const uint16_t* prev, const uint16_t* curr, uint16_t* next,
+		const size_t count, const size_t pitch, const float* k, const float scale, const float invScale)
+	{
+		const __m256 k0 = _mm256_set1_ps(k[0]);
+		const __m256 k1 = _mm256_set1_ps(k[1]);
+		const __m256 k2 = _mm256_set1_ps(k[2]);
+		const __m256 scales = _mm256_set1_ps(scale);
+		const __m256 invScales = _mm256_set1_ps(invScale);
+		const __m256 lowest = _mm256_set1_ps(-32768.0f);
+		const __m256 highest = _mm256_set1_ps(32767.0f);
+
+		size_t x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			__m256 neighbours = _mm256_add_ps(LoadInt16(curr + x + pitch, scales), LoadInt16(curr + x - pitch, scales));
+			neighbours = _mm256_add_ps(neighbours, LoadInt16(curr + x + 1, scales));
+			neighbours = _mm256_add_ps(neighbours, LoadInt16(curr + x - 1, scales));
+
+			__m256 result = _mm256_add_ps(
+				_mm256_mul_ps(k0, LoadInt16(prev + x, scales)), _mm256_mul_ps(k1, LoadInt16(curr + x, scales)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(k2, neighbours));
+
+			// Clamp before converting so large heights saturate instead of wrapping.
+			result = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(result, invScales), lowest), highest);
+			const __m256i rounded = _mm256_cvtps_epi32(result);
+			const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(next + x), packed);
+		}
+		return x;
+	}
+}
+
+const DX::CpuWavesKernels::Kernels* DX::CpuWavesKernels::GetAvx2Kernels()
+{
+#if defined(__F16C__) || defined(_MSC_VER)
+	static constexpr Kernels KERNELS = { StencilRow, StencilRowHalf, StencilRowInt16 };
+#else
+	static constexpr Kernels KERNELS = { StencilRow, nullptr, StencilRowInt16 };
+#endif
+	return &KERNELS;
+}
+#else
+const DX::CpuWavesKernels::Kernels* DX::CpuWavesKernels::GetAvx2Kernels()
+{
+	return nullptr;
+}
+#endif
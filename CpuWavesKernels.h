@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+	namespace CpuWavesKernels
+	{
+		// Row kernels of CpuWaves built with AVX2 in CpuWavesAvx2.cpp. Each
+		// handles whole groups of eight cells and returns how many it did;
+		// CpuWaves finishes the row with its scalar kernels, which evaluate
+		// the same expressions in the same order. That only gives the same
+		// bits while the compiler keeps a*b+c as two roundings: every TU is
+		// built with /fp:precise and no /fp:contract, or -ffp-contract=off,
+		// since an FMA-capable target otherwise fuses the scalar side. This
+		// header declares only plain functions so that nothing inline gets
+		// compiled for AVX2.
+		struct Kernels
+		{
+			size_t (*StencilRow)(const float* prev, const float* curr, float* next,
+				size_t count, size_t pitch, const float* k);
+
+			// nullptr when the file was built without F16C.
+			size_t (*StencilRowHalf)(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+				size_t count, size_t pitch, const float* k);
+
+			size_t (*StencilRowInt16)(const std::uint16_t* prev, const std::uint16_t* curr, std::uint16_t* next,
+				size_t count, size_t pitch, const float* k, float scale, float invScale);
+		};
+
+		// nullptr when the file was built without AVX2. Only call these once
+		// GetCpuFeatures reports AVX2 (and F16C for StencilRowHalf).
+		const Kernels* GetAvx2Kernels();
+	}
+}
@@ -1,7 +1,23 @@
 #include "D3DApp.h"
+#include "Profiler.h"
 
+#include <fstream>
+#include <iomanip>
 #include <WindowsX.h>
 
+#if DX_PROFILER
+namespace
+{
+	// Written to the working directory on exit and on F9.
+	void ExportProfile()
+	{
+		DX::Profiler::WriteChromeTrace("Profile.json");
+		std::ofstream summary("Profile.txt");
+		DX::Profiler::WriteSummary(summary);
+	}
+}
+#endif
+
 LRESULT CALLBACK
 MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -30,6 +46,9 @@ int D3DApp::Run()
 {
 	MSG msg{};
 	mTimer.Reset();
+#if DX_PROFILER
+	DX::Profiler::SetThreadName("Main");
+#endif
 
 	while (msg.message != WM_QUIT)
 	{
@@ -54,6 +73,9 @@ int D3DApp::Run()
 			}
 		}
 	}
+#if DX_PROFILER
+	ExportProfile();
+#endif
 	return static_cast<int>(msg.wParam);
 }
 
@@ -198,6 +220,12 @@ LRESULT D3DApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		{
 			PostQuitMessage(0);
 		}
+#if DX_PROFILER
+		else if (wParam == VK_F9)
+		{
+			ExportProfile();
+		}
+#endif
 
 		return 0;
 	default:
@@ -475,15 +503,19 @@ void D3DApp::CalculateFrameStats() const
 	if (mTimer.TotalTime() - timeElapsed >= 1.0f)
 	{
 		auto fps = static_cast<float>(frameCount);
-		float mspf = 1000.0f / fps;
-
-		std::wstring fpsStr = std::to_wstring(fps);
-		std::wstring mspfStr = std::to_wstring(mspf);
 
-		std::wstring windowText = mMainWndCaption +
-			L"    fps: " + fpsStr +
-			L"   mfps: " + mspfStr;
-		SetWindowText(mhMainWnd, windowText.c_str());
+		// Percentiles of the recent frame times show the hitches an average hides.
+		const auto stats = mTimer.FrameTimes().GetStats();
+
+		std::wostringstream windowText;
+		windowText << mMainWndCaption << std::fixed << std::setprecision(2)
+			<< L"    fps: " << fps
+			<< L"   ms avg: " << stats.Average * 1000.0f
+			<< L"  p50: " << stats.P50 * 1000.0f
+			<< L"  p95: " << stats.P95 * 1000.0f
+			<< L"  p99: " << stats.P99 * 1000.0f
+			<< L"  max: " << stats.Max * 1000.0f;
+		SetWindowText(mhMainWnd, windowText.str().c_str());
 
 		frameCount = 0;
 		timeElapsed += 1.0f;
@@ -44,6 +44,47 @@ D3D12_INDEX_BUFFER_VIEW MeshGeometry::IndexBufferView() const
 	return ibv;
 }
 
+void MeshGeometry::AddDrawArgs(const std::string& name, const std::vector<MeshPart>& parts,
+	const std::vector<MeshBounds>& bounds)
+{
+	assert(bounds.empty() || bounds.size() == parts.size());
+
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		SubmeshGeometry submesh;
+		submesh.IndexCount = parts[i].IndexCount;
+		submesh.StartIndexLocation = parts[i].StartIndexLocation;
+		submesh.BaseVertexLocation = parts[i].BaseVertexLocation;
+		if (!bounds.empty())
+		{
+			submesh.Bounds = bounds[i].Box;
+			submesh.SphereBounds = bounds[i].Sphere;
+		}
+
+		DrawArgs[parts.size() == 1 ? name : name + "#" + std::to_string(i)] = submesh;
+	}
+}
+
+std::vector<const SubmeshGeometry*> MeshGeometry::FindDrawArgs(const std::string& name) const
+{
+	std::vector<const SubmeshGeometry*> submeshes;
+
+	const auto single = DrawArgs.find(name);
+	if (single != DrawArgs.end())
+	{
+		submeshes.push_back(&single->second);
+		return submeshes;
+	}
+
+	for (size_t i = 0;; ++i)
+	{
+		const auto part = DrawArgs.find(name + "#" + std::to_string(i));
+		if (part == DrawArgs.end()) break;
+		submeshes.push_back(&part->second);
+	}
+	return submeshes;
+}
+
 void MeshGeometry::DisposeUploaders()
 {
 	VertexBufferUploader = nullptr;
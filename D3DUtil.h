@@ -22,6 +22,8 @@
 
 #include "d3dx12.h"
 #include "MathHelper.h"
+#include "MeshBounds.h"
+#include "MeshPackaging.h"
 
 namespace DX
 {
@@ -87,7 +89,9 @@ namespace DX
 		UINT StartIndexLocation = 0;
 		INT BaseVertexLocation = 0;
 
-		// DirectX::BoundingBox Bounds{};
+		// Object space, for culling.
+		DirectX::BoundingBox Bounds{};
+		DirectX::BoundingSphere SphereBounds{};
 	};
 	
 	struct MeshGeometry
@@ -114,6 +118,16 @@ namespace DX
 
 		[[nodiscard]] D3D12_INDEX_BUFFER_VIEW IndexBufferView() const;
 
+		// Registers a packaged mesh under name, or as name#0, name#1, ...
+		// when it was split into several parts. bounds, when given, holds
+		// one entry per part.
+		void AddDrawArgs(const std::string& name, const std::vector<MeshPart>& parts,
+			const std::vector<MeshBounds>& bounds = {});
+
+		// The submeshes AddDrawArgs registered under name, in part order.
+		// Empty when there are none.
+		[[nodiscard]] std::vector<const SubmeshGeometry*> FindDrawArgs(const std::string& name) const;
+
 		void DisposeUploaders();
 	};
 
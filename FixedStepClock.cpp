@@ -0,0 +1,45 @@
+#include "FixedStepClock.h"
+
+#include <cassert>
+
+DX::FixedStepClock::FixedStepClock(const float timeStep, const uint32 maxSubsteps) :
+	mTimeStep(timeStep),
+	mMaxSubsteps(maxSubsteps)
+{
+	assert(timeStep > 0.0f);
+	SetMaxSubsteps(maxSubsteps);
+}
+
+void DX::FixedStepClock::SetMaxSubsteps(const uint32 maxSubsteps)
+{
+	mMaxSubsteps = maxSubsteps > 0 ? maxSubsteps : 1;
+}
+
+DX::FixedStepClock::uint32 DX::FixedStepClock::Advance(const float deltaTime)
+{
+	if (deltaTime > 0.0f)
+	{
+		mAccumulatedTime += deltaTime;
+	}
+
+	uint32 stepCount = 0;
+	while (mAccumulatedTime >= mTimeStep)
+	{
+		mAccumulatedTime -= mTimeStep;
+		++stepCount;
+	}
+
+	if (stepCount > mMaxSubsteps)
+	{
+		mDroppedSteps += stepCount - mMaxSubsteps;
+		stepCount = mMaxSubsteps;
+	}
+
+	return stepCount;
+}
+
+void DX::FixedStepClock::Reset()
+{
+	mAccumulatedTime = 0.0f;
+	mDroppedSteps = 0;
+}
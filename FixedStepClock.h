@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+	/**
+	 * \brief Turns variable frame times into a whole number of fixed steps.
+	 * Leftover time is carried to the next frame instead of being dropped,
+	 * and GetAlpha() tells how far the wall clock is past the last step so a
+	 * renderer can blend the previous and current solutions. A slow frame
+	 * runs at most the configured number of catch-up steps; anything beyond
+	 * that is discarded so one hitch cannot snowball into the next frame.
+	 */
+	class FixedStepClock
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+
+		static constexpr uint32 DEFAULT_MAX_SUBSTEPS = 4;
+
+		explicit FixedStepClock(float timeStep, uint32 maxSubsteps = DEFAULT_MAX_SUBSTEPS);
+
+		[[nodiscard]] auto GetTimeStep()    const { return mTimeStep; }
+		[[nodiscard]] auto GetMaxSubsteps() const { return mMaxSubsteps; }
+		[[nodiscard]] auto GetDroppedSteps() const { return mDroppedSteps; }
+
+		// Fraction of a step the accumulated time is past the last step, in [0, 1).
+		[[nodiscard]] float GetAlpha() const { return mAccumulatedTime / mTimeStep; }
+
+		void SetMaxSubsteps(uint32 maxSubsteps);
+
+		// Accumulates deltaTime and returns the number of steps to run now.
+		uint32 Advance(float deltaTime);
+
+		void Reset();
+
+	private:
+		float mTimeStep;
+		float mAccumulatedTime = 0.0f;
+		uint32 mMaxSubsteps;
+		uint32 mDroppedSteps = 0;
+	};
+}
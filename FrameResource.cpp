@@ -1,6 +1,7 @@
 #include "FrameResource.h"
 
-DX::FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount)
+DX::FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount,
+                                  UINT waveDisturbCellCount)
 {
 	ThrowIfFailed(device->CreateCommandAllocator(
 		D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
@@ -10,4 +11,6 @@ DX::FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT obje
 	ObjConstBuff = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
 
 	MatConstBuff = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
+
+	WavesDisturbBuff = std::make_unique<UploadBuffer<WaveCellDelta>>(device, waveDisturbCellCount, false);
 }
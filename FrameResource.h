@@ -3,6 +3,7 @@
 #include "D3DUtil.h"
 #include "MathHelper.h"
 #include "UploadBuffer.h"
+#include "WaveDisturbance.h"
 
 namespace DX
 {
@@ -13,6 +14,7 @@ namespace DX
 		DirectX::XMFLOAT4X4 WorldInvTranspose        = MathHelper::Identity4x4();
 		DirectX::XMFLOAT2	DisplacementMapTexelSize = { 1.0f, 1.0f };
 		float				GridSpatialStep          = 1.0f;
+		float				DisplacementScale        = 1.0f;
 	};
 
 	struct PassConstants
@@ -52,7 +54,7 @@ namespace DX
 	struct FrameResource
 	{
 		FrameResource(ID3D12Device* device, UINT passCount, 
-			UINT objectCount, UINT materialCount);
+			UINT objectCount, UINT materialCount, UINT waveDisturbCellCount);
 		FrameResource(const FrameResource&) = delete;
 		FrameResource(FrameResource&&) = delete;
 		FrameResource& operator=(const FrameResource&) = delete;
@@ -64,6 +66,7 @@ namespace DX
 		std::unique_ptr<UploadBuffer<PassConstants>> PassConstBuff{};
 		std::unique_ptr<UploadBuffer<ObjectConstants>> ObjConstBuff{};
 		std::unique_ptr<UploadBuffer<MaterialConstants>> MatConstBuff{};
+		std::unique_ptr<UploadBuffer<WaveCellDelta>> WavesDisturbBuff{};
 
 		UINT64 Fence = 0;
 	};
@@ -0,0 +1,78 @@
+#include "FrameTimeHistory.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	// Nearest rank in n sorted samples.
+	uint32 Rank(const float percentile, const uint32 n)
+	{
+		const auto rank = static_cast<uint32>(std::ceil(std::clamp(percentile, 0.0f, 1.0f) * n));
+		return std::max(rank, 1u) - 1;
+	}
+}
+
+void DX::FrameTimeHistory::Push(const float seconds)
+{
+	const uint64 count = mCount.load(std::memory_order_relaxed);
+	mSamples[count % CAPACITY].store(seconds, std::memory_order_relaxed);
+	mCount.store(count + 1, std::memory_order_release);
+}
+
+void DX::FrameTimeHistory::Clear()
+{
+	mCount.store(0, std::memory_order_release);
+}
+
+float DX::FrameTimeHistory::GetPercentile(const float percentile) const
+{
+	float samples[CAPACITY];
+	const uint32 n = Snapshot(samples);
+	if (n == 0) return 0.0f;
+
+	float* nth = samples + Rank(percentile, n);
+	std::nth_element(samples, nth, samples + n);
+	return *nth;
+}
+
+float DX::FrameTimeHistory::GetMax() const
+{
+	float samples[CAPACITY];
+	const uint32 n = Snapshot(samples);
+	return n == 0 ? 0.0f : *std::max_element(samples, samples + n);
+}
+
+DX::FrameTimeHistory::Stats DX::FrameTimeHistory::GetStats() const
+{
+	float samples[CAPACITY];
+	Stats stats;
+	stats.Count = Snapshot(samples);
+	if (stats.Count == 0) return stats;
+
+	// One sort serves every percentile.
+	std::sort(samples, samples + stats.Count);
+
+	double sum = 0.0;
+	for (uint32 i = 0; i < stats.Count; ++i) sum += samples[i];
+
+	stats.Average = static_cast<float>(sum / stats.Count);
+	stats.P50 = samples[Rank(0.50f, stats.Count)];
+	stats.P95 = samples[Rank(0.95f, stats.Count)];
+	stats.P99 = samples[Rank(0.99f, stats.Count)];
+	stats.Max = samples[stats.Count - 1];
+	return stats;
+}
+
+DX::FrameTimeHistory::uint32 DX::FrameTimeHistory::Snapshot(float* samples) const
+{
+	const uint64 count = mCount.load(std::memory_order_acquire);
+	const auto n = static_cast<uint32>(std::min<uint64>(count, CAPACITY));
+	for (uint32 i = 0; i < n; ++i)
+	{
+		samples[i] = mSamples[(count - n + i) % CAPACITY].load(std::memory_order_relaxed);
+	}
+	return n;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace DX
+{
+	/**
+	 * \brief The most recent frame times, pushed by one thread and readable
+	 * from any other without locks. Each slot is an atomic float and the
+	 * count is published after the slot is written, so readers only see
+	 * whole samples. A reader that copies while the writer laps it may pick
+	 * up a few newer samples in place of older ones, which percentiles
+	 * tolerate.
+	 */
+	class FrameTimeHistory
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+		using uint64 = std::uint64_t;
+
+		static constexpr uint32 CAPACITY = 1024;
+
+		// In seconds, over the samples still in the ring; zero when empty.
+		struct Stats
+		{
+			uint32 Count = 0;
+			float Average = 0.0f;
+			float P50 = 0.0f;
+			float P95 = 0.0f;
+			float P99 = 0.0f;
+			float Max = 0.0f;
+		};
+
+		FrameTimeHistory() = default;
+		FrameTimeHistory(const FrameTimeHistory&) = delete;
+		FrameTimeHistory(const FrameTimeHistory&&) = delete;
+		FrameTimeHistory& operator=(const FrameTimeHistory&) = delete;
+		FrameTimeHistory& operator=(const FrameTimeHistory&&) = delete;
+
+		// Writer thread only.
+		void Push(float seconds);
+		void Clear();
+
+		// Frames pushed since the last Clear, including those overwritten.
+		[[nodiscard]] uint64 GetTotalCount() const { return mCount.load(std::memory_order_acquire); }
+
+		// Nearest-rank percentile, with percentile in [0, 1].
+		[[nodiscard]] float GetPercentile(float percentile) const;
+		[[nodiscard]] float GetMax() const;
+		[[nodiscard]] Stats GetStats() const;
+
+	private:
+		// Copies the samples in the ring to samples, returning how many.
+		uint32 Snapshot(float* samples) const;
+
+	private:
+		std::atomic<uint64> mCount = 0;
+		std::array<std::atomic<float>, CAPACITY> mSamples{};
+	};
+}
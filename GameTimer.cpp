@@ -2,16 +2,63 @@
 // GameTimer.cpp by Frank Luna (C) 2011 All Rights Reserved.
 //***************************************************************************************
 
+#if defined(_WIN32)
 #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#else
+#include <chrono>
+#endif
+
 #include "GameTimer.h"
 
+namespace
+{
+#if defined(_WIN32)
+	std::int64_t QueryCounter()
+	{
+		LARGE_INTEGER count;
+		QueryPerformanceCounter(&count);
+		return count.QuadPart;
+	}
+
+	std::int64_t QueryCountsPerSecond()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+	}
+#elif defined(__unix__) || defined(__APPLE__)
+	std::int64_t QueryCounter()
+	{
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+	}
+
+	std::int64_t QueryCountsPerSecond()
+	{
+		return 1000000000;
+	}
+#else
+	std::int64_t QueryCounter()
+	{
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+
+	std::int64_t QueryCountsPerSecond()
+	{
+		using Period = std::chrono::steady_clock::period;
+		return Period::den / Period::num;
+	}
+#endif
+}
+
 GameTimer::GameTimer()
 	: mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0),
-	mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
+	mPausedTime(0), mStopTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / static_cast<double>(countsPerSec);
+	mSecondsPerCount = 1.0 / static_cast<double>(QueryCountsPerSecond());
 }
 
 // Returns the total time elapsed since Reset() was called, NOT counting any
@@ -55,19 +102,19 @@ float GameTimer::DeltaTime()const
 
 void GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	const std::int64_t currTime = QueryCounter();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
 	mStopTime = 0;
 	mStopped = false;
+
+	mFrameTimes.Clear();
 }
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	const std::int64_t startTime = QueryCounter();
 
 	// Accumulate the time elapsed between stop and start pairs.
 	//
@@ -89,8 +136,7 @@ void GameTimer::Stop()
 {
 	if (!mStopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		const std::int64_t currTime = QueryCounter();
 
 		mStopTime = currTime;
 		mStopped = true;
@@ -105,9 +151,7 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-	mCurrTime = currTime;
+	mCurrTime = QueryCounter();
 
 	// Time difference between this frame and the previous.
 	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
@@ -122,4 +166,6 @@ void GameTimer::Tick()
 	{
 		mDeltaTime = 0.0;
 	}
+
+	mFrameTimes.Push(static_cast<float>(mDeltaTime));
 }
\ No newline at end of file
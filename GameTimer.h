@@ -5,6 +5,13 @@
 #ifndef GAMETIMER_H
 #define GAMETIMER_H
 
+#include <cstdint>
+
+#include "FrameTimeHistory.h"
+
+// Counts ticks of QueryPerformanceCounter on Windows, of
+// clock_gettime(CLOCK_MONOTONIC) on POSIX systems and of
+// std::chrono::steady_clock elsewhere, chosen at compile time.
 class GameTimer
 {
 public:
@@ -18,17 +25,22 @@ public:
 	void Stop();  // Call when paused.
 	void Tick();  // Call every frame.
 
+	// Delta times of recent unpaused frames, readable from any thread.
+	const DX::FrameTimeHistory& FrameTimes()const { return mFrameTimes; }
+
 private:
 	double mSecondsPerCount;
 	double mDeltaTime;
 
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+	std::int64_t mBaseTime;
+	std::int64_t mPausedTime;
+	std::int64_t mStopTime;
+	std::int64_t mPrevTime;
+	std::int64_t mCurrTime;
 
 	bool mStopped;
+
+	DX::FrameTimeHistory mFrameTimes;
 };
 
 #endif // GAMETIMER_H
\ No newline at end of file
@@ -3,11 +3,126 @@
 //***************************************************************************************
 
 #include "GeometryGenerator.h"
+#include "Profiler.h"
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
 
 using namespace DirectX;
 using DX::GeometryGenerator;
 
+namespace
+{
+	// 16-bit indices address at most this many vertices.
+	constexpr std::uint32_t MAX_INDEX16_VERTICES = 0x10000;
+
+	// Vertices per band when rows are spread over a thread pool; smaller
+	// meshes are not worth waking the workers for.
+	constexpr std::uint32_t BAND_VERTEX_COUNT = 4096;
+
+	// Calls body(firstRow, lastRow) on bands of rows covering [0, rowCount).
+	void ForEachBand(DX::ThreadPool* threadPool, std::uint32_t rowCount, std::uint32_t rowVertexCount,
+		const std::function<void(std::uint32_t, std::uint32_t)>& body)
+	{
+		const std::uint32_t bandRows = std::max(1u, BAND_VERTEX_COUNT / std::max(rowVertexCount, 1u));
+		const std::uint32_t bandCount = (rowCount + bandRows - 1) / bandRows;
+		const auto band = [&](const std::uint32_t b) { body(b*bandRows, std::min(rowCount, (b+1)*bandRows)); };
+
+		if (threadPool == nullptr || bandCount <= 1)
+		{
+			for (std::uint32_t b = 0; b < bandCount; ++b) band(b);
+		}
+		else
+		{
+			threadPool->ParallelFor(bandCount, band);
+		}
+	}
+
+	// Vertex placement of an m x n CreateGrid. Tiles and the whole grid both
+	// go through it, so a vertex comes out with the same bits either way.
+	struct GridLattice
+	{
+		float HalfWidth;
+		float HalfDepth;
+		float Dx;
+		float Dz;
+		float Du;
+		float Dv;
+
+		GridLattice(float width, float depth, std::uint32_t m, std::uint32_t n) :
+			HalfWidth(0.5f*width), HalfDepth(0.5f*depth),
+			Dx(width / (n-1)), Dz(depth / (m-1)),
+			Du(1.0f / (n-1)), Dv(1.0f / (m-1)) {}
+
+		GeometryGenerator::Vertex At(std::uint32_t i, std::uint32_t j) const
+		{
+			GeometryGenerator::Vertex v;
+			v.Position = XMFLOAT3(-HalfWidth + j*Dx, 0.0f, HalfDepth - i*Dz);
+			v.Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
+			v.TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+
+			// Stretch texture over grid.
+			v.TexC.x = j*Du;
+			v.TexC.y = i*Dv;
+			return v;
+		}
+	};
+
+	// Maps an undirected edge to the index of its midpoint vertex. Both
+	// endpoint indices are packed into one 64-bit key and looked up with
+	// linear probing in a table sized up front, so it never rehashes.
+	class EdgeMidpointTable
+	{
+	public:
+		using uint32 = std::uint32_t;
+		using uint64 = std::uint64_t;
+
+		explicit EdgeMidpointTable(size_t maxEdgeCount)
+		{
+			// Keep the load factor at or below 3/4 even if every edge is distinct.
+			uint32 shift = 64 - 4;
+			while ((size_t(1) << (64 - shift)) * 3 < maxEdgeCount * 4) --shift;
+
+			mShift = shift;
+			mKeys.assign(size_t(1) << (64 - shift), EMPTY_KEY);
+			mValues.resize(mKeys.size());
+		}
+
+		// Returns the value slot of edge (a, b); inserted tells whether it was just added.
+		uint32& FindOrInsert(uint32 a, uint32 b, bool& inserted)
+		{
+			const uint64 key = a < b ? (uint64(a) << 32) | b : (uint64(b) << 32) | a;
+			const size_t mask = mKeys.size() - 1;
+
+			// Fibonacci hashing spreads the sequential indices over the table.
+			for (size_t slot = (key * 0x9E3779B97F4A7C15ull) >> mShift; ; slot = (slot + 1) & mask)
+			{
+				if (mKeys[slot] == key)
+				{
+					inserted = false;
+					return mValues[slot];
+				}
+
+				if (mKeys[slot] == EMPTY_KEY)
+				{
+					mKeys[slot] = key;
+					inserted = true;
+					return mValues[slot];
+				}
+			}
+		}
+
+	private:
+		// Never a valid key, an edge (a, a) does not exist.
+		static constexpr uint64 EMPTY_KEY = ~uint64(0);
+
+		uint32 mShift;
+		std::vector<uint64> mKeys;
+		std::vector<uint32> mValues;
+	};
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
     MeshData meshData;
@@ -101,10 +216,54 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
     return meshData;
 }
 
+GeometryGenerator::MeshSize GeometryGenerator::GetSphereSize(uint32 sliceCount, uint32 stackCount)
+{
+	MeshSize size;
+	size.VertexCount = (stackCount-1)*(sliceCount+1) + 2;
+	size.IndexCount  = (stackCount-1)*sliceCount*6;
+	return size;
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount)
 {
     MeshData meshData;
 
+	const MeshSize size = GetSphereSize(sliceCount, stackCount);
+	meshData.Vertices.resize(size.VertexCount);
+	meshData.Indices32.resize(size.IndexCount);
+	BuildSphere(radius, sliceCount, stackCount, meshData.Vertices.data(), meshData.Indices32.data(), nullptr);
+
+    return meshData;
+}
+
+void GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+	Vertex* vertices, uint32* indices, ThreadPool* threadPool)
+{
+	BuildSphere(radius, sliceCount, stackCount, vertices, indices, threadPool);
+}
+
+void GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+	Vertex* vertices, uint16* indices, ThreadPool* threadPool)
+{
+	assert(GetSphereSize(sliceCount, stackCount).VertexCount <= MAX_INDEX16_VERTICES);
+	BuildSphere(radius, sliceCount, stackCount, vertices, indices, threadPool);
+}
+
+GeometryGenerator::MeshView GeometryGenerator::CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+	MeshArena& arena, ThreadPool* threadPool)
+{
+	MeshView view;
+	view.Size = GetSphereSize(sliceCount, stackCount);
+	view.Vertices = arena.Allocate<Vertex>(view.Size.VertexCount);
+	view.Indices32 = arena.Allocate<uint32>(view.Size.IndexCount);
+	BuildSphere(radius, sliceCount, stackCount, view.Vertices, view.Indices32, threadPool);
+	return view;
+}
+
+template <class Index>
+void GeometryGenerator::BuildSphere(float radius, uint32 sliceCount, uint32 stackCount,
+	Vertex* vertices, Index* indices, ThreadPool* threadPool)
+{
 	//
 	// Compute the vertices stating at the top pole and moving down the stacks.
 	//
@@ -115,80 +274,94 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
-	meshData.Vertices.push_back( topVertex );
+	// Add one because we duplicate the first and last vertex per ring
+	// since the texture coordinates are different.
+	uint32 ringVertexCount = sliceCount + 1;
+
+	// South pole vertex is written last.
+	uint32 southPoleIndex = (stackCount-1)*ringVertexCount + 1;
+
+	vertices[0] = topVertex;
+	vertices[southPoleIndex] = bottomVertex;
 
 	float phiStep   = XM_PI/stackCount;
 	float thetaStep = 2.0f*XM_PI/sliceCount;
 
-	// Compute vertices for each stack ring (do not count the poles as rings).
-	for(uint32 i = 1; i <= stackCount-1; ++i)
-	{
-		float phi = i*phiStep;
+	// Offset the indices to the index of the first vertex in the first ring.
+	// This is just skipping the top pole vertex.
+	uint32 baseIndex = 1;
 
-		// Vertices of ring.
-        for(uint32 j = 0; j <= sliceCount; ++j)
+	// Compute vertices for each stack ring (do not count the poles as rings),
+	// together with the indices of the inner stack below it, which is not
+	// connected to a pole. Ring i writes only its own slice of both arrays.
+	ForEachBand(threadPool, stackCount-1, ringVertexCount, [&](uint32 firstRing, uint32 lastRing)
+	{
+		for(uint32 i = firstRing; i < lastRing; ++i)
 		{
-			float theta = j*thetaStep;
+			float phi = (i+1)*phiStep;
 
-			Vertex v;
+			// Vertices of ring.
+			Vertex* ring = vertices + baseIndex + i*ringVertexCount;
+			for(uint32 j = 0; j <= sliceCount; ++j)
+			{
+				float theta = j*thetaStep;
 
-			// spherical to cartesian
-			v.Position.x = radius*sinf(phi)*cosf(theta);
-			v.Position.y = radius*cosf(phi);
-			v.Position.z = radius*sinf(phi)*sinf(theta);
+				Vertex v;
 
-			// Partial derivative of P with respect to theta
-			v.TangentU.x = -radius*sinf(phi)*sinf(theta);
-			v.TangentU.y = 0.0f;
-			v.TangentU.z = +radius*sinf(phi)*cosf(theta);
+				// spherical to cartesian
+				v.Position.x = radius*sinf(phi)*cosf(theta);
+				v.Position.y = radius*cosf(phi);
+				v.Position.z = radius*sinf(phi)*sinf(theta);
 
-			XMVECTOR T = XMLoadFloat3(&v.TangentU);
-			XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
+				// Partial derivative of P with respect to theta
+				v.TangentU.x = -radius*sinf(phi)*sinf(theta);
+				v.TangentU.y = 0.0f;
+				v.TangentU.z = +radius*sinf(phi)*cosf(theta);
 
-			XMVECTOR p = XMLoadFloat3(&v.Position);
-			XMStoreFloat3(&v.Normal, XMVector3Normalize(p));
+				XMVECTOR T = XMLoadFloat3(&v.TangentU);
+				XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
 
-			v.TexC.x = theta / XM_2PI;
-			v.TexC.y = phi / XM_PI;
+				XMVECTOR p = XMLoadFloat3(&v.Position);
+				XMStoreFloat3(&v.Normal, XMVector3Normalize(p));
 
-			meshData.Vertices.push_back( v );
-		}
-	}
+				v.TexC.x = theta / XM_2PI;
+				v.TexC.y = phi / XM_PI;
+
+				ring[j] = v;
+			}
 
-	meshData.Vertices.push_back( bottomVertex );
+			if (i+2 >= stackCount)
+				continue;
+
+			// Inner stacks follow the top stack's sliceCount triangles.
+			Index* k = indices + sliceCount*3 + i*sliceCount*6;
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				k[0] = Index(baseIndex + i*ringVertexCount + j);
+				k[1] = Index(baseIndex + i*ringVertexCount + j+1);
+				k[2] = Index(baseIndex + (i+1)*ringVertexCount + j);
+
+				k[3] = Index(baseIndex + (i+1)*ringVertexCount + j);
+				k[4] = Index(baseIndex + i*ringVertexCount + j+1);
+				k[5] = Index(baseIndex + (i+1)*ringVertexCount + j+1);
+
+				k += 6;
+			}
+		}
+	});
 
 	//
 	// Compute indices for top stack.  The top stack was written first to the vertex buffer
 	// and connects the top pole to the first ring.
 	//
 
-    for(uint32 i = 1; i <= sliceCount; ++i)
+	Index* k = indices;
+	for(uint32 i = 1; i <= sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(0);
-		meshData.Indices32.push_back(i+1);
-		meshData.Indices32.push_back(i);
-	}
-	
-	//
-	// Compute indices for inner stacks (not connected to poles).
-	//
-
-	// Offset the indices to the index of the first vertex in the first ring.
-	// This is just skipping the top pole vertex.
-    uint32 baseIndex = 1;
-    uint32 ringVertexCount = sliceCount + 1;
-	for(uint32 i = 0; i < stackCount-2; ++i)
-	{
-		for(uint32 j = 0; j < sliceCount; ++j)
-		{
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j+1);
-		}
+		k[0] = 0;
+		k[1] = Index(i+1);
+		k[2] = Index(i);
+		k += 3;
 	}
 
 	//
@@ -196,31 +369,21 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	// and connects the bottom pole to the bottom ring.
 	//
 
-	// South pole vertex was added last.
-	uint32 southPoleIndex = (uint32)meshData.Vertices.size()-1;
-
 	// Offset the indices to the index of the first vertex in the last ring.
 	baseIndex = southPoleIndex - ringVertexCount;
-	
+
+	k = indices + sliceCount*3 + (stackCount-2)*sliceCount*6;
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(southPoleIndex);
-		meshData.Indices32.push_back(baseIndex+i);
-		meshData.Indices32.push_back(baseIndex+i+1);
+		k[0] = Index(southPoleIndex);
+		k[1] = Index(baseIndex+i);
+		k[2] = Index(baseIndex+i+1);
+		k += 3;
 	}
-
-    return meshData;
 }
- 
+
 void GeometryGenerator::Subdivide(MeshData& meshData)
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
-
-
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
-
 	//       v1
 	//       *
 	//      / \
@@ -231,48 +394,45 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
-	for(uint32 i = 0; i < numTris; ++i)
-	{
-		Vertex v0 = inputCopy.Vertices[ inputCopy.Indices32[i*3+0] ];
-		Vertex v1 = inputCopy.Vertices[ inputCopy.Indices32[i*3+1] ];
-		Vertex v2 = inputCopy.Vertices[ inputCopy.Indices32[i*3+2] ];
-
-		//
-		// Generate the midpoints.
-		//
-
-        Vertex m0 = MidPoint(v0, v1);
-        Vertex m1 = MidPoint(v1, v2);
-        Vertex m2 = MidPoint(v0, v2);
-
-		//
-		// Add new geometry.
-		//
-
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
- 
-		meshData.Indices32.push_back(i*6+0);
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+5);
+	// The input vertices keep their indices and every edge gets one midpoint,
+	// shared by the two triangles on either side of it. Open meshes such as
+	// the box faces have up to three edges per triangle, closed ones 3/2.
+	const uint32 numTris = (uint32)meshData.Indices32.size()/3;
+	EdgeMidpointTable midpoints(numTris*3);
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+5);
+	meshData.Vertices.reserve(meshData.Vertices.size() + numTris*3/2);
 
-		meshData.Indices32.push_back(i*6+5);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+2);
+	const auto midPoint = [this, &meshData, &midpoints](uint32 a, uint32 b)
+	{
+		bool inserted = false;
+		uint32& index = midpoints.FindOrInsert(a, b, inserted);
+		if (inserted)
+		{
+			index = (uint32)meshData.Vertices.size();
+			meshData.Vertices.push_back(MidPoint(meshData.Vertices[a], meshData.Vertices[b]));
+		}
+		return index;
+	};
 
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+1);
-		meshData.Indices32.push_back(i*6+4);
+	std::vector<uint32> indices(numTris*12);
+	for(uint32 i = 0; i < numTris; ++i)
+	{
+		const uint32 v0 = meshData.Indices32[i*3+0];
+		const uint32 v1 = meshData.Indices32[i*3+1];
+		const uint32 v2 = meshData.Indices32[i*3+2];
+
+		const uint32 m0 = midPoint(v0, v1);
+		const uint32 m1 = midPoint(v1, v2);
+		const uint32 m2 = midPoint(v0, v2);
+
+		uint32* tri = &indices[i*12];
+		tri[0] = v0; tri[1]  = m0; tri[2]  = m2;
+		tri[3] = m0; tri[4]  = m1; tri[5]  = m2;
+		tri[6] = m2; tri[7]  = m1; tri[8]  = v2;
+		tri[9] = m0; tri[10] = v1; tri[11] = m1;
 	}
+
+	meshData.Indices32 = std::move(indices);
 }
 
 GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Vertex& v1)
@@ -309,8 +469,8 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 {
     MeshData meshData;
 
-	// Put a cap on the number of subdivisions.
-    numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	// Put a cap on the number of subdivisions; depth 8 already has 655362 vertices.
+    numSubdivisions = std::min<uint32>(numSubdivisions, 8u);
 
 	// Approximate a sphere by tessellating an icosahedron.
 
@@ -380,10 +540,56 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
     return meshData;
 }
 
+GeometryGenerator::MeshSize GeometryGenerator::GetCylinderSize(uint32 sliceCount, uint32 stackCount)
+{
+	// Stack rings plus a ring and a center vertex for each cap.
+	MeshSize size;
+	size.VertexCount = (stackCount+1)*(sliceCount+1) + 2*(sliceCount+2);
+	size.IndexCount  = stackCount*sliceCount*6 + 2*sliceCount*3;
+	return size;
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
 {
     MeshData meshData;
 
+	const MeshSize size = GetCylinderSize(sliceCount, stackCount);
+	meshData.Vertices.resize(size.VertexCount);
+	meshData.Indices32.resize(size.IndexCount);
+	BuildCylinder(bottomRadius, topRadius, height, sliceCount, stackCount,
+		meshData.Vertices.data(), meshData.Indices32.data(), nullptr);
+
+    return meshData;
+}
+
+void GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+	Vertex* vertices, uint32* indices, ThreadPool* threadPool)
+{
+	BuildCylinder(bottomRadius, topRadius, height, sliceCount, stackCount, vertices, indices, threadPool);
+}
+
+void GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+	Vertex* vertices, uint16* indices, ThreadPool* threadPool)
+{
+	assert(GetCylinderSize(sliceCount, stackCount).VertexCount <= MAX_INDEX16_VERTICES);
+	BuildCylinder(bottomRadius, topRadius, height, sliceCount, stackCount, vertices, indices, threadPool);
+}
+
+GeometryGenerator::MeshView GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+	MeshArena& arena, ThreadPool* threadPool)
+{
+	MeshView view;
+	view.Size = GetCylinderSize(sliceCount, stackCount);
+	view.Vertices = arena.Allocate<Vertex>(view.Size.VertexCount);
+	view.Indices32 = arena.Allocate<uint32>(view.Size.IndexCount);
+	BuildCylinder(bottomRadius, topRadius, height, sliceCount, stackCount, view.Vertices, view.Indices32, threadPool);
+	return view;
+}
+
+template <class Index>
+void GeometryGenerator::BuildCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+	Vertex* vertices, Index* indices, ThreadPool* threadPool)
+{
 	//
 	// Build Stacks.
 	// 
@@ -395,90 +601,98 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius
 
 	uint32 ringCount = stackCount+1;
 
-	// Compute vertices for each stack ring starting at the bottom and moving up.
-	for(uint32 i = 0; i < ringCount; ++i)
-	{
-		float y = -0.5f*height + i*stackHeight;
-		float r = bottomRadius + i*radiusStep;
-
-		// vertices of ring
-		float dTheta = 2.0f*XM_PI/sliceCount;
-		for(uint32 j = 0; j <= sliceCount; ++j)
-		{
-			Vertex vertex;
-
-			float c = cosf(j*dTheta);
-			float s = sinf(j*dTheta);
-
-			vertex.Position = XMFLOAT3(r*c, y, r*s);
-
-			vertex.TexC.x = (float)j/sliceCount;
-			vertex.TexC.y = 1.0f - (float)i/stackCount;
-
-			// Cylinder can be parameterized as follows, where we introduce v
-			// parameter that goes in the same direction as the v tex-coord
-			// so that the bitangent goes in the same direction as the v tex-coord.
-			//   Let r0 be the bottom radius and let r1 be the top radius.
-			//   y(v) = h - hv for v in [0,1].
-			//   r(v) = r1 + (r0-r1)v
-			//
-			//   x(t, v) = r(v)*cos(t)
-			//   y(t, v) = h - hv
-			//   z(t, v) = r(v)*sin(t)
-			// 
-			//  dx/dt = -r(v)*sin(t)
-			//  dy/dt = 0
-			//  dz/dt = +r(v)*cos(t)
-			//
-			//  dx/dv = (r0-r1)*cos(t)
-			//  dy/dv = -h
-			//  dz/dv = (r0-r1)*sin(t)
-
-			// This is unit length.
-			vertex.TangentU = XMFLOAT3(-s, 0.0f, c);
-
-			float dr = bottomRadius-topRadius;
-			XMFLOAT3 bitangent(dr*c, -height, dr*s);
-
-			XMVECTOR T = XMLoadFloat3(&vertex.TangentU);
-			XMVECTOR B = XMLoadFloat3(&bitangent);
-			XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-			XMStoreFloat3(&vertex.Normal, N);
-
-			meshData.Vertices.push_back(vertex);
-		}
-	}
-
 	// Add one because we duplicate the first and last vertex per ring
 	// since the texture coordinates are different.
 	uint32 ringVertexCount = sliceCount+1;
 
-	// Compute indices for each stack.
-	for(uint32 i = 0; i < stackCount; ++i)
+	// Compute vertices for each stack ring starting at the bottom and moving up,
+	// together with the indices of the stack above it.
+	ForEachBand(threadPool, ringCount, ringVertexCount, [&](uint32 firstRing, uint32 lastRing)
 	{
-		for(uint32 j = 0; j < sliceCount; ++j)
+		for(uint32 i = firstRing; i < lastRing; ++i)
 		{
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-			meshData.Indices32.push_back(i*ringVertexCount + j+1);
+			float y = -0.5f*height + i*stackHeight;
+			float r = bottomRadius + i*radiusStep;
+
+			// vertices of ring
+			float dTheta = 2.0f*XM_PI/sliceCount;
+			for(uint32 j = 0; j <= sliceCount; ++j)
+			{
+				Vertex vertex;
+
+				float c = cosf(j*dTheta);
+				float s = sinf(j*dTheta);
+
+				vertex.Position = XMFLOAT3(r*c, y, r*s);
+
+				vertex.TexC.x = (float)j/sliceCount;
+				vertex.TexC.y = 1.0f - (float)i/stackCount;
+
+				// Cylinder can be parameterized as follows, where we introduce v
+				// parameter that goes in the same direction as the v tex-coord
+				// so that the bitangent goes in the same direction as the v tex-coord.
+				//   Let r0 be the bottom radius and let r1 be the top radius.
+				//   y(v) = h - hv for v in [0,1].
+				//   r(v) = r1 + (r0-r1)v
+				//
+				//   x(t, v) = r(v)*cos(t)
+				//   y(t, v) = h - hv
+				//   z(t, v) = r(v)*sin(t)
+				// 
+				//  dx/dt = -r(v)*sin(t)
+				//  dy/dt = 0
+				//  dz/dt = +r(v)*cos(t)
+				//
+				//  dx/dv = (r0-r1)*cos(t)
+				//  dy/dv = -h
+				//  dz/dv = (r0-r1)*sin(t)
+
+				// This is unit length.
+				vertex.TangentU = XMFLOAT3(-s, 0.0f, c);
+
+				float dr = bottomRadius-topRadius;
+				XMFLOAT3 bitangent(dr*c, -height, dr*s);
+
+				XMVECTOR T = XMLoadFloat3(&vertex.TangentU);
+				XMVECTOR B = XMLoadFloat3(&bitangent);
+				XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
+				XMStoreFloat3(&vertex.Normal, N);
+
+				vertices[i*ringVertexCount + j] = vertex;
+			}
+
+			if (i == stackCount)
+				continue;
+
+			// Compute indices for this stack.
+			Index* k = indices + i*sliceCount*6;
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				k[0] = Index(i*ringVertexCount + j);
+				k[1] = Index((i+1)*ringVertexCount + j);
+				k[2] = Index((i+1)*ringVertexCount + j+1);
+
+				k[3] = Index(i*ringVertexCount + j);
+				k[4] = Index((i+1)*ringVertexCount + j+1);
+				k[5] = Index(i*ringVertexCount + j+1);
+
+				k += 6;
+			}
 		}
-	}
+	});
 
-	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
+	// Each cap adds a ring plus a center vertex and one triangle per slice.
+	uint32 baseIndex = ringCount*ringVertexCount;
+	Index* capIndices = indices + stackCount*sliceCount*6;
 
-    return meshData;
+	BuildCylinderTopCap(topRadius, height, sliceCount, baseIndex, vertices, capIndices);
+	BuildCylinderBottomCap(bottomRadius, height, sliceCount, baseIndex + sliceCount+2, vertices, capIndices + sliceCount*3);
 }
 
-void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius, float height,
-											uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+template <class Index>
+void GeometryGenerator::BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount,
+											uint32 baseIndex, Vertex* vertices, Index* indices)
 {
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
-
 	float y = 0.5f*height;
 	float dTheta = 2.0f*XM_PI/sliceCount;
 
@@ -493,31 +707,31 @@ void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius,
 		float u = x/height + 0.5f;
 		float v = z/height + 0.5f;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
+		vertices[baseIndex + i] = Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v);
 	}
 
-	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
-
 	// Index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 centerIndex = baseIndex + sliceCount+1;
+
+	// Cap center vertex.
+	vertices[centerIndex] = Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f);
 
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i+1);
-		meshData.Indices32.push_back(baseIndex + i);
+		indices[i*3+0] = Index(centerIndex);
+		indices[i*3+1] = Index(baseIndex + i+1);
+		indices[i*3+2] = Index(baseIndex + i);
 	}
 }
 
-void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadius, float height,
-											   uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+template <class Index>
+void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount,
+											   uint32 baseIndex, Vertex* vertices, Index* indices)
 {
 	// 
 	// Build bottom cap.
 	//
 
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
 	float y = -0.5f*height;
 
 	// vertices of ring
@@ -532,86 +746,221 @@ void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadi
 		float u = x/height + 0.5f;
 		float v = z/height + 0.5f;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
+		vertices[baseIndex + i] = Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v);
 	}
 
-	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
-
 	// Cache the index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	uint32 centerIndex = baseIndex + sliceCount+1;
+
+	// Cap center vertex.
+	vertices[centerIndex] = Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f);
 
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i);
-		meshData.Indices32.push_back(baseIndex + i+1);
+		indices[i*3+0] = Index(centerIndex);
+		indices[i*3+1] = Index(baseIndex + i);
+		indices[i*3+2] = Index(baseIndex + i+1);
 	}
 }
 
+GeometryGenerator::MeshSize GeometryGenerator::GetGridSize(uint32 m, uint32 n)
+{
+	MeshSize size;
+	size.VertexCount = m*n;
+	size.IndexCount  = (m-1)*(n-1)*6; // 3 indices per face
+	return size;
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n)
 {
     MeshData meshData;
 
-	uint32 vertexCount = m*n;
-	uint32 faceCount   = (m-1)*(n-1)*2;
+	const MeshSize size = GetGridSize(m, n);
+	meshData.Vertices.resize(size.VertexCount);
+	meshData.Indices32.resize(size.IndexCount);
+	BuildGrid(width, depth, m, n, meshData.Vertices.data(), meshData.Indices32.data(), nullptr);
 
-	//
-	// Create the vertices.
-	//
+    return meshData;
+}
+
+void GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n,
+	Vertex* vertices, uint32* indices, ThreadPool* threadPool)
+{
+	BuildGrid(width, depth, m, n, vertices, indices, threadPool);
+}
 
-	float halfWidth = 0.5f*width;
-	float halfDepth = 0.5f*depth;
+void GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n,
+	Vertex* vertices, uint16* indices, ThreadPool* threadPool)
+{
+	assert(GetGridSize(m, n).VertexCount <= MAX_INDEX16_VERTICES);
+	BuildGrid(width, depth, m, n, vertices, indices, threadPool);
+}
 
-	float dx = width / (n-1);
-	float dz = depth / (m-1);
+GeometryGenerator::MeshView GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n,
+	MeshArena& arena, ThreadPool* threadPool)
+{
+	MeshView view;
+	view.Size = GetGridSize(m, n);
+	view.Vertices = arena.Allocate<Vertex>(view.Size.VertexCount);
+	view.Indices32 = arena.Allocate<uint32>(view.Size.IndexCount);
+	BuildGrid(width, depth, m, n, view.Vertices, view.Indices32, threadPool);
+	return view;
+}
 
-	float du = 1.0f / (n-1);
-	float dv = 1.0f / (m-1);
+template <class Index>
+void GeometryGenerator::BuildGrid(float width, float depth, uint32 m, uint32 n,
+	Vertex* vertices, Index* indices, ThreadPool* threadPool)
+{
+	const GridLattice lattice(width, depth, m, n);
 
-	meshData.Vertices.resize(vertexCount);
-	for(uint32 i = 0; i < m; ++i)
+	// Row i writes its vertices and the quads between it and row i+1.
+	ForEachBand(threadPool, m, n, [&](uint32 firstRow, uint32 lastRow)
 	{
-		float z = halfDepth - i*dz;
-		for(uint32 j = 0; j < n; ++j)
+		for(uint32 i = firstRow; i < lastRow; ++i)
 		{
-			float x = -halfWidth + j*dx;
+			//
+			// Create the vertices.
+			//
 
-			meshData.Vertices[i*n+j].Position = XMFLOAT3(x, 0.0f, z);
-			meshData.Vertices[i*n+j].Normal   = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			meshData.Vertices[i*n+j].TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+			for(uint32 j = 0; j < n; ++j)
+				vertices[i*n+j] = lattice.At(i, j);
 
-			// Stretch texture over grid.
-			meshData.Vertices[i*n+j].TexC.x = j*du;
-			meshData.Vertices[i*n+j].TexC.y = i*dv;
+			if (i == m-1)
+				continue;
+
+			//
+			// Create the indices.
+			//
+
+			// Iterate over each quad and compute indices.
+			Index* k = indices + i*(n-1)*6;
+			for(uint32 j = 0; j < n-1; ++j)
+			{
+				k[0] = Index(i*n+j);
+				k[1] = Index(i*n+j+1);
+				k[2] = Index((i+1)*n+j);
+
+				k[3] = Index((i+1)*n+j);
+				k[4] = Index(i*n+j+1);
+				k[5] = Index((i+1)*n+j+1);
+
+				k += 6; // next quad
+			}
 		}
-	}
- 
-    //
-	// Create the indices.
-	//
+	});
+}
+
+void GeometryGenerator::CreateGridTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads, float skirtDepth,
+	const std::function<void(const GridTile&)>& onTile, ThreadPool* threadPool)
+{
+	DX_PROFILE_ZONE("CreateGridTiles");
+	assert(tileQuads > 0);
 
-	meshData.Indices32.resize(faceCount*3); // 3 indices per face
+	const uint32 tileRows = (m-1 + tileQuads-1) / tileQuads;
+	const uint32 tileCols = (n-1 + tileQuads-1) / tileQuads;
+	const uint32 tileCount = tileRows*tileCols;
 
-	// Iterate over each quad and compute indices.
-	uint32 k = 0;
-	for(uint32 i = 0; i < m-1; ++i)
+	// Workers pull tiles off a shared counter and keep their buffers
+	// between tiles.
+	std::atomic<uint32> nextTile = 0;
+	const auto worker = [&](uint32)
 	{
-		for(uint32 j = 0; j < n-1; ++j)
+		std::vector<Vertex> vertices;
+		std::vector<uint32> indices;
+		GridTile tile;
+
+		for(uint32 t = nextTile++; t < tileCount; t = nextTile++)
 		{
-			meshData.Indices32[k]   = i*n+j;
-			meshData.Indices32[k+1] = i*n+j+1;
-			meshData.Indices32[k+2] = (i+1)*n+j;
+			BuildGridTile(width, depth, m, n, tileQuads, skirtDepth, t / tileCols, t % tileCols, vertices, indices, tile);
+			onTile(tile);
+		}
+	};
 
-			meshData.Indices32[k+3] = (i+1)*n+j;
-			meshData.Indices32[k+4] = i*n+j+1;
-			meshData.Indices32[k+5] = (i+1)*n+j+1;
+	const uint32 workerCount = threadPool == nullptr ? 1 : std::min(threadPool->GetThreadCount(), tileCount);
+	if (workerCount > 1)
+	{
+		threadPool->ParallelFor(workerCount, worker);
+	}
+	else
+	{
+		worker(0);
+	}
+}
 
-			k += 6; // next quad
+void GeometryGenerator::BuildGridTile(float width, float depth, uint32 m, uint32 n, uint32 tileQuads, float skirtDepth,
+	uint32 tileRow, uint32 tileCol, std::vector<Vertex>& vertices, std::vector<uint32>& indices, GridTile& tile)
+{
+	const GridLattice lattice(width, depth, m, n);
+
+	tile.TileRow  = tileRow;
+	tile.TileCol  = tileCol;
+	tile.FirstRow = tileRow*tileQuads;
+	tile.FirstCol = tileCol*tileQuads;
+	tile.RowCount = std::min(tileQuads, m-1 - tile.FirstRow) + 1;
+	tile.ColCount = std::min(tileQuads, n-1 - tile.FirstCol) + 1;
+
+	const uint32 rows = tile.RowCount;
+	const uint32 cols = tile.ColCount;
+
+	// Reserving the full-size tile up front keeps the buffers from growing later.
+	const uint32 maxSide = tileQuads+1;
+	vertices.reserve(maxSide*maxSide + 4*maxSide);
+	indices.reserve(tileQuads*tileQuads*6 + 4*tileQuads*6);
+	vertices.clear();
+	indices.clear();
+
+	for(uint32 i = 0; i < rows; ++i)
+		for(uint32 j = 0; j < cols; ++j)
+			vertices.push_back(lattice.At(tile.FirstRow + i, tile.FirstCol + j));
+
+	// Same quads and winding as CreateGrid, in tile-local indices.
+	for(uint32 i = 0; i < rows-1; ++i)
+	{
+		for(uint32 j = 0; j < cols-1; ++j)
+		{
+			const uint32 quad[6] = { i*cols+j, i*cols+j+1, (i+1)*cols+j, (i+1)*cols+j, i*cols+j+1, (i+1)*cols+j+1 };
+			indices.insert(indices.end(), quad, quad+6);
 		}
 	}
 
-    return meshData;
+	tile.GridIndexCount = (uint32)indices.size();
+
+	if (skirtDepth > 0.0f)
+	{
+		// Each edge is walked so that its direction crossed with +y points
+		// out of the tile; the skirt quads then face outwards.
+		const auto addSkirt = [&](uint32 first, int step, uint32 count)
+		{
+			const uint32 baseIndex = (uint32)vertices.size();
+			for(uint32 k = 0; k < count; ++k)
+			{
+				Vertex skirt = vertices[first + k*step];
+				skirt.Position.y -= skirtDepth;
+				vertices.push_back(skirt);
+			}
+
+			for(uint32 k = 0; k+1 < count; ++k)
+			{
+				const uint32 e0 = first + k*step;
+				const uint32 e1 = first + (k+1)*step;
+				const uint32 s0 = baseIndex + k;
+				const uint32 s1 = baseIndex + k+1;
+				const uint32 quad[6] = { e0, s0, e1, e1, s0, s1 };
+				indices.insert(indices.end(), quad, quad+6);
+			}
+		};
+
+		const int c = (int)cols;
+		addSkirt(0, 1, cols);                       // far edge, +z
+		addSkirt(cols-1, c, rows);                  // right edge, +x
+		addSkirt((rows-1)*cols + cols-1, -1, cols); // near edge, -z
+		addSkirt((rows-1)*cols, -c, rows);          // left edge, -x
+	}
+
+	tile.Vertices    = vertices.data();
+	tile.VertexCount = (uint32)vertices.size();
+	tile.Indices     = indices.data();
+	tile.IndexCount  = (uint32)indices.size();
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
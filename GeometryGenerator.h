@@ -14,10 +14,15 @@
 
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <DirectXMath.h>
+#include <functional>
 #include <vector>
 
+#include "MeshArena.h"
+#include "ThreadPool.h"
+
 namespace DX
 {
 	class GeometryGenerator
@@ -60,8 +65,12 @@ namespace DX
 			std::vector<Vertex> Vertices;
 			std::vector<uint32> Indices32;
 
+			// Only valid for meshes of at most 65536 vertices; PackageMesh
+			// splits larger ones or keeps 32-bit indices.
 			std::vector<uint16>& GetIndices16()
 			{
+				assert(Vertices.size() <= 0x10000);
+
 				if (mIndices16.empty())
 				{
 					mIndices16.resize(Indices32.size());
@@ -76,6 +85,49 @@ namespace DX
 			std::vector<uint16> mIndices16;
 		};
 
+		struct MeshSize
+		{
+			uint32 VertexCount = 0;
+			uint32 IndexCount = 0;
+		};
+
+		// Arrays a mesh was built into by the MeshArena overloads.
+		struct MeshView
+		{
+			Vertex* Vertices = nullptr;
+			uint32* Indices32 = nullptr;
+			MeshSize Size;
+		};
+
+		// One tile of CreateGridTiles, valid only during the callback. Vertex
+		// (i, j) of the tile is vertex (FirstRow + i, FirstCol + j) of the
+		// whole grid, so neighbouring tiles repeat their shared edge. The
+		// first RowCount * ColCount vertices and GridIndexCount indices are
+		// the grid itself, skirt vertices and triangles follow.
+		struct GridTile
+		{
+			uint32 TileRow = 0;
+			uint32 TileCol = 0;
+			uint32 FirstRow = 0;
+			uint32 FirstCol = 0;
+			uint32 RowCount = 0;
+			uint32 ColCount = 0;
+
+			const Vertex* Vertices = nullptr;
+			uint32 VertexCount = 0;
+			const uint32* Indices = nullptr;
+			uint32 IndexCount = 0;
+			uint32 GridIndexCount = 0;
+		};
+
+		///<summary>
+		/// Vertex and index counts of the matching Create* call, so callers can
+		/// size their own buffers before generating into them.
+		///</summary>
+		static MeshSize GetSphereSize(uint32 sliceCount, uint32 stackCount);
+		static MeshSize GetCylinderSize(uint32 sliceCount, uint32 stackCount);
+		static MeshSize GetGridSize(uint32 m, uint32 n);
+
 		///<summary>
 		/// Creates a box centered at the origin with the given dimensions, where each
 		/// face has m rows and n columns of vertices.
@@ -88,6 +140,17 @@ namespace DX
 		///</summary>
 		MeshData CreateSphere(float radius, uint32 sliceCount, uint32 stackCount);
 
+		///<summary>
+		/// Same sphere, written into caller arrays of at least GetSphereSize() elements.
+		/// Stack rings are filled in parallel when a thread pool is given.
+		///</summary>
+		void CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+			Vertex* vertices, uint32* indices, ThreadPool* threadPool = nullptr);
+		void CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+			Vertex* vertices, uint16* indices, ThreadPool* threadPool = nullptr);
+		MeshView CreateSphere(float radius, uint32 sliceCount, uint32 stackCount,
+			MeshArena& arena, ThreadPool* threadPool = nullptr);
+
 		///<summary>
 		/// Creates a geosphere centered at the origin with the given radius.  The
 		/// depth controls the level of tessellation.
@@ -101,12 +164,45 @@ namespace DX
 		///</summary>
 		MeshData CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount);
 
+		///<summary>
+		/// Same cylinder, written into caller arrays of at least GetCylinderSize() elements.
+		/// Stack rings are filled in parallel when a thread pool is given.
+		///</summary>
+		void CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+			Vertex* vertices, uint32* indices, ThreadPool* threadPool = nullptr);
+		void CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+			Vertex* vertices, uint16* indices, ThreadPool* threadPool = nullptr);
+		MeshView CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+			MeshArena& arena, ThreadPool* threadPool = nullptr);
+
 		///<summary>
 		/// Creates an mxn grid in the xz-plane with m rows and n columns, centered
 		/// at the origin with the specified width and depth.
 		///</summary>
 		MeshData CreateGrid(float width, float depth, uint32 m, uint32 n);
 
+		///<summary>
+		/// Same grid, written into caller arrays of at least GetGridSize() elements.
+		/// Rows are filled in parallel when a thread pool is given.
+		///</summary>
+		void CreateGrid(float width, float depth, uint32 m, uint32 n,
+			Vertex* vertices, uint32* indices, ThreadPool* threadPool = nullptr);
+		void CreateGrid(float width, float depth, uint32 m, uint32 n,
+			Vertex* vertices, uint16* indices, ThreadPool* threadPool = nullptr);
+		MeshView CreateGrid(float width, float depth, uint32 m, uint32 n,
+			MeshArena& arena, ThreadPool* threadPool = nullptr);
+
+		///<summary>
+		/// Streams the same grid as tiles of at most tileQuads x tileQuads quads,
+		/// calling onTile once per tile. A skirtDepth above zero hangs a skirt
+		/// that deep below every tile edge to hide cracks between tiles of
+		/// different detail. Each worker reuses one tile-sized buffer, so memory
+		/// stays bounded however large the grid; with a thread pool onTile runs
+		/// concurrently, in no particular tile order.
+		///</summary>
+		void CreateGridTiles(float width, float depth, uint32 m, uint32 n, uint32 tileQuads, float skirtDepth,
+			const std::function<void(const GridTile&)>& onTile, ThreadPool* threadPool = nullptr);
+
 		///<summary>
 		/// Creates a quad aligned with the screen.  This is useful for postprocessing and screen effects.
 		///</summary>
@@ -115,7 +211,22 @@ namespace DX
 	private:
 		void Subdivide(MeshData& meshData);
 		Vertex MidPoint(const Vertex& v0, const Vertex& v1);
-		void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
-		void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
+		template <class Index>
+		void BuildSphere(float radius, uint32 sliceCount, uint32 stackCount,
+			Vertex* vertices, Index* indices, ThreadPool* threadPool);
+		template <class Index>
+		void BuildCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount,
+			Vertex* vertices, Index* indices, ThreadPool* threadPool);
+		template <class Index>
+		void BuildCylinderTopCap(float topRadius, float height, uint32 sliceCount,
+			uint32 baseIndex, Vertex* vertices, Index* indices);
+		template <class Index>
+		void BuildCylinderBottomCap(float bottomRadius, float height, uint32 sliceCount,
+			uint32 baseIndex, Vertex* vertices, Index* indices);
+		template <class Index>
+		void BuildGrid(float width, float depth, uint32 m, uint32 n,
+			Vertex* vertices, Index* indices, ThreadPool* threadPool);
+		void BuildGridTile(float width, float depth, uint32 m, uint32 n, uint32 tileQuads, float skirtDepth,
+			uint32 tileRow, uint32 tileCol, std::vector<Vertex>& vertices, std::vector<uint32>& indices, GridTile& tile);
 	};
 }
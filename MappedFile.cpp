@@ -0,0 +1,191 @@
+#include "MappedFile.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+DX::MappedFile::MappedFile(const std::filesystem::path& path, const Mode mode) :
+	mMode(mode)
+{
+#if defined(_WIN32)
+	const bool write = mode == Mode::Write;
+	mFile = CreateFileW(path.c_str(),
+		write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+		FILE_SHARE_READ, nullptr,
+		write ? CREATE_ALWAYS : OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		mFile = nullptr;
+		throw std::runtime_error("MappedFile: cannot open " + path.string());
+	}
+
+	if (!write)
+	{
+		LARGE_INTEGER size{};
+		GetFileSizeEx(mFile, &size);
+		mSize = static_cast<size_t>(size.QuadPart);
+	}
+#else
+	mFile = mode == Mode::Write ?
+		open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) :
+		open(path.c_str(), O_RDONLY);
+	if (mFile < 0)
+	{
+		throw std::runtime_error("MappedFile: cannot open " + path.string());
+	}
+
+	if (mode == Mode::Read)
+	{
+		struct stat info{};
+		fstat(mFile, &info);
+		mSize = static_cast<size_t>(info.st_size);
+	}
+#endif
+
+	// An empty file cannot be mapped; GetData() stays null then. The
+	// destructor does not run when the constructor throws, so the file
+	// is closed here.
+	if (mode == Mode::Read && mSize > 0)
+	{
+		try
+		{
+			Map(mSize);
+		}
+		catch (...)
+		{
+			Close();
+			throw;
+		}
+	}
+}
+
+DX::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+void DX::MappedFile::Close()
+{
+	Unmap();
+
+#if defined(_WIN32)
+	if (mFile != nullptr)
+	{
+		if (mMode == Mode::Write)
+		{
+			LARGE_INTEGER size{};
+			size.QuadPart = static_cast<LONGLONG>(mSize);
+			SetFilePointerEx(mFile, size, nullptr, FILE_BEGIN);
+			SetEndOfFile(mFile);
+		}
+		CloseHandle(mFile);
+		mFile = nullptr;
+	}
+#else
+	if (mFile >= 0)
+	{
+		if (mMode == Mode::Write)
+		{
+			(void)ftruncate(mFile, static_cast<off_t>(mSize));
+		}
+		close(mFile);
+		mFile = -1;
+	}
+#endif
+}
+
+std::uint8_t* DX::MappedFile::Append(const void* data, const size_t size)
+{
+	if (mMode != Mode::Write)
+	{
+		throw std::runtime_error("MappedFile: append to a read-only file");
+	}
+
+	if (mSize + size > mCapacity)
+	{
+		const size_t needed = mSize + size;
+		Unmap();
+		Map((needed + GROWTH_CHUNK - 1) / GROWTH_CHUNK * GROWTH_CHUNK);
+	}
+
+	std::uint8_t* dest = mData + mSize;
+	std::memcpy(dest, data, size);
+	mSize += size;
+	return dest;
+}
+
+void DX::MappedFile::Flush()
+{
+	if (mData == nullptr) return;
+
+#if defined(_WIN32)
+	FlushViewOfFile(mData, mSize);
+#else
+	msync(mData, mSize, MS_ASYNC);
+#endif
+}
+
+void DX::MappedFile::Map(const size_t capacity)
+{
+	const bool write = mMode == Mode::Write;
+
+#if defined(_WIN32)
+	const auto size = static_cast<ULONGLONG>(capacity);
+	mMapping = CreateFileMappingW(mFile, nullptr, write ? PAGE_READWRITE : PAGE_READONLY,
+		static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xffffffffu), nullptr);
+	if (mMapping == nullptr)
+	{
+		throw std::runtime_error("MappedFile: cannot create mapping");
+	}
+
+	mData = static_cast<std::uint8_t*>(MapViewOfFile(mMapping,
+		write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, capacity));
+#else
+	// Growing the file first; mapping past its end would fault on access.
+	if (write && ftruncate(mFile, static_cast<off_t>(capacity)) != 0)
+	{
+		throw std::runtime_error("MappedFile: cannot grow file");
+	}
+
+	void* data = mmap(nullptr, capacity, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, mFile, 0);
+	mData = data == MAP_FAILED ? nullptr : static_cast<std::uint8_t*>(data);
+#endif
+
+	if (mData == nullptr)
+	{
+		throw std::runtime_error("MappedFile: cannot map view");
+	}
+	mCapacity = capacity;
+}
+
+void DX::MappedFile::Unmap()
+{
+	if (mData != nullptr)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(mData);
+#else
+		munmap(mData, mCapacity);
+#endif
+		mData = nullptr;
+	}
+
+#if defined(_WIN32)
+	if (mMapping != nullptr)
+	{
+		CloseHandle(mMapping);
+		mMapping = nullptr;
+	}
+#endif
+
+	mCapacity = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace DX
+{
+	/**
+	 * \brief A file mapped into memory. Read mode maps an existing file as
+	 * is. Write mode creates or truncates the file and lets it grow through
+	 * Append; the mapping is extended in large chunks so appends stay plain
+	 * memory copies, and the file is cut back to the written size on close.
+	 */
+	class MappedFile
+	{
+	public:
+
+		enum class Mode
+		{
+			Read,
+			Write,
+		};
+
+		// Throws std::runtime_error when the file cannot be opened or mapped.
+		MappedFile(const std::filesystem::path& path, Mode mode);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(const MappedFile&&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&&) = delete;
+		~MappedFile();
+
+		[[nodiscard]] const std::uint8_t* GetData() const { return mData; }
+		[[nodiscard]] size_t GetSize() const { return mSize; }
+
+		// Write mode only. The returned pointer is valid until the next Append.
+		std::uint8_t* Append(const void* data, size_t size);
+		void Flush();
+
+		static constexpr size_t GROWTH_CHUNK = 64ull * 1024 * 1024;
+
+	private:
+		void Map(size_t capacity);
+		void Unmap();
+
+		// Unmaps, cuts a written file back to its size and closes it.
+		void Close();
+
+	private:
+		Mode mMode;
+		std::uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		size_t mCapacity = 0;
+
+#if defined(_WIN32)
+		void* mFile = nullptr;
+		void* mMapping = nullptr;
+#else
+		int mFile = -1;
+#endif
+	};
+}
@@ -3,12 +3,165 @@
 //***************************************************************************************
 
 #include "MathHelper.h"
+#include "CpuFeatures.h"
+#include <atomic>
 #include <cfloat>
 #include <cmath>
 
 constexpr float DX::MathHelper::Infinity = FLT_MAX;
 constexpr float DX::MathHelper::Pi = DirectX::XM_PI;
 
+namespace
+{
+	using DX::BatchIsa;
+	using DX::MatrixSoa;
+	namespace MatrixBatch = DX::MatrixBatch;
+
+	struct ScalarLane
+	{
+		static constexpr size_t WIDTH = 1;
+
+		static ScalarLane Load(const float* p) { return { *p }; }
+		static ScalarLane Broadcast(const float x) { return { x }; }
+		void Store(float* p) const { *p = Value; }
+
+		float Value;
+	};
+
+	ScalarLane operator+(const ScalarLane a, const ScalarLane b) { return { a.Value + b.Value }; }
+	ScalarLane operator-(const ScalarLane a, const ScalarLane b) { return { a.Value - b.Value }; }
+	ScalarLane operator*(const ScalarLane a, const ScalarLane b) { return { a.Value * b.Value }; }
+	ScalarLane operator/(const ScalarLane a, const ScalarLane b) { return { a.Value / b.Value }; }
+
+	constexpr MatrixBatch::Kernels SCALAR_KERNELS = MatrixBatch::MakeKernels<ScalarLane>();
+
+	BatchIsa DetectIsa()
+	{
+		const DX::CpuFeatures& features = DX::GetCpuFeatures();
+		return features.Avx512 ? BatchIsa::Avx512 : features.Avx2 ? BatchIsa::Avx2 : BatchIsa::Scalar;
+	}
+
+	// The best path both supported and built, at or below limit.
+	BatchIsa SelectIsa(const BatchIsa limit)
+	{
+		if (limit >= BatchIsa::Avx512 && MatrixBatch::GetAvx512Kernels() != nullptr) return BatchIsa::Avx512;
+		if (limit >= BatchIsa::Avx2 && MatrixBatch::GetAvx2Kernels() != nullptr) return BatchIsa::Avx2;
+		return BatchIsa::Scalar;
+	}
+
+	const BatchIsa gSupportedIsa = SelectIsa(DetectIsa());
+	std::atomic<BatchIsa> gBatchIsa = gSupportedIsa;
+
+	const MatrixBatch::Kernels* GetKernels()
+	{
+		switch (gBatchIsa.load(std::memory_order_relaxed))
+		{
+		case BatchIsa::Avx512: return MatrixBatch::GetAvx512Kernels();
+		case BatchIsa::Avx2: return MatrixBatch::GetAvx2Kernels();
+		default: return &SCALAR_KERNELS;
+		}
+	}
+
+	MatrixSoa Offset(const MatrixSoa& soa, const size_t first)
+	{
+		return { soa.Data + first, soa.Stride };
+	}
+}
+
+DX::TransformClass XM_CALLCONV DX::MathHelper::ClassifyTransform(const DirectX::FXMMATRIX M)
+{
+	using namespace DirectX;
+
+	const XMVECTOR lastColumn = XMVectorSet(XMVectorGetW(M.r[0]), XMVectorGetW(M.r[1]), XMVectorGetW(M.r[2]), XMVectorGetW(M.r[3]));
+	if (!XMVector4Equal(lastColumn, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f))) return TransformClass::General;
+
+	const float scaleSq = XMVectorGetX(XMVector3LengthSq(M.r[0]));
+	if (!(scaleSq > 0.0f)) return TransformClass::Affine;
+
+	// Squared lengths and dot products both scale with scaleSq.
+	const float tolerance = TRANSFORM_TOLERANCE * scaleSq;
+	const bool orthogonal =
+		std::fabs(XMVectorGetX(XMVector3Dot(M.r[0], M.r[1]))) <= tolerance &&
+		std::fabs(XMVectorGetX(XMVector3Dot(M.r[0], M.r[2]))) <= tolerance &&
+		std::fabs(XMVectorGetX(XMVector3Dot(M.r[1], M.r[2]))) <= tolerance;
+	const bool uniform =
+		std::fabs(XMVectorGetX(XMVector3LengthSq(M.r[1])) - scaleSq) <= tolerance &&
+		std::fabs(XMVectorGetX(XMVector3LengthSq(M.r[2])) - scaleSq) <= tolerance;
+	if (!orthogonal || !uniform) return TransformClass::Affine;
+
+	return std::fabs(scaleSq - 1.0f) <= TRANSFORM_TOLERANCE ? TransformClass::Rigid : TransformClass::UniformScale;
+}
+
+DirectX::XMMATRIX XM_CALLCONV DX::MathHelper::InverseTranspose(const DirectX::FXMMATRIX M, const TransformClass transformClass)
+{
+	using namespace DirectX;
+
+	XMMATRIX A = M;
+	A.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	switch (transformClass)
+	{
+	case TransformClass::Rigid:
+		return A;
+
+	case TransformClass::UniformScale:
+	{
+		const XMVECTOR invScaleSq = XMVectorReciprocal(XMVector3LengthSq(A.r[0]));
+		A.r[0] *= invScaleSq;
+		A.r[1] *= invScaleSq;
+		A.r[2] *= invScaleSq;
+		return A;
+	}
+
+	case TransformClass::Affine:
+	{
+		// Row-vector A times the cofactor rows transposed is det * I.
+		const XMVECTOR c0 = XMVector3Cross(A.r[1], A.r[2]);
+		const XMVECTOR c1 = XMVector3Cross(A.r[2], A.r[0]);
+		const XMVECTOR c2 = XMVector3Cross(A.r[0], A.r[1]);
+		const XMVECTOR invDet = XMVectorReciprocal(XMVector3Dot(A.r[0], c0));
+		A.r[0] = c0 * invDet;
+		A.r[1] = c1 * invDet;
+		A.r[2] = c2 * invDet;
+		return A;
+	}
+
+	default:
+		return InverseTranspose(M);
+	}
+}
+
+void DX::MathHelper::MultiplyBatch(const MatrixSoa& a, const MatrixSoa& b, const MatrixSoa& out, const size_t count)
+{
+	const size_t done = GetKernels()->Multiply(a, b, out, count);
+	SCALAR_KERNELS.Multiply(Offset(a, done), Offset(b, done), Offset(out, done), count - done);
+}
+
+void XM_CALLCONV DX::MathHelper::MultiplyBatch(const MatrixSoa& a, const DirectX::FXMMATRIX m, const MatrixSoa& out, const size_t count)
+{
+	DirectX::XMFLOAT4X4 values;
+	DirectX::XMStoreFloat4x4(&values, m);
+
+	const size_t done = GetKernels()->MultiplyBy(a, &values.m[0][0], out, count);
+	SCALAR_KERNELS.MultiplyBy(Offset(a, done), &values.m[0][0], Offset(out, done), count - done);
+}
+
+void DX::MathHelper::InverseTransposeBatch(const MatrixSoa& m, const MatrixSoa& out, const size_t count)
+{
+	const size_t done = GetKernels()->InverseTranspose(m, out, count);
+	SCALAR_KERNELS.InverseTranspose(Offset(m, done), Offset(out, done), count - done);
+}
+
+DX::BatchIsa DX::MathHelper::GetBatchIsa()
+{
+	return gBatchIsa.load(std::memory_order_relaxed);
+}
+
+void DX::MathHelper::SetBatchIsa(const BatchIsa isa)
+{
+	gBatchIsa.store(isa < gSupportedIsa ? isa : gSupportedIsa, std::memory_order_relaxed);
+}
+
 //float MathHelper::AngleFromXY(float x, float y)
 //{
 //	float theta = 0.0f;
@@ -10,26 +10,41 @@
 #include <DirectXMath.h>
 #include <cstdint>
 
+#include "MatrixBatch.h"
+#include "Random.h"
+
 namespace DX
 {
+	// What a transform does to directions, which decides how cheaply its
+	// inverse-transpose can be had. Affine and the classes below it have
+	// (0, 0, 0, 1) as their last column.
+	enum class TransformClass : int
+	{
+		Rigid = 0,		// rotation, reflection and translation
+		UniformScale,	// a rigid transform scaled by the same factor on every axis
+		Affine,			// any other 3x3 part
+		General,		// projective
+	};
+
 	class MathHelper
 	{
 	public:
 		// Returns random float in [0, 1).
 		static float RandF()
 		{
-			return (float)(rand()) / (float)RAND_MAX;
+			return Random::ThreadLocal().NextFloat();
 		}
 
 		// Returns random float in [a, b).
 		static float RandF(float a, float b)
 		{
-			return a + RandF() * (b - a);
+			return Random::ThreadLocal().NextFloat(a, b);
 		}
 
+		// Returns random int in [a, b].
 		static int Rand(int a, int b)
 		{
-			return a + rand() % ((b - a) + 1);
+			return Random::ThreadLocal().NextInt(a, b);
 		}
 
 		template<typename T>
@@ -79,6 +94,57 @@ namespace DX
 			return XMMatrixTranspose(XMMatrixInverse(nullptr, A));
 		}
 
+		// Batch forms for arrays of matrices, run with AVX-512, AVX2 or scalar
+		// code depending on the processor. All paths evaluate the same
+		// expressions in the same order. out may be one of the inputs.
+
+		// out[i] = a[i] * b[i].
+		static void MultiplyBatch(const MatrixSoa& a, const MatrixSoa& b, const MatrixSoa& out, size_t count);
+
+		// out[i] = a[i] * m, such as world matrices by the view-projection.
+		static void XM_CALLCONV MultiplyBatch(const MatrixSoa& a, DirectX::FXMMATRIX m, const MatrixSoa& out, size_t count);
+
+		// out[i] = InverseTranspose(m[i]).
+		static void InverseTransposeBatch(const MatrixSoa& m, const MatrixSoa& out, size_t count);
+
+		// The path the batch functions take. SetBatchIsa can only lower it
+		// from what the processor supports, for comparing the paths.
+		static BatchIsa GetBatchIsa();
+		static void SetBatchIsa(BatchIsa isa);
+
+		static void StoreSoa(const MatrixSoa& soa, const size_t i, const DirectX::XMFLOAT4X4& m)
+		{
+			for (size_t k = 0; k < 16; ++k) soa.Data[k * soa.Stride + i] = m.m[k / 4][k % 4];
+		}
+
+		static DirectX::XMFLOAT4X4 LoadSoa(const MatrixSoa& soa, const size_t i)
+		{
+			DirectX::XMFLOAT4X4 m;
+			for (size_t k = 0; k < 16; ++k) m.m[k / 4][k % 4] = soa.Data[k * soa.Stride + i];
+			return m;
+		}
+
+		// LoadSoa followed by a transpose, as constant buffers want them.
+		static DirectX::XMFLOAT4X4 LoadSoaTransposed(const MatrixSoa& soa, const size_t i)
+		{
+			DirectX::XMFLOAT4X4 m;
+			for (size_t k = 0; k < 16; ++k) m.m[k % 4][k / 4] = soa.Data[k * soa.Stride + i];
+			return m;
+		}
+
+		// Rows of the 3x3 part count as orthogonal and of equal length within
+		// a relative TRANSFORM_TOLERANCE, so transforms built from rotations
+		// and scales in floats classify as intended. The closed forms then
+		// carry errors of that order; normals are renormalized anyway.
+		static constexpr float TRANSFORM_TOLERANCE = 1e-4f;
+
+		static TransformClass XM_CALLCONV ClassifyTransform(DirectX::FXMMATRIX M);
+
+		// InverseTranspose for a matrix of a known class: the 3x3 part
+		// itself when rigid, divided by the squared scale when uniformly
+		// scaled, and its cofactors over the determinant when affine.
+		static DirectX::XMMATRIX XM_CALLCONV InverseTranspose(DirectX::FXMMATRIX M, TransformClass transformClass);
+
 		static DirectX::XMFLOAT4X4 XM_CALLCONV Identity4x4()
 		{
 			static DirectX::XMFLOAT4X4 identity(
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+	// 4x4 matrices stored element-major, so that one element of consecutive
+	// matrices is contiguous: element (r, c) of matrix i is at
+	// Data[(r * 4 + c) * Stride + i]. Stride is at least the matrix count.
+	struct MatrixSoa
+	{
+		float* Data = nullptr;
+		size_t Stride = 0;
+	};
+
+	enum class BatchIsa : int
+	{
+		Scalar = 0,
+		Avx2,
+		Avx512,
+	};
+
+	namespace MatrixBatch
+	{
+		// The kernels are written once over a lane type V that holds V::WIDTH
+		// floats and provides Load, Store, Broadcast and + - * /. They are
+		// instantiated for plain floats in MathHelper.cpp and for vectors in
+		// MatrixBatchAvx2.cpp and MatrixBatchAvx512.cpp, which are built with
+		// those instruction sets. Everything in this header must stay a
+		// template over V: an inline function compiled in one of those files
+		// could be the copy the linker keeps for the whole program.
+		//
+		// Each kernel handles whole groups of V::WIDTH matrices and returns
+		// how many it did; the caller finishes the rest with the scalar ones.
+		// All loads of a group come before its stores, so out may be an input.
+		struct Kernels
+		{
+			size_t (*Multiply)(const MatrixSoa& a, const MatrixSoa& b, const MatrixSoa& out, size_t count);
+			size_t (*MultiplyBy)(const MatrixSoa& a, const float* m, const MatrixSoa& out, size_t count);
+			size_t (*InverseTranspose)(const MatrixSoa& m, const MatrixSoa& out, size_t count);
+		};
+
+		// nullptr when the file was built without the instruction set. Only
+		// call these once the processor is known to support it.
+		const Kernels* GetAvx2Kernels();
+		const Kernels* GetAvx512Kernels();
+
+		template <class V>
+		void LoadLanes(const MatrixSoa& m, const size_t i, V* lanes)
+		{
+			for (size_t k = 0; k < 16; ++k) lanes[k] = V::Load(m.Data + k * m.Stride + i);
+		}
+
+		template <class V>
+		void StoreLanes(const V* lanes, const MatrixSoa& m, const size_t i)
+		{
+			for (size_t k = 0; k < 16; ++k) lanes[k].Store(m.Data + k * m.Stride + i);
+		}
+
+		template <class V>
+		void MultiplyLanes(const V* a, const V* b, V* out)
+		{
+			for (size_t r = 0; r < 4; ++r)
+			{
+				const V* row = a + r * 4;
+				for (size_t c = 0; c < 4; ++c)
+				{
+					out[r * 4 + c] = (row[0] * b[c] + row[1] * b[4 + c]) + (row[2] * b[8 + c] + row[3] * b[12 + c]);
+				}
+			}
+		}
+
+		template <class V>
+		size_t Multiply(const MatrixSoa& a, const MatrixSoa& b, const MatrixSoa& out, const size_t count)
+		{
+			size_t i = 0;
+			for (; i + V::WIDTH <= count; i += V::WIDTH)
+			{
+				V ma[16], mb[16], product[16];
+				LoadLanes(a, i, ma);
+				LoadLanes(b, i, mb);
+				MultiplyLanes(ma, mb, product);
+				StoreLanes(product, out, i);
+			}
+			return i;
+		}
+
+		template <class V>
+		size_t MultiplyBy(const MatrixSoa& a, const float* m, const MatrixSoa& out, const size_t count)
+		{
+			V mb[16];
+			for (size_t k = 0; k < 16; ++k) mb[k] = V::Broadcast(m[k]);
+
+			size_t i = 0;
+			for (; i + V::WIDTH <= count; i += V::WIDTH)
+			{
+				V ma[16], product[16];
+				LoadLanes(a, i, ma);
+				MultiplyLanes(ma, mb, product);
+				StoreLanes(product, out, i);
+			}
+			return i;
+		}
+
+		// MathHelper::InverseTranspose: the transposed cofactor expansion of
+		// the inverse, with the translation row taken as (0, 0, 0, 1).
+		template <class V>
+		size_t InverseTranspose(const MatrixSoa& m, const MatrixSoa& out, const size_t count)
+		{
+			const V zero = V::Broadcast(0.0f);
+			const V one = V::Broadcast(1.0f);
+			const V minusOne = V::Broadcast(-1.0f);
+
+			size_t i = 0;
+			for (; i + V::WIDTH <= count; i += V::WIDTH)
+			{
+				V a[16];
+				LoadLanes(m, i, a);
+
+				// 2x2 minors of the top two rows.
+				const V s0 = a[0] * a[5] - a[4] * a[1];
+				const V s1 = a[0] * a[6] - a[4] * a[2];
+				const V s2 = a[0] * a[7] - a[4] * a[3];
+				const V s3 = a[1] * a[6] - a[5] * a[2];
+				const V s4 = a[1] * a[7] - a[5] * a[3];
+				const V s5 = a[2] * a[7] - a[6] * a[3];
+
+				const V det = (s0 * a[10] - s1 * a[9]) + s3 * a[8];
+				const V invDet = one / det;
+				const V negInvDet = minusOne / det;
+
+				V r[16];
+				r[0] = (a[5] * a[10] - a[6] * a[9]) * invDet;
+				r[1] = (a[6] * a[8] - a[4] * a[10]) * invDet;
+				r[2] = (a[4] * a[9] - a[5] * a[8]) * invDet;
+				r[3] = zero;
+				r[4] = (a[2] * a[9] - a[1] * a[10]) * invDet;
+				r[5] = (a[0] * a[10] - a[2] * a[8]) * invDet;
+				r[6] = (a[1] * a[8] - a[0] * a[9]) * invDet;
+				r[7] = zero;
+				r[8] = s3 * invDet;
+				r[9] = s1 * negInvDet;
+				r[10] = s0 * invDet;
+				r[11] = zero;
+				r[12] = ((a[10] * s4 - a[9] * s5) - a[11] * s3) * invDet;
+				r[13] = ((a[8] * s5 - a[10] * s2) + a[11] * s1) * invDet;
+				r[14] = ((a[9] * s2 - a[8] * s4) - a[11] * s0) * invDet;
+				r[15] = one;
+				StoreLanes(r, out, i);
+			}
+			return i;
+		}
+
+		template <class V>
+		constexpr Kernels MakeKernels()
+		{
+			return { &Multiply<V>, &MultiplyBy<V>, &InverseTranspose<V> };
+		}
+	}
+}
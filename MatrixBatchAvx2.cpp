@@ -0,0 +1,35 @@
+#include "MatrixBatch.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+	struct Lanes
+	{
+		static constexpr size_t WIDTH = 8;
+
+		static Lanes Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+		static Lanes Broadcast(const float x) { return { _mm256_set1_ps(x) }; }
+		void Store(float* p) const { _mm256_storeu_ps(p, Value); }
+
+		__m256 Value;
+	};
+
+	Lanes operator+(const Lanes a, const Lanes b) { return { _mm256_add_ps(a.Value, b.Value) }; }
+	Lanes operator-(const Lanes a, const Lanes b) { return { _mm256_sub_ps(a.Value, b.Value) }; }
+	Lanes operator*(const Lanes a, const Lanes b) { return { _mm256_mul_ps(a.Value, b.Value) }; }
+	Lanes operator/(const Lanes a, const Lanes b) { return { _mm256_div_ps(a.Value, b.Value) }; }
+}
+
+const DX::MatrixBatch::Kernels* DX::MatrixBatch::GetAvx2Kernels()
+{
+	static constexpr Kernels KERNELS = MakeKernels<Lanes>();
+	return &KERNELS;
+}
+#else
+const DX::MatrixBatch::Kernels* DX::MatrixBatch::GetAvx2Kernels()
+{
+	return nullptr;
+}
+#endif
@@ -0,0 +1,35 @@
+#include "MatrixBatch.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace
+{
+	struct Lanes
+	{
+		static constexpr size_t WIDTH = 16;
+
+		static Lanes Load(const float* p) { return { _mm512_loadu_ps(p) }; }
+		static Lanes Broadcast(const float x) { return { _mm512_set1_ps(x) }; }
+		void Store(float* p) const { _mm512_storeu_ps(p, Value); }
+
+		__m512 Value;
+	};
+
+	Lanes operator+(const Lanes a, const Lanes b) { return { _mm512_add_ps(a.Value, b.Value) }; }
+	Lanes operator-(const Lanes a, const Lanes b) { return { _mm512_sub_ps(a.Value, b.Value) }; }
+	Lanes operator*(const Lanes a, const Lanes b) { return { _mm512_mul_ps(a.Value, b.Value) }; }
+	Lanes operator/(const Lanes a, const Lanes b) { return { _mm512_div_ps(a.Value, b.Value) }; }
+}
+
+const DX::MatrixBatch::Kernels* DX::MatrixBatch::GetAvx512Kernels()
+{
+	static constexpr Kernels KERNELS = MakeKernels<Lanes>();
+	return &KERNELS;
+}
+#else
+const DX::MatrixBatch::Kernels* DX::MatrixBatch::GetAvx512Kernels()
+{
+	return nullptr;
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace DX
+{
+	/**
+	 * \brief Bump allocator for procedural meshes. Arrays are carved out of
+	 * one block reserved up front and released all at once by Reset, so
+	 * building meshes into it costs no further heap allocations.
+	 */
+	class MeshArena
+	{
+	public:
+
+		explicit MeshArena(size_t byteCapacity) :
+			mBuffer(new std::byte[byteCapacity]), mCapacity(byteCapacity) {}
+		MeshArena(const MeshArena&) = delete;
+		MeshArena(const MeshArena&&) = delete;
+		MeshArena& operator=(const MeshArena&) = delete;
+		MeshArena& operator=(const MeshArena&&) = delete;
+		~MeshArena() = default;
+
+		[[nodiscard]] auto GetCapacity()  const { return mCapacity; }
+		[[nodiscard]] auto GetUsedBytes() const { return mOffset; }
+
+		// Default-constructs count elements; throws std::bad_alloc once the arena is full.
+		template <class T>
+		T* Allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "Reset never runs destructors.");
+
+			const auto base = reinterpret_cast<std::uintptr_t>(mBuffer.get());
+			const size_t offset = ((base + mOffset + alignof(T) - 1) & ~std::uintptr_t(alignof(T) - 1)) - base;
+			if (offset > mCapacity || count > (mCapacity - offset) / sizeof(T))
+			{
+				throw std::bad_alloc();
+			}
+
+			mOffset = offset + count * sizeof(T);
+			T* elements = reinterpret_cast<T*>(mBuffer.get() + offset);
+			std::uninitialized_default_construct_n(elements, count);
+			return elements;
+		}
+
+		// Invalidates everything allocated so far.
+		void Reset() { mOffset = 0; }
+
+	private:
+		std::unique_ptr<std::byte[]> mBuffer;
+		size_t mCapacity;
+		size_t mOffset = 0;
+	};
+}
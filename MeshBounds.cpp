@@ -0,0 +1,105 @@
+#include "MeshBounds.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMFLOAT3* PositionAt(const XMFLOAT3* positions, const size_t stride, const size_t i)
+	{
+		return reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const std::uint8_t*>(positions) + i * stride);
+	}
+
+	template <class Index>
+	void IndexRange(const Index* indices, const size_t count, std::uint32_t& first, std::uint32_t& last)
+	{
+		// A plain loop, which compilers turn into packed min/max.
+		Index minIndex = indices[0];
+		Index maxIndex = indices[0];
+		for (size_t i = 1; i < count; ++i)
+		{
+			minIndex = std::min(minIndex, indices[i]);
+			maxIndex = std::max(maxIndex, indices[i]);
+		}
+		first = minIndex;
+		last = maxIndex;
+	}
+}
+
+DX::MeshBounds DX::ComputeBounds(const XMFLOAT3* positions, const size_t count, const size_t stride)
+{
+	MeshBounds bounds;
+	if (count == 0) return bounds;
+
+	// Four min/max pairs in flight hide the latency of each comparison.
+	XMVECTOR min[4];
+	XMVECTOR max[4];
+	for (int k = 0; k < 4; ++k) min[k] = max[k] = XMLoadFloat3(positions);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		for (int k = 0; k < 4; ++k)
+		{
+			const XMVECTOR p = XMLoadFloat3(PositionAt(positions, stride, i + k));
+			min[k] = XMVectorMin(min[k], p);
+			max[k] = XMVectorMax(max[k], p);
+		}
+	}
+	for (; i < count; ++i)
+	{
+		const XMVECTOR p = XMLoadFloat3(PositionAt(positions, stride, i));
+		min[0] = XMVectorMin(min[0], p);
+		max[0] = XMVectorMax(max[0], p);
+	}
+
+	const XMVECTOR boxMin = XMVectorMin(XMVectorMin(min[0], min[1]), XMVectorMin(min[2], min[3]));
+	const XMVECTOR boxMax = XMVectorMax(XMVectorMax(max[0], max[1]), XMVectorMax(max[2], max[3]));
+	const XMVECTOR center = 0.5f * (boxMin + boxMax);
+	XMStoreFloat3(&bounds.Box.Center, center);
+	XMStoreFloat3(&bounds.Box.Extents, 0.5f * (boxMax - boxMin));
+
+	XMVECTOR radiusSq[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		for (int k = 0; k < 4; ++k)
+		{
+			const XMVECTOR p = XMLoadFloat3(PositionAt(positions, stride, i + k));
+			radiusSq[k] = XMVectorMax(radiusSq[k], XMVector3LengthSq(p - center));
+		}
+	}
+	for (; i < count; ++i)
+	{
+		const XMVECTOR p = XMLoadFloat3(PositionAt(positions, stride, i));
+		radiusSq[0] = XMVectorMax(radiusSq[0], XMVector3LengthSq(p - center));
+	}
+
+	bounds.Sphere.Center = bounds.Box.Center;
+	bounds.Sphere.Radius = XMVectorGetX(XMVectorSqrt(
+		XMVectorMax(XMVectorMax(radiusSq[0], radiusSq[1]), XMVectorMax(radiusSq[2], radiusSq[3]))));
+	return bounds;
+}
+
+DX::MeshBounds DX::ComputePartBounds(const void* vertexData, const size_t vertexStride, const size_t positionOffset,
+	const void* indexData, const size_t indexStride, const MeshPart& part)
+{
+	assert(indexStride == sizeof(std::uint16_t) || indexStride == sizeof(std::uint32_t));
+	if (part.IndexCount == 0) return {};
+
+	std::uint32_t first = 0;
+	std::uint32_t last = 0;
+	if (indexStride == sizeof(std::uint16_t))
+	{
+		IndexRange(static_cast<const std::uint16_t*>(indexData) + part.StartIndexLocation, part.IndexCount, first, last);
+	}
+	else
+	{
+		IndexRange(static_cast<const std::uint32_t*>(indexData) + part.StartIndexLocation, part.IndexCount, first, last);
+	}
+
+	const auto* vertices = static_cast<const std::uint8_t*>(vertexData) +
+		(static_cast<std::int64_t>(part.BaseVertexLocation) + first) * vertexStride;
+	return ComputeBounds(reinterpret_cast<const XMFLOAT3*>(vertices + positionOffset), last - first + 1, vertexStride);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+
+#include "MeshPackaging.h"
+
+namespace DX
+{
+	// Object-space bounds of a mesh or of one of its parts. The sphere is
+	// centred on the box, which keeps both to two streaming passes.
+	struct MeshBounds
+	{
+		DirectX::BoundingBox Box{};
+		DirectX::BoundingSphere Sphere{};
+	};
+
+	// Bounds of count positions spaced stride bytes apart, so positions can
+	// point at the first member of any interleaved vertex. Cheap enough to
+	// run on dynamic meshes every frame.
+	[[nodiscard]] MeshBounds ComputeBounds(const DirectX::XMFLOAT3* positions, size_t count,
+		size_t stride = sizeof(DirectX::XMFLOAT3));
+
+	// Bounds of the vertices a part of an indexed mesh draws from: the range
+	// between its smallest and largest index, offset by BaseVertexLocation.
+	// positionOffset is where the position sits inside a vertex.
+	[[nodiscard]] MeshBounds ComputePartBounds(const void* vertexData, size_t vertexStride, size_t positionOffset,
+		const void* indexData, size_t indexStride, const MeshPart& part);
+}
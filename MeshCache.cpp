@@ -0,0 +1,225 @@
+#include "MeshCache.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+	using uint64 = std::uint64_t;
+
+	// 64-bit FNV-1a.
+	constexpr uint64 FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	constexpr uint64 FNV_PRIME = 0x100000001b3ull;
+
+	uint64 AlignUp(const uint64 offset)
+	{
+		return (offset + DX::MESH_CACHE_ALIGNMENT - 1) / DX::MESH_CACHE_ALIGNMENT * DX::MESH_CACHE_ALIGNMENT;
+	}
+
+	bool IsSectionInside(const uint64 offset, const uint64 size, const uint64 fileSize)
+	{
+		return offset % DX::MESH_CACHE_ALIGNMENT == 0 && offset <= fileSize && size <= fileSize - offset;
+	}
+
+	bool IsPartInside(const DX::MeshPart& part, const DX::MeshCacheHeader& header)
+	{
+		return uint64(part.StartIndexLocation) + part.IndexCount <= header.IndexCount &&
+			part.BaseVertexLocation >= 0 && uint64(part.BaseVertexLocation) < header.VertexCount;
+	}
+
+	// FNV-1a over 64-bit words instead of bytes, so checking a large mesh
+	// costs little next to uploading it. The tail is zero-padded.
+	uint64 HashSection(uint64 hash, const void* data, const size_t size)
+	{
+		const auto* bytes = static_cast<const std::uint8_t*>(data);
+		size_t i = 0;
+		for (; i + sizeof(uint64) <= size; i += sizeof(uint64))
+		{
+			uint64 word;
+			std::memcpy(&word, bytes + i, sizeof(word));
+			hash = (hash ^ word) * FNV_PRIME;
+		}
+		if (i < size)
+		{
+			uint64 word = 0;
+			std::memcpy(&word, bytes + i, size - i);
+			hash = (hash ^ word) * FNV_PRIME;
+		}
+		return hash;
+	}
+
+	std::uint32_t ComputeChecksum(const DX::MeshCacheData& data)
+	{
+		uint64 hash = FNV_OFFSET_BASIS;
+		hash = HashSection(hash, data.VertexData, data.GetVertexBufferByteSize());
+		hash = HashSection(hash, data.IndexData, data.GetIndexBufferByteSize());
+		hash = HashSection(hash, data.Parts, data.PartCount * sizeof(DX::MeshPart));
+		return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+	}
+}
+
+DX::MeshCacheKey::MeshCacheKey(const std::string_view generator) :
+	mHash(FNV_OFFSET_BASIS)
+{
+	const std::uint32_t version = MESH_CACHE_VERSION;
+	Add(&version, sizeof(version));
+	Add(generator.data(), generator.size());
+}
+
+DX::MeshCacheKey& DX::MeshCacheKey::Add(const void* data, const size_t size)
+{
+	const auto* bytes = static_cast<const std::uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		mHash = (mHash ^ bytes[i]) * FNV_PRIME;
+	}
+	return *this;
+}
+
+std::string DX::MeshCacheKey::GetFileName() const
+{
+	static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+	std::string name(16, '0');
+	for (int i = 0; i < 16; ++i)
+	{
+		name[15 - i] = HEX_DIGITS[(mHash >> (i * 4)) & 0xf];
+	}
+	return name + ".mesh";
+}
+
+DX::MeshCacheEntry::MeshCacheEntry(const std::filesystem::path& path, const MeshCacheKey& key) :
+	mFile(path, MappedFile::Mode::Read)
+{
+	const std::uint8_t* file = mFile.GetData();
+	const uint64 fileSize = mFile.GetSize();
+
+	MeshCacheHeader header;
+	if (fileSize < sizeof(header))
+	{
+		throw std::runtime_error("MeshCacheEntry: truncated " + path.string());
+	}
+	std::memcpy(&header, file, sizeof(header));
+
+	if (header.Magic != MESH_CACHE_MAGIC || header.Version != MESH_CACHE_VERSION || header.Key != key.GetHash())
+	{
+		throw std::runtime_error("MeshCacheEntry: stale entry " + path.string());
+	}
+
+	if (header.IndexStride != sizeof(std::uint16_t) && header.IndexStride != sizeof(std::uint32_t))
+	{
+		throw std::runtime_error("MeshCacheEntry: corrupt entry " + path.string());
+	}
+
+	const uint64 vertexBytes = uint64(header.VertexStride) * header.VertexCount;
+	const uint64 indexBytes = uint64(header.IndexStride) * header.IndexCount;
+	const uint64 partBytes = uint64(header.PartCount) * sizeof(MeshPart);
+	if (!IsSectionInside(header.VertexOffset, vertexBytes, fileSize) ||
+		!IsSectionInside(header.IndexOffset, indexBytes, fileSize) ||
+		!IsSectionInside(header.PartOffset, partBytes, fileSize))
+	{
+		throw std::runtime_error("MeshCacheEntry: corrupt entry " + path.string());
+	}
+
+	mData.VertexData = file + header.VertexOffset;
+	mData.VertexStride = header.VertexStride;
+	mData.VertexCount = header.VertexCount;
+	mData.IndexData = file + header.IndexOffset;
+	mData.IndexStride = header.IndexStride;
+	mData.IndexCount = header.IndexCount;
+	mData.Parts = reinterpret_cast<const MeshPart*>(file + header.PartOffset);
+	mData.PartCount = header.PartCount;
+
+	for (std::uint32_t i = 0; i < mData.PartCount; ++i)
+	{
+		if (!IsPartInside(mData.Parts[i], header))
+		{
+			throw std::runtime_error("MeshCacheEntry: corrupt entry " + path.string());
+		}
+	}
+
+	if (ComputeChecksum(mData) != header.Checksum)
+	{
+		throw std::runtime_error("MeshCacheEntry: checksum mismatch " + path.string());
+	}
+}
+
+DX::MeshCache::MeshCache(std::filesystem::path directory) :
+	mDirectory(std::move(directory))
+{
+}
+
+std::unique_ptr<DX::MeshCacheEntry> DX::MeshCache::Find(const MeshCacheKey& key) const
+{
+	const std::filesystem::path path = mDirectory / key.GetFileName();
+
+	std::error_code error;
+	if (!std::filesystem::is_regular_file(path, error)) return nullptr;
+
+	try
+	{
+		return std::make_unique<MeshCacheEntry>(path, key);
+	}
+	catch (const std::runtime_error&)
+	{
+		return nullptr;
+	}
+}
+
+bool DX::MeshCache::Store(const MeshCacheKey& key, const MeshCacheData& data) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(mDirectory, error);
+	if (error) return false;
+
+	const std::filesystem::path path = mDirectory / key.GetFileName();
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+
+	assert(data.IndexStride == sizeof(std::uint16_t) || data.IndexStride == sizeof(std::uint32_t));
+
+	MeshCacheHeader header;
+	header.Key = key.GetHash();
+	header.VertexStride = data.VertexStride;
+	header.VertexCount = data.VertexCount;
+	header.IndexStride = data.IndexStride;
+	header.IndexCount = data.IndexCount;
+	header.PartCount = data.PartCount;
+	header.Checksum = ComputeChecksum(data);
+	header.VertexOffset = AlignUp(sizeof(header));
+	header.IndexOffset = AlignUp(header.VertexOffset + data.GetVertexBufferByteSize());
+	header.PartOffset = AlignUp(header.IndexOffset + data.GetIndexBufferByteSize());
+
+	try
+	{
+		MappedFile file(temporary, MappedFile::Mode::Write);
+		static constexpr std::uint8_t PADDING[MESH_CACHE_ALIGNMENT] = {};
+
+		const auto appendSection = [&file](const uint64 offset, const void* bytes, const size_t size)
+		{
+			file.Append(PADDING, static_cast<size_t>(offset - file.GetSize()));
+			file.Append(bytes, size);
+		};
+
+		file.Append(&header, sizeof(header));
+		appendSection(header.VertexOffset, data.VertexData, data.GetVertexBufferByteSize());
+		appendSection(header.IndexOffset, data.IndexData, data.GetIndexBufferByteSize());
+		appendSection(header.PartOffset, data.Parts, data.PartCount * sizeof(MeshPart));
+		file.Flush();
+	}
+	catch (const std::runtime_error&)
+	{
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
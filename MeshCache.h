@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "MappedFile.h"
+#include "MeshPackaging.h"
+
+namespace DX
+{
+	inline constexpr std::uint32_t MESH_CACHE_MAGIC = 0x4853454d; // "MESH"
+	inline constexpr std::uint32_t MESH_CACHE_VERSION = 2;
+
+	// Sections start on this boundary, so mapped data is aligned for any vertex format.
+	inline constexpr size_t MESH_CACHE_ALIGNMENT = 64;
+
+	/**
+	 * \brief Hash of everything a cached mesh depends on: the generator name
+	 * followed by every parameter it is called with. Callers add a revision
+	 * number of their own and bump it when the generating code changes.
+	 */
+	class MeshCacheKey
+	{
+	public:
+
+		using uint64 = std::uint64_t;
+
+		explicit MeshCacheKey(std::string_view generator);
+
+		MeshCacheKey& Add(const void* data, size_t size);
+
+		template <class T>
+		MeshCacheKey& Add(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "key parameters are hashed by their bytes");
+			return Add(&value, sizeof(T));
+		}
+
+		[[nodiscard]] auto GetHash() const { return mHash; }
+
+		// Sixteen hex digits of the hash with a .mesh extension.
+		[[nodiscard]] std::string GetFileName() const;
+
+	private:
+		uint64 mHash;
+	};
+
+	// Ready-to-upload buffers of one mesh. Index strides of 2 and 4 bytes
+	// match DXGI_FORMAT_R16_UINT and DXGI_FORMAT_R32_UINT.
+	struct MeshCacheData
+	{
+		const void* VertexData = nullptr;
+		std::uint32_t VertexStride = 0;
+		std::uint32_t VertexCount = 0;
+
+		const void* IndexData = nullptr;
+		std::uint32_t IndexStride = 0;
+		std::uint32_t IndexCount = 0;
+
+		const MeshPart* Parts = nullptr;
+		std::uint32_t PartCount = 0;
+
+		[[nodiscard]] size_t GetVertexBufferByteSize() const { return size_t(VertexStride) * VertexCount; }
+		[[nodiscard]] size_t GetIndexBufferByteSize() const { return size_t(IndexStride) * IndexCount; }
+	};
+
+	// File layout: this header, then the vertex, index and part sections at
+	// the offsets it records, each aligned to MESH_CACHE_ALIGNMENT. Checksum
+	// covers the bytes of the three sections, not the padding between them.
+	struct MeshCacheHeader
+	{
+		std::uint32_t Magic = MESH_CACHE_MAGIC;
+		std::uint32_t Version = MESH_CACHE_VERSION;
+		std::uint64_t Key = 0;
+
+		std::uint32_t VertexStride = 0;
+		std::uint32_t VertexCount = 0;
+		std::uint32_t IndexStride = 0;
+		std::uint32_t IndexCount = 0;
+		std::uint32_t PartCount = 0;
+		std::uint32_t Checksum = 0;
+
+		std::uint64_t VertexOffset = 0;
+		std::uint64_t IndexOffset = 0;
+		std::uint64_t PartOffset = 0;
+	};
+
+	static_assert(sizeof(MeshCacheHeader) == 64);
+
+	/**
+	 * \brief One cached mesh, mapped read-only. GetData points straight into
+	 * the mapping, so nothing is parsed or copied, and stays valid for the
+	 * lifetime of the entry.
+	 */
+	class MeshCacheEntry
+	{
+	public:
+
+		// Throws std::runtime_error if the file is not a complete cache entry
+		// for key: a header that does not match, an index stride other than 2
+		// or 4, a part outside the buffers or a checksum mismatch.
+		MeshCacheEntry(const std::filesystem::path& path, const MeshCacheKey& key);
+		MeshCacheEntry(const MeshCacheEntry&) = delete;
+		MeshCacheEntry(const MeshCacheEntry&&) = delete;
+		MeshCacheEntry& operator=(const MeshCacheEntry&) = delete;
+		MeshCacheEntry& operator=(const MeshCacheEntry&&) = delete;
+		~MeshCacheEntry() = default;
+
+		[[nodiscard]] const MeshCacheData& GetData() const { return mData; }
+
+	private:
+		MappedFile mFile;
+		MeshCacheData mData;
+	};
+
+	/**
+	 * \brief Directory of meshes keyed by MeshCacheKey, one file each. A
+	 * missing, stale or damaged file is a miss, and a failed store only
+	 * costs the next launch a rebuild, so the cache never stops the game.
+	 */
+	class MeshCache
+	{
+	public:
+
+		explicit MeshCache(std::filesystem::path directory);
+		MeshCache(const MeshCache&) = delete;
+		MeshCache(const MeshCache&&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+		MeshCache& operator=(const MeshCache&&) = delete;
+		~MeshCache() = default;
+
+		// Null on a miss.
+		[[nodiscard]] std::unique_ptr<MeshCacheEntry> Find(const MeshCacheKey& key) const;
+
+		// Writes to a temporary file first and renames it into place, so a
+		// crash never leaves a half-written entry behind. Returns false if
+		// the entry could not be written.
+		bool Store(const MeshCacheKey& key, const MeshCacheData& data) const;
+
+	private:
+		std::filesystem::path mDirectory;
+	};
+}
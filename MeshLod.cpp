@@ -0,0 +1,455 @@
+#include "MeshLod.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <tuple>
+
+using namespace DirectX;
+using DX::GeometryGenerator;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	// How much more an open border resists moving than the surface does.
+	constexpr double BORDER_WEIGHT = 10.0;
+
+	// Error bits the collapses are bucketed by: the exponent and three mantissa bits.
+	constexpr uint32 SORT_BUCKET_BITS = 11;
+
+	// A level that removes fewer triangles than this fraction is not worth keeping.
+	constexpr float MIN_LEVEL_REDUCTION = 0.05f;
+
+	enum class VertexKind : std::uint8_t
+	{
+		Manifold,
+		// On an open edge; may only slide along it.
+		Border,
+		// Shares its position with another vertex or is not referenced.
+		Locked,
+	};
+
+	// Sum of squared distances to a set of weighted planes.
+	struct Quadric
+	{
+		double A00 = 0.0, A11 = 0.0, A22 = 0.0, A01 = 0.0, A02 = 0.0, A12 = 0.0;
+		double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+		double C = 0.0;
+		double Weight = 0.0;
+
+		void AddPlane(const double n[3], const double d, const double weight)
+		{
+			A00 += weight * n[0] * n[0];
+			A11 += weight * n[1] * n[1];
+			A22 += weight * n[2] * n[2];
+			A01 += weight * n[0] * n[1];
+			A02 += weight * n[0] * n[2];
+			A12 += weight * n[1] * n[2];
+			B0 += weight * n[0] * d;
+			B1 += weight * n[1] * d;
+			B2 += weight * n[2] * d;
+			C += weight * d * d;
+			Weight += weight;
+		}
+
+		Quadric& operator+=(const Quadric& q)
+		{
+			A00 += q.A00; A11 += q.A11; A22 += q.A22;
+			A01 += q.A01; A02 += q.A02; A12 += q.A12;
+			B0 += q.B0; B1 += q.B1; B2 += q.B2;
+			C += q.C;
+			Weight += q.Weight;
+			return *this;
+		}
+
+		[[nodiscard]] double Evaluate(const XMFLOAT3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double error =
+				A00 * x * x + A11 * y * y + A22 * z * z +
+				2.0 * (A01 * x * y + A02 * x * z + A12 * y * z) +
+				2.0 * (B0 * x + B1 * y + B2 * z) + C;
+			return std::max(error, 0.0);
+		}
+	};
+
+	uint64 EdgeKey(const uint32 a, const uint32 b) { return static_cast<uint64>(a) << 32 | b; }
+
+	void Cross(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2, double n[3])
+	{
+		const double u[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+		const double v[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+		n[0] = u[1] * v[2] - u[2] * v[1];
+		n[1] = u[2] * v[0] - u[0] * v[2];
+		n[2] = u[0] * v[1] - u[1] * v[0];
+	}
+
+	// Vertices that share a position with another one sit on a seam of the
+	// attributes; moving one of them alone would tear the surface open.
+	std::vector<VertexKind> ClassifyVertices(const std::vector<GeometryGenerator::Vertex>& vertices,
+		const std::vector<uint32>& indices, const std::vector<uint64>& borderEdges)
+	{
+		const auto vertexCount = static_cast<uint32>(vertices.size());
+		std::vector<VertexKind> kinds(vertexCount, VertexKind::Locked);
+		for (const uint32 v : indices) kinds[v] = VertexKind::Manifold;
+
+		for (const uint64 edge : borderEdges)
+		{
+			kinds[static_cast<uint32>(edge >> 32)] = VertexKind::Border;
+			kinds[static_cast<uint32>(edge)] = VertexKind::Border;
+		}
+
+		std::vector<uint32> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0u);
+
+		const auto position = [&vertices](const uint32 v)
+		{
+			const XMFLOAT3& p = vertices[v].Position;
+			return std::make_tuple(p.x, p.y, p.z);
+		};
+		std::sort(order.begin(), order.end(), [&position](const uint32 a, const uint32 b) { return position(a) < position(b); });
+
+		for (uint32 i = 0; i < vertexCount;)
+		{
+			uint32 j = i + 1;
+			while (j < vertexCount && position(order[j]) == position(order[i])) ++j;
+			if (j - i > 1)
+			{
+				for (uint32 k = i; k < j; ++k) kinds[order[k]] = VertexKind::Locked;
+			}
+			i = j;
+		}
+
+		return kinds;
+	}
+
+	// Directed edges without a twin going the other way.
+	std::vector<uint64> FindBorderEdges(const std::vector<uint32>& indices)
+	{
+		std::vector<uint64> edges;
+		edges.reserve(indices.size());
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			for (int k = 0; k < 3; ++k) edges.push_back(EdgeKey(indices[t + k], indices[t + (k + 1) % 3]));
+		}
+		std::sort(edges.begin(), edges.end());
+
+		std::vector<uint64> border;
+		for (const uint64 edge : edges)
+		{
+			const uint64 twin = edge << 32 | edge >> 32;
+			if (!std::binary_search(edges.begin(), edges.end(), twin)) border.push_back(edge);
+		}
+		return border;
+	}
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::vector<GeometryGenerator::Vertex>& vertices, const std::vector<uint32>& indices) :
+			mVertices(vertices), mQuadrics(vertices.size())
+		{
+			const std::vector<uint64> borderEdges = FindBorderEdges(indices);
+			mKinds = ClassifyVertices(vertices, indices, borderEdges);
+
+			// Face planes weighted by area, so small slivers count for little.
+			for (size_t t = 0; t < indices.size(); t += 3)
+			{
+				double n[3];
+				Cross(Position(indices[t]), Position(indices[t + 1]), Position(indices[t + 2]), n);
+				const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length == 0.0) continue;
+
+				for (double& c : n) c /= length;
+				const XMFLOAT3& p = Position(indices[t]);
+				const double d = -(n[0] * p.x + n[1] * p.y + n[2] * p.z);
+				for (int k = 0; k < 3; ++k) mQuadrics[indices[t + k]].AddPlane(n, d, 0.5 * length);
+			}
+
+			// Planes standing on the open edges keep borders from drifting inwards.
+			for (size_t t = 0; t < indices.size(); t += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					const uint32 a = indices[t + k];
+					const uint32 b = indices[t + (k + 1) % 3];
+					if (!std::binary_search(borderEdges.begin(), borderEdges.end(), EdgeKey(a, b))) continue;
+
+					double faceNormal[3];
+					Cross(Position(indices[t]), Position(indices[t + 1]), Position(indices[t + 2]), faceNormal);
+
+					const XMFLOAT3& pa = Position(a);
+					const XMFLOAT3& pb = Position(b);
+					const double e[3] = { pb.x - pa.x, pb.y - pa.y, pb.z - pa.z };
+					double n[3] = {
+						e[1] * faceNormal[2] - e[2] * faceNormal[1],
+						e[2] * faceNormal[0] - e[0] * faceNormal[2],
+						e[0] * faceNormal[1] - e[1] * faceNormal[0] };
+					const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					if (length == 0.0) continue;
+
+					for (double& c : n) c /= length;
+					const double d = -(n[0] * pa.x + n[1] * pa.y + n[2] * pa.z);
+					const double weight = BORDER_WEIGHT * (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+					mQuadrics[a].AddPlane(n, d, weight);
+					mQuadrics[b].AddPlane(n, d, weight);
+				}
+			}
+		}
+
+		// Collapses edges of indices, cheapest first, until at most
+		// targetTriangles remain or the next one would exceed maxError.
+		// Returns the largest error of any collapse so far.
+		float Simplify(std::vector<uint32>& indices, const size_t targetTriangles, const float maxError)
+		{
+			while (indices.size() / 3 > targetTriangles)
+			{
+				if (!CollapsePass(indices, targetTriangles, maxError)) break;
+			}
+			return mError;
+		}
+
+	private:
+		struct Collapse
+		{
+			uint32 Source;
+			uint32 Target;
+			float Error;
+		};
+
+		[[nodiscard]] const XMFLOAT3& Position(const uint32 v) const { return mVertices[v].Position; }
+
+		// Counting sort on the exponent and top mantissa bits of the error,
+		// which orders collapses to within an eighth of their error and keeps
+		// ties in mesh order. Errors are never negative, so their bit
+		// patterns sort like the values.
+		static std::vector<uint32> SortByError(const std::vector<Collapse>& collapses)
+		{
+			const auto bucketOf = [](const float error)
+			{
+				uint32 bits;
+				std::memcpy(&bits, &error, sizeof(bits));
+				return bits >> (31 - SORT_BUCKET_BITS);
+			};
+
+			std::vector<uint32> offsets((size_t(1) << SORT_BUCKET_BITS) + 1, 0);
+			for (const Collapse& collapse : collapses) ++offsets[bucketOf(collapse.Error) + 1];
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+			std::vector<uint32> order(collapses.size());
+			for (size_t c = 0; c < collapses.size(); ++c) order[offsets[bucketOf(collapses[c].Error)]++] = static_cast<uint32>(c);
+			return order;
+		}
+
+		// Border vertices may only slide along the open edge they sit on.
+		[[nodiscard]] bool CanMove(const uint32 source, const bool borderEdge) const
+		{
+			return mKinds[source] == VertexKind::Manifold || (mKinds[source] == VertexKind::Border && borderEdge);
+		}
+
+		[[nodiscard]] float CollapseError(const uint32 source, const uint32 target) const
+		{
+			Quadric q = mQuadrics[source];
+			q += mQuadrics[target];
+			return q.Weight > 0.0 ? static_cast<float>(std::sqrt(q.Evaluate(Position(target)) / q.Weight)) : 0.0f;
+		}
+
+		// Moving source onto target must not turn any surviving triangle around.
+		[[nodiscard]] bool FlipsTriangle(const std::vector<uint32>& indices, const uint32* triangles, const uint32 count,
+			const uint32 source, const uint32 target) const
+		{
+			for (uint32 i = 0; i < count; ++i)
+			{
+				const uint32* tri = &indices[triangles[i] * 3];
+				if (tri[0] == target || tri[1] == target || tri[2] == target) continue;
+
+				double before[3];
+				Cross(Position(tri[0]), Position(tri[1]), Position(tri[2]), before);
+
+				const uint32 moved[3] = {
+					tri[0] == source ? target : tri[0],
+					tri[1] == source ? target : tri[1],
+					tri[2] == source ? target : tri[2] };
+				double after[3];
+				Cross(Position(moved[0]), Position(moved[1]), Position(moved[2]), after);
+
+				if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0) return true;
+			}
+			return false;
+		}
+
+		// One round of independent collapses: every vertex takes part in at
+		// most one, and none touches the neighbourhood of another.
+		bool CollapsePass(std::vector<uint32>& indices, const size_t targetTriangles, const float maxError)
+		{
+			const auto vertexCount = static_cast<uint32>(mVertices.size());
+			const size_t triangleCount = indices.size() / 3;
+
+			// Triangles around each vertex.
+			std::vector<uint32> offsets(vertexCount + 1, 0);
+			for (const uint32 v : indices) ++offsets[v + 1];
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+			std::vector<uint32> adjacency(indices.size());
+			{
+				std::vector<uint32> cursor(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < indices.size(); ++i) adjacency[cursor[indices[i]]++] = static_cast<uint32>(i / 3);
+			}
+
+			const auto hasEdge = [&](const uint32 from, const uint32 to)
+			{
+				for (uint32 i = offsets[from]; i < offsets[from + 1]; ++i)
+				{
+					const uint32* tri = &indices[adjacency[i] * 3];
+					for (int k = 0; k < 3; ++k)
+					{
+						if (tri[k] == from && tri[(k + 1) % 3] == to) return true;
+					}
+				}
+				return false;
+			};
+
+			// Every edge once, collapsed in its cheaper allowed direction. An
+			// edge without a twin is open and is only seen from one side.
+			std::vector<Collapse> collapses;
+			collapses.reserve(indices.size() / 2);
+			for (size_t t = 0; t < indices.size(); t += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					const uint32 a = indices[t + k];
+					const uint32 b = indices[t + (k + 1) % 3];
+					const bool borderEdge = !hasEdge(b, a);
+					if (a > b && !borderEdge) continue;
+
+					const bool ab = CanMove(a, borderEdge);
+					const bool ba = CanMove(b, borderEdge);
+					if (!ab && !ba) continue;
+
+					const float errorAB = ab ? CollapseError(a, b) : 0.0f;
+					const float errorBA = ba ? CollapseError(b, a) : 0.0f;
+					if (ab && (!ba || errorAB <= errorBA))
+					{
+						collapses.push_back({ a, b, errorAB });
+					}
+					else
+					{
+						collapses.push_back({ b, a, errorBA });
+					}
+				}
+			}
+
+			const std::vector<uint32> order = SortByError(collapses);
+
+			std::vector<uint32> remap(vertexCount);
+			std::iota(remap.begin(), remap.end(), 0u);
+			std::vector<std::uint8_t> touched(vertexCount, 0);
+
+			size_t remaining = triangleCount;
+			bool collapsed = false;
+			for (const uint32 c : order)
+			{
+				const Collapse& collapse = collapses[c];
+				if (remaining <= targetTriangles || collapse.Error > maxError) break;
+
+				const uint32 u = collapse.Source;
+				const uint32 v = collapse.Target;
+				if (touched[u] || touched[v]) continue;
+
+				const uint32* triangles = &adjacency[offsets[u]];
+				const uint32 count = offsets[u + 1] - offsets[u];
+				if (FlipsTriangle(indices, triangles, count, u, v)) continue;
+
+				for (uint32 i = 0; i < count; ++i)
+				{
+					const uint32* tri = &indices[triangles[i] * 3];
+					for (int k = 0; k < 3; ++k) touched[tri[k]] = 1;
+					if (tri[0] == v || tri[1] == v || tri[2] == v) --remaining;
+				}
+
+				remap[u] = v;
+				mQuadrics[v] += mQuadrics[u];
+				mError = std::max(mError, collapse.Error);
+				collapsed = true;
+			}
+
+			if (!collapsed) return false;
+
+			size_t write = 0;
+			for (size_t t = 0; t < indices.size(); t += 3)
+			{
+				const uint32 a = remap[indices[t]];
+				const uint32 b = remap[indices[t + 1]];
+				const uint32 c = remap[indices[t + 2]];
+				if (a == b || b == c || c == a) continue;
+
+				indices[write++] = a;
+				indices[write++] = b;
+				indices[write++] = c;
+			}
+			indices.resize(write);
+			return true;
+		}
+
+	private:
+		const std::vector<GeometryGenerator::Vertex>& mVertices;
+		std::vector<Quadric> mQuadrics;
+		std::vector<VertexKind> mKinds;
+		float mError = 0.0f;
+	};
+}
+
+size_t DX::MeshLodChain::SelectLevel(const float distance, const float projectionScale, const float maxPixelError) const
+{
+	size_t level = 0;
+	while (level + 1 < Levels.size() && GetScreenSpaceError(Levels[level + 1], distance, projectionScale) <= maxPixelError)
+	{
+		++level;
+	}
+	return level;
+}
+
+float DX::GetLodProjectionScale(const float fovY, const float viewportHeight)
+{
+	return 0.5f * viewportHeight / std::tan(0.5f * fovY);
+}
+
+DX::MeshLodChain DX::BuildLodChain(const GeometryGenerator::MeshData& meshData, const std::uint32_t maxLevels,
+	const float reduction, const float maxError)
+{
+	DX_PROFILE_ZONE("BuildLodChain");
+	assert(meshData.Indices32.size() % 3 == 0);
+	assert(reduction > 0.0f && reduction < 1.0f);
+
+	MeshLodChain chain;
+	chain.Indices = meshData.Indices32;
+
+	MeshLod lod;
+	lod.IndexCount = static_cast<uint32>(meshData.Indices32.size());
+	chain.Levels.push_back(lod);
+
+	Simplifier simplifier(meshData.Vertices, meshData.Indices32);
+	std::vector<uint32> indices = meshData.Indices32;
+
+	while (chain.Levels.size() < maxLevels)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		const auto targetTriangles = static_cast<size_t>(static_cast<float>(triangleCount) * reduction);
+		const float error = simplifier.Simplify(indices, targetTriangles, maxError);
+
+		if (static_cast<float>(indices.size() / 3) > static_cast<float>(triangleCount) * (1.0f - MIN_LEVEL_REDUCTION)) break;
+
+		lod.StartIndexLocation = static_cast<uint32>(chain.Indices.size());
+		lod.IndexCount = static_cast<uint32>(indices.size());
+		lod.Error = error;
+		chain.Levels.push_back(lod);
+		chain.Indices.insert(chain.Indices.end(), indices.begin(), indices.end());
+	}
+
+	return chain;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GeometryGenerator.h"
+
+namespace DX
+{
+	// One level of a LOD chain: a range of MeshLodChain::Indices drawn over
+	// the unchanged vertex buffer of the source mesh. Error is how far the
+	// level strays from the full mesh, in object-space units.
+	struct MeshLod
+	{
+		std::uint32_t IndexCount = 0;
+		std::uint32_t StartIndexLocation = 0;
+		float Error = 0.0f;
+	};
+
+	/**
+	 * \brief Successively simplified index buffers of one mesh, finest first.
+	 * Level 0 is the mesh itself; the levels share one index buffer so they
+	 * can live in a single MeshGeometry.
+	 */
+	struct MeshLodChain
+	{
+		std::vector<std::uint32_t> Indices;
+		std::vector<MeshLod> Levels;
+
+		// The coarsest level whose error stays under maxPixelError on screen,
+		// see GetScreenSpaceError.
+		[[nodiscard]] size_t SelectLevel(float distance, float projectionScale, float maxPixelError = 1.0f) const;
+	};
+
+	// Pixels covered by one object-space unit at distance 1, for a
+	// perspective projection with vertical field of view fovY.
+	[[nodiscard]] float GetLodProjectionScale(float fovY, float viewportHeight);
+
+	// Object-space error of a level seen from distance, in pixels.
+	[[nodiscard]] inline float GetScreenSpaceError(const MeshLod& lod, float distance, float projectionScale)
+	{
+		return distance > 0.0f ? lod.Error * projectionScale / distance : lod.Error * projectionScale;
+	}
+
+	// Builds up to maxLevels levels, each with about reduction times the
+	// triangles of the one before, by collapsing edges onto existing vertices
+	// in order of their quadric error (Garland and Heckbert). Open borders are
+	// held in place and vertices sharing a position with another vertex, such
+	// as texture seams, are never moved, so levels do not crack. The chain
+	// ends early once no collapse stays under maxError.
+	[[nodiscard]] MeshLodChain BuildLodChain(const GeometryGenerator::MeshData& meshData, std::uint32_t maxLevels = 4,
+		float reduction = 0.5f, float maxError = 1e30f);
+}
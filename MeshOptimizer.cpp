@@ -0,0 +1,373 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+using namespace DirectX;
+using DX::GeometryGenerator;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	constexpr uint32 INVALID_INDEX = ~0u;
+
+	// Scoring constants from Forsyth's "Linear-Speed Vertex Cache Optimisation".
+	constexpr uint32 FORSYTH_CACHE_SIZE = 32;
+	constexpr uint32 MAX_VALENCE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	// Triangles per independently optimized chunk. Chunk edges cost a few
+	// cache misses each, which is noise at this size.
+	constexpr size_t CHUNK_TRIANGLES = size_t(1) << 16;
+
+	struct ForsythTables
+	{
+		float Cache[FORSYTH_CACHE_SIZE];
+		float Valence[MAX_VALENCE];
+
+		ForsythTables()
+		{
+			for (uint32 i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+			{
+				// The last triangle's vertices score the same whatever their
+				// order, so emitting it again does not get favoured.
+				Cache[i] = i < 3 ? LAST_TRIANGLE_SCORE :
+					std::pow(1.0f - static_cast<float>(i - 3) / (FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+			}
+
+			Valence[0] = 0.0f;
+			for (uint32 i = 1; i < MAX_VALENCE; ++i)
+			{
+				// Vertices with few triangles left are worth finishing off.
+				Valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+			}
+		}
+	};
+
+	const ForsythTables& GetForsythTables()
+	{
+		static const ForsythTables tables;
+		return tables;
+	}
+
+	float VertexScore(const ForsythTables& tables, const int cachePosition, const uint32 remaining)
+	{
+		if (remaining == 0) return -1.0f;
+
+		const float cacheScore = cachePosition < 0 ? 0.0f : tables.Cache[cachePosition];
+		return cacheScore + tables.Valence[std::min(remaining, MAX_VALENCE - 1)];
+	}
+
+	// Forsyth over one chunk whose indices are all below vertexCount.
+	void OptimizeChunk(uint32* indices, const size_t triangleCount, const uint32 vertexCount)
+	{
+		const ForsythTables& tables = GetForsythTables();
+		const size_t indexCount = triangleCount * 3;
+
+		// Triangles around each vertex, compacted so the live ones come first.
+		std::vector<uint32> remaining(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; ++i) ++remaining[indices[i]];
+
+		std::vector<uint32> offsets(vertexCount + 1, 0);
+		std::partial_sum(remaining.begin(), remaining.end(), offsets.begin() + 1);
+
+		std::vector<uint32> adjacency(indexCount);
+		{
+			std::vector<uint32> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indexCount; ++i) adjacency[cursor[indices[i]]++] = static_cast<uint32>(i / 3);
+		}
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (uint32 v = 0; v < vertexCount; ++v) vertexScore[v] = VertexScore(tables, -1, remaining[v]);
+
+		std::vector<float> triangleScore(triangleCount);
+		std::vector<std::uint8_t> emitted(triangleCount, 0);
+		uint32 best = INVALID_INDEX;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32* tri = &indices[t * 3];
+			triangleScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+			if (best == INVALID_INDEX || triangleScore[t] > triangleScore[best]) best = static_cast<uint32>(t);
+		}
+
+		std::vector<uint32> output(indexCount);
+		uint32 cache[FORSYTH_CACHE_SIZE + 3];
+		uint32 cacheCount = 0;
+		size_t nextUnemitted = 0;
+
+		for (size_t written = 0; written < indexCount; written += 3)
+		{
+			// Dead end, nothing in the cache has triangles left: restart from
+			// the first triangle in input order that is still pending.
+			if (best == INVALID_INDEX)
+			{
+				while (emitted[nextUnemitted]) ++nextUnemitted;
+				best = static_cast<uint32>(nextUnemitted);
+			}
+
+			const uint32* tri = &indices[best * 3];
+			std::copy(tri, tri + 3, &output[written]);
+			emitted[best] = 1;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				const uint32 v = tri[k];
+				uint32* first = &adjacency[offsets[v]];
+				uint32* last = first + remaining[v] - 1;
+				std::iter_swap(std::find(first, last, best), last);
+				--remaining[v];
+			}
+
+			// The emitted vertices move to the front; the rest shift back and
+			// anything past the cache size falls out.
+			uint32 newCache[FORSYTH_CACHE_SIZE + 3] = { tri[0], tri[1], tri[2] };
+			uint32 newCount = 3;
+			for (uint32 i = 0; i < cacheCount; ++i)
+			{
+				const uint32 v = cache[i];
+				if (v != tri[0] && v != tri[1] && v != tri[2]) newCache[newCount++] = v;
+			}
+
+			best = INVALID_INDEX;
+			for (uint32 i = 0; i < newCount; ++i)
+			{
+				const uint32 v = newCache[i];
+				const int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+				cachePosition[v] = position;
+
+				const float score = VertexScore(tables, position, remaining[v]);
+				const float delta = score - vertexScore[v];
+				vertexScore[v] = score;
+
+				for (uint32 a = offsets[v]; a < offsets[v] + remaining[v]; ++a)
+				{
+					const uint32 t = adjacency[a];
+					triangleScore[t] += delta;
+					if (position >= 0 && (best == INVALID_INDEX || triangleScore[t] > triangleScore[best])) best = t;
+				}
+			}
+
+			cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+			std::copy(newCache, newCache + cacheCount, cache);
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// FIFO post-transform cache, as fixed-function hardware had. A vertex is
+	// a hit while fewer than cacheSize misses happened since it was loaded.
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32 cacheSize) :
+			mLoadedAt(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+		// Returns true on a miss.
+		bool Touch(const uint32 v)
+		{
+			if (mTime - mLoadedAt[v] <= mCacheSize) return false;
+			mLoadedAt[v] = mTime++;
+			return true;
+		}
+
+	private:
+		std::vector<size_t> mLoadedAt;
+		size_t mCacheSize;
+		size_t mTime;
+	};
+}
+
+DX::VertexCacheStatistics DX::AnalyzeVertexCache(const std::uint32_t* indices, const size_t indexCount,
+	const size_t vertexCount, const std::uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics;
+	if (indexCount == 0) return statistics;
+
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<std::uint8_t> referenced(vertexCount, 0);
+	size_t referencedCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		const uint32 v = indices[i];
+		statistics.Misses += cache.Touch(v) ? 1 : 0;
+		if (!referenced[v])
+		{
+			referenced[v] = 1;
+			++referencedCount;
+		}
+	}
+
+	statistics.Acmr = static_cast<float>(statistics.Misses) / static_cast<float>(indexCount / 3);
+	statistics.Atvr = static_cast<float>(statistics.Misses) / static_cast<float>(referencedCount);
+	return statistics;
+}
+
+void DX::OptimizeVertexCache(std::uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	ThreadPool* threadPool)
+{
+	assert(indexCount % 3 == 0);
+
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount <= CHUNK_TRIANGLES)
+	{
+		OptimizeChunk(indices, triangleCount, static_cast<uint32>(vertexCount));
+		return;
+	}
+
+	// Each chunk renumbers the vertices it uses so its tables stay chunk sized.
+	const auto chunkCount = static_cast<uint32>((triangleCount + CHUNK_TRIANGLES - 1) / CHUNK_TRIANGLES);
+	const auto optimizeChunk = [indices, triangleCount](const uint32 chunk)
+	{
+		const size_t firstTriangle = chunk * CHUNK_TRIANGLES;
+		const size_t chunkTriangles = std::min(CHUNK_TRIANGLES, triangleCount - firstTriangle);
+		uint32* chunkIndices = indices + firstTriangle * 3;
+		uint32* chunkEnd = chunkIndices + chunkTriangles * 3;
+
+		std::vector<uint32> vertices(chunkIndices, chunkEnd);
+		std::sort(vertices.begin(), vertices.end());
+		vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+		for (uint32* index = chunkIndices; index != chunkEnd; ++index)
+		{
+			*index = static_cast<uint32>(std::lower_bound(vertices.begin(), vertices.end(), *index) - vertices.begin());
+		}
+
+		OptimizeChunk(chunkIndices, chunkTriangles, static_cast<uint32>(vertices.size()));
+
+		for (uint32* index = chunkIndices; index != chunkEnd; ++index) *index = vertices[*index];
+	};
+
+	if (threadPool != nullptr)
+	{
+		threadPool->ParallelFor(chunkCount, optimizeChunk);
+	}
+	else
+	{
+		for (uint32 chunk = 0; chunk < chunkCount; ++chunk) optimizeChunk(chunk);
+	}
+}
+
+void DX::OptimizeOverdraw(std::uint32_t* indices, const size_t indexCount,
+	const GeometryGenerator::Vertex* vertices, const size_t vertexCount, const std::uint32_t cacheSize)
+{
+	assert(indexCount % 3 == 0);
+
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) return;
+
+	// Cut the triangle order where the cache starts over.
+	std::vector<size_t> clusterStarts;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; ++k) misses += cache.Touch(indices[t * 3 + k]) ? 1 : 0;
+		if (misses == 3 || t == 0) clusterStarts.push_back(t);
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Area-weighted centroid and normal of every cluster and of the mesh.
+	const size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<XMFLOAT3> centroids(clusterCount);
+	std::vector<XMFLOAT3> normals(clusterCount);
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+		{
+			const XMVECTOR p0 = XMLoadFloat3(&vertices[indices[t * 3 + 0]].Position);
+			const XMVECTOR p1 = XMLoadFloat3(&vertices[indices[t * 3 + 1]].Position);
+			const XMVECTOR p2 = XMLoadFloat3(&vertices[indices[t * 3 + 2]].Position);
+
+			// Twice the triangle area, pointing along the face normal.
+			const XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			const float a = XMVectorGetX(XMVector3Length(n));
+
+			centroid += (a / 3.0f) * (p0 + p1 + p2);
+			normal += n;
+			area += a;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+
+		XMStoreFloat3(&centroids[c], area > 0.0f ? centroid / XMVectorReplicate(area) : centroid);
+		XMStoreFloat3(&normals[c], XMVector3Normalize(normal));
+	}
+
+	if (meshArea > 0.0f) meshCentroid = meshCentroid / XMVectorReplicate(meshArea);
+
+	// Clusters whose surface points away from the centre tend to be in
+	// front from any viewpoint outside the mesh.
+	std::vector<float> keys(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		keys[c] = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&centroids[c]) - meshCentroid, XMLoadFloat3(&normals[c])));
+	}
+
+	std::vector<uint32> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&keys](const uint32 a, const uint32 b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32> sorted;
+	sorted.reserve(indexCount);
+	for (const uint32 c : order)
+	{
+		sorted.insert(sorted.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+	}
+
+	std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+size_t DX::BuildVertexFetchRemap(const std::uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	std::uint32_t* remap)
+{
+	std::fill(remap, remap + vertexCount, INVALID_INDEX);
+
+	uint32 next = 0;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		if (remap[indices[i]] == INVALID_INDEX) remap[indices[i]] = next++;
+	}
+
+	const size_t referencedCount = next;
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] == INVALID_INDEX) remap[v] = next++;
+	}
+
+	return referencedCount;
+}
+
+void DX::OptimizeMesh(GeometryGenerator::MeshData& meshData, ThreadPool* threadPool)
+{
+	auto& vertices = meshData.Vertices;
+	auto& indices = meshData.Indices32;
+
+	OptimizeVertexCache(indices.data(), indices.size(), vertices.size(), threadPool);
+	OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+
+	std::vector<uint32> remap(vertices.size());
+	BuildVertexFetchRemap(indices.data(), indices.size(), vertices.size(), remap.data());
+
+	std::vector<GeometryGenerator::Vertex> reordered(vertices.size());
+	for (size_t v = 0; v < vertices.size(); ++v) reordered[remap[v]] = vertices[v];
+	vertices = std::move(reordered);
+
+	for (auto& index : indices) index = remap[index];
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "GeometryGenerator.h"
+#include "ThreadPool.h"
+
+namespace DX
+{
+	// Post-transform vertex cache behaviour of an index buffer, simulated
+	// with a FIFO cache. ACMR is misses per triangle (0.5 is the limit for a
+	// regular grid, 3 the worst case); ATVR is misses per referenced vertex
+	// (1 means every vertex is shaded exactly once).
+	struct VertexCacheStatistics
+	{
+		std::uint32_t Misses = 0;
+		float Acmr = 0.0f;
+		float Atvr = 0.0f;
+	};
+
+	[[nodiscard]] VertexCacheStatistics AnalyzeVertexCache(const std::uint32_t* indices, size_t indexCount,
+		size_t vertexCount, std::uint32_t cacheSize = 16);
+
+	// Reorders triangles for the post-transform cache with Tom Forsyth's
+	// linear-speed algorithm. Large meshes are cut into chunks of
+	// consecutive triangles that are optimized independently, in parallel
+	// when a pool is given; the result does not depend on the thread count.
+	void OptimizeVertexCache(std::uint32_t* indices, size_t indexCount, size_t vertexCount,
+		ThreadPool* threadPool = nullptr);
+
+	// Reorders clusters of cache-optimized triangles so the ones facing away
+	// from the mesh centre come first, which reduces overdraw from most
+	// view directions. Clusters start at triangles that miss the cache on
+	// all three vertices, so the cache efficiency is kept.
+	void OptimizeOverdraw(std::uint32_t* indices, size_t indexCount,
+		const GeometryGenerator::Vertex* vertices, size_t vertexCount, std::uint32_t cacheSize = 16);
+
+	// remap[v] is the position of vertex v when the vertices are sorted by
+	// first use, which keeps vertex fetch sequential. Unreferenced vertices
+	// go last, in their original order. Returns the referenced vertex count.
+	size_t BuildVertexFetchRemap(const std::uint32_t* indices, size_t indexCount, size_t vertexCount,
+		std::uint32_t* remap);
+
+	// Runs the three passes above on meshData. Call it before GetIndices16,
+	// which caches its copy of the indices.
+	void OptimizeMesh(GeometryGenerator::MeshData& meshData, ThreadPool* threadPool = nullptr);
+}
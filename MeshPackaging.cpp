@@ -0,0 +1,281 @@
+#include "MeshPackaging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+using DX::GeometryGenerator;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	constexpr uint32 INVALID_INDEX = ~0u;
+
+	// Ritter's bounding sphere: a sphere through two far-apart points, grown
+	// to take in every point left outside it. At most a few percent larger
+	// than the minimal sphere.
+	void ComputeBoundingSphere(const GeometryGenerator::Vertex* vertices, const uint32* vertexIndices,
+		const uint32 count, DX::Meshlet& meshlet)
+	{
+		const auto position = [vertices, vertexIndices](const uint32 i)
+		{
+			return XMLoadFloat3(&vertices[vertexIndices[i]].Position);
+		};
+
+		const auto farthestFrom = [&position, count](const XMVECTOR origin)
+		{
+			uint32 farthest = 0;
+			float farthestDistance = -1.0f;
+			for (uint32 i = 0; i < count; ++i)
+			{
+				const float distance = XMVectorGetX(XMVector3LengthSq(position(i) - origin));
+				if (distance > farthestDistance)
+				{
+					farthest = i;
+					farthestDistance = distance;
+				}
+			}
+			return position(farthest);
+		};
+
+		const XMVECTOR a = farthestFrom(position(0));
+		const XMVECTOR b = farthestFrom(a);
+
+		XMVECTOR center = 0.5f * (a + b);
+		float radius = 0.5f * XMVectorGetX(XMVector3Length(b - a));
+
+		for (uint32 i = 0; i < count; ++i)
+		{
+			const XMVECTOR p = position(i);
+			const float distance = XMVectorGetX(XMVector3Length(p - center));
+			if (distance > radius)
+			{
+				// Move the centre towards p just enough to reach it.
+				const float grownRadius = 0.5f * (radius + distance);
+				center += ((grownRadius - radius) / distance) * (p - center);
+				radius = grownRadius;
+			}
+		}
+
+		XMStoreFloat3(&meshlet.Center, center);
+		meshlet.Radius = radius;
+	}
+
+	// The cone axis averages the face normals and the cutoff encodes the
+	// widest of them. The apex sits on the axis behind every triangle plane,
+	// so an eye inside the cone sees only back faces.
+	void ComputeNormalCone(const GeometryGenerator::Vertex* vertices, const uint32* vertexIndices,
+		const std::uint8_t* triangles, const uint32 triangleCount, DX::Meshlet& meshlet)
+	{
+		const auto position = [vertices, vertexIndices, triangles](const uint32 t, const int k)
+		{
+			return XMLoadFloat3(&vertices[vertexIndices[triangles[t * 3 + k]]].Position);
+		};
+
+		// Face planes, with the winding GeometryGenerator uses for front faces.
+		struct Plane
+		{
+			XMFLOAT3 Point;
+			XMFLOAT3 Normal;
+		};
+
+		std::vector<Plane> planes;
+		planes.reserve(triangleCount);
+
+		XMVECTOR axis = XMVectorZero();
+		for (uint32 t = 0; t < triangleCount; ++t)
+		{
+			const XMVECTOR p0 = position(t, 0);
+			const XMVECTOR n = XMVector3Cross(position(t, 1) - p0, position(t, 2) - p0);
+			if (XMVectorGetX(XMVector3LengthSq(n)) == 0.0f) continue;
+
+			Plane plane;
+			XMStoreFloat3(&plane.Point, p0);
+			XMStoreFloat3(&plane.Normal, XMVector3Normalize(n));
+			axis += XMLoadFloat3(&plane.Normal);
+			planes.push_back(plane);
+		}
+
+		meshlet.ConeApex = meshlet.Center;
+		meshlet.ConeCutoff = 1.0f;
+		if (planes.empty() || XMVectorGetX(XMVector3LengthSq(axis)) == 0.0f) return;
+
+		axis = XMVector3Normalize(axis);
+		XMStoreFloat3(&meshlet.ConeAxis, axis);
+
+		float minDot = 1.0f;
+		for (const auto& plane : planes)
+		{
+			minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&plane.Normal))));
+		}
+
+		if (minDot <= 0.0f) return;
+
+		const XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+		float maxOffset = 0.0f;
+		for (const auto& plane : planes)
+		{
+			const XMVECTOR n = XMLoadFloat3(&plane.Normal);
+			const float offset = XMVectorGetX(XMVector3Dot(center - XMLoadFloat3(&plane.Point), n)) /
+				XMVectorGetX(XMVector3Dot(axis, n));
+			maxOffset = std::max(maxOffset, offset);
+		}
+
+		XMStoreFloat3(&meshlet.ConeApex, center - maxOffset * axis);
+		meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+const void* DX::PackagedMesh::GetIndexData() const
+{
+	return Width == IndexWidth::Bits16 ? static_cast<const void*>(Indices16.data()) : Indices32.data();
+}
+
+size_t DX::PackagedMesh::GetIndexCount() const
+{
+	return Width == IndexWidth::Bits16 ? Indices16.size() : Indices32.size();
+}
+
+size_t DX::PackagedMesh::GetIndexBufferByteSize() const
+{
+	return Width == IndexWidth::Bits16 ?
+		Indices16.size() * sizeof(std::uint16_t) : Indices32.size() * sizeof(std::uint32_t);
+}
+
+DX::PackagedMesh DX::PackageMesh(const GeometryGenerator::MeshData& meshData, const IndexPolicy policy)
+{
+	const auto& vertices = meshData.Vertices;
+	const auto& indices = meshData.Indices32;
+
+	PackagedMesh packaged;
+	packaged.Width = ChooseIndexWidth(vertices.size());
+
+	if (packaged.Width == IndexWidth::Bits16 || policy == IndexPolicy::Allow32)
+	{
+		packaged.Vertices = vertices;
+		if (packaged.Width == IndexWidth::Bits16)
+		{
+			packaged.Indices16.assign(indices.begin(), indices.end());
+		}
+		else
+		{
+			packaged.Indices32 = indices;
+		}
+
+		MeshPart part;
+		part.IndexCount = static_cast<uint32>(indices.size());
+		packaged.Parts.push_back(part);
+		return packaged;
+	}
+
+	// Walk the triangles in order, starting a new part whenever the next
+	// one would need vertex 65536. A vertex used by two parts is copied
+	// into both.
+	assert(indices.size() % 3 == 0);
+	packaged.Width = IndexWidth::Bits16;
+	packaged.Indices16.reserve(indices.size());
+
+	std::vector<uint32> localIndex(vertices.size(), INVALID_INDEX);
+	std::vector<uint32> owningPart(vertices.size(), INVALID_INDEX);
+
+	MeshPart part;
+	uint32 partIndex = 0;
+	uint32 partVertexCount = 0;
+
+	for (size_t t = 0; t < indices.size(); t += 3)
+	{
+		uint32 newVertices = 0;
+		for (int k = 0; k < 3; ++k) newVertices += owningPart[indices[t + k]] != partIndex ? 1 : 0;
+
+		if (partVertexCount + newVertices > MAX_INDEX16_VERTICES)
+		{
+			packaged.Parts.push_back(part);
+
+			++partIndex;
+			partVertexCount = 0;
+			part.IndexCount = 0;
+			part.StartIndexLocation = static_cast<uint32>(packaged.Indices16.size());
+			part.BaseVertexLocation = static_cast<std::int32_t>(packaged.Vertices.size());
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const uint32 v = indices[t + k];
+			if (owningPart[v] != partIndex)
+			{
+				owningPart[v] = partIndex;
+				localIndex[v] = partVertexCount++;
+				packaged.Vertices.push_back(vertices[v]);
+			}
+
+			packaged.Indices16.push_back(static_cast<std::uint16_t>(localIndex[v]));
+		}
+
+		part.IndexCount += 3;
+	}
+
+	packaged.Parts.push_back(part);
+	return packaged;
+}
+
+DX::MeshletData DX::BuildMeshlets(const GeometryGenerator::Vertex* vertices, const size_t vertexCount,
+	const std::uint32_t* indices, const size_t indexCount)
+{
+	assert(indexCount % 3 == 0);
+
+	MeshletData data;
+	std::vector<uint32> localIndex(vertexCount, INVALID_INDEX);
+	Meshlet meshlet;
+
+	const auto finishMeshlet = [&]()
+	{
+		if (meshlet.TriangleCount == 0) return;
+
+		const uint32* meshletVertices = &data.VertexIndices[meshlet.VertexOffset];
+		for (uint32 i = 0; i < meshlet.VertexCount; ++i) localIndex[meshletVertices[i]] = INVALID_INDEX;
+
+		ComputeBoundingSphere(vertices, meshletVertices, meshlet.VertexCount, meshlet);
+		ComputeNormalCone(vertices, meshletVertices, &data.PrimitiveIndices[meshlet.TriangleOffset * 3],
+			meshlet.TriangleCount, meshlet);
+		data.Meshlets.push_back(meshlet);
+
+		meshlet = Meshlet();
+		meshlet.VertexOffset = static_cast<uint32>(data.VertexIndices.size());
+		meshlet.TriangleOffset = static_cast<uint32>(data.PrimitiveIndices.size() / 3);
+	};
+
+	for (size_t t = 0; t < indexCount; t += 3)
+	{
+		const uint32 a = indices[t + 0];
+		const uint32 b = indices[t + 1];
+		const uint32 c = indices[t + 2];
+
+		const uint32 newVertices = (localIndex[a] == INVALID_INDEX ? 1 : 0) +
+			(localIndex[b] == INVALID_INDEX && b != a ? 1 : 0) +
+			(localIndex[c] == INVALID_INDEX && c != a && c != b ? 1 : 0);
+
+		if (meshlet.VertexCount + newVertices > MESHLET_MAX_VERTICES ||
+			meshlet.TriangleCount == MESHLET_MAX_TRIANGLES)
+		{
+			finishMeshlet();
+		}
+
+		for (const uint32 v : { a, b, c })
+		{
+			if (localIndex[v] == INVALID_INDEX)
+			{
+				localIndex[v] = meshlet.VertexCount++;
+				data.VertexIndices.push_back(v);
+			}
+
+			data.PrimitiveIndices.push_back(static_cast<std::uint8_t>(localIndex[v]));
+		}
+
+		++meshlet.TriangleCount;
+	}
+
+	finishMeshlet();
+	return data;
+}
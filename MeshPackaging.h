@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+#include "GeometryGenerator.h"
+
+namespace DX
+{
+	enum class IndexWidth
+	{
+		Bits16,
+		Bits32,
+	};
+
+	// What PackageMesh does with meshes too big for 16-bit indices.
+	enum class IndexPolicy
+	{
+		// Cut them into 16-bit addressable parts, duplicating boundary vertices.
+		Split16,
+		// Keep them whole with 32-bit indices.
+		Allow32,
+	};
+
+	// A range of the packaged buffers drawn with one DrawIndexedInstanced call.
+	struct MeshPart
+	{
+		std::uint32_t IndexCount = 0;
+		std::uint32_t StartIndexLocation = 0;
+		std::int32_t BaseVertexLocation = 0;
+	};
+
+	// Vertex and index buffers ready for upload. Only the index array of
+	// the chosen width is filled; part indices are relative to the part's
+	// BaseVertexLocation.
+	struct PackagedMesh
+	{
+		IndexWidth Width = IndexWidth::Bits16;
+		std::vector<GeometryGenerator::Vertex> Vertices;
+		std::vector<std::uint16_t> Indices16;
+		std::vector<std::uint32_t> Indices32;
+		std::vector<MeshPart> Parts;
+
+		[[nodiscard]] const void* GetIndexData() const;
+		[[nodiscard]] size_t GetIndexCount() const;
+		[[nodiscard]] size_t GetIndexBufferByteSize() const;
+	};
+
+	inline constexpr size_t MAX_INDEX16_VERTICES = 0x10000;
+
+	[[nodiscard]] inline IndexWidth ChooseIndexWidth(size_t vertexCount)
+	{
+		return vertexCount <= MAX_INDEX16_VERTICES ? IndexWidth::Bits16 : IndexWidth::Bits32;
+	}
+
+	// Meshes that fit 16-bit indices are packaged as one part. Larger ones
+	// are cut, in triangle order, into parts of at most 65536 vertices, or
+	// kept whole with 32-bit indices under IndexPolicy::Allow32.
+	[[nodiscard]] PackagedMesh PackageMesh(const GeometryGenerator::MeshData& meshData,
+		IndexPolicy policy = IndexPolicy::Split16);
+
+	/**
+	 * \brief Cluster of up to MESHLET_MAX_VERTICES vertices and
+	 * MESHLET_MAX_TRIANGLES triangles, culled as a unit. Its vertices are
+	 * VertexIndices[VertexOffset, VertexOffset + VertexCount) of the
+	 * MeshletData, its triangles index into those with three bytes each at
+	 * PrimitiveIndices[TriangleOffset * 3].
+	 *
+	 * The whole meshlet faces away from an eye position when
+	 * dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff. Meshlets whose
+	 * normals spread over more than a hemisphere get a cutoff of 1.
+	 */
+	struct Meshlet
+	{
+		std::uint32_t VertexOffset = 0;
+		std::uint32_t VertexCount = 0;
+		std::uint32_t TriangleOffset = 0;
+		std::uint32_t TriangleCount = 0;
+
+		DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+		float Radius = 0.0f;
+
+		DirectX::XMFLOAT3 ConeApex = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 ConeAxis = { 0.0f, 0.0f, 1.0f };
+		float ConeCutoff = 1.0f;
+	};
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> Meshlets;
+		std::vector<std::uint32_t> VertexIndices;
+		std::vector<std::uint8_t> PrimitiveIndices;
+	};
+
+	// Limits that suit mesh shader output and amplification on all vendors.
+	inline constexpr std::uint32_t MESHLET_MAX_VERTICES = 64;
+	inline constexpr std::uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// Groups triangles into meshlets in index order, so run OptimizeVertexCache
+	// first for tight ones.
+	[[nodiscard]] MeshletData BuildMeshlets(const GeometryGenerator::Vertex* vertices, size_t vertexCount,
+		const std::uint32_t* indices, size_t indexCount);
+}
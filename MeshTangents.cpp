@@ -0,0 +1,163 @@
+#include "MeshTangents.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+using namespace DirectX;
+using DX::GeometryGenerator;
+
+namespace
+{
+	using uint32 = std::uint32_t;
+
+	// Triangles, and vertices, per task handed to the pool.
+	constexpr size_t TRIANGLE_CHUNK = 16384;
+	constexpr size_t VERTEX_CHUNK = 16384;
+
+	void ForEachChunk(DX::ThreadPool* threadPool, const size_t count, const size_t chunkSize,
+		const std::function<void(size_t, size_t)>& body)
+	{
+		const auto chunkCount = static_cast<uint32>((count + chunkSize - 1) / chunkSize);
+		const auto run = [&](const uint32 chunk)
+		{
+			const size_t first = chunk * chunkSize;
+			body(first, std::min(first + chunkSize, count));
+		};
+
+		if (threadPool != nullptr && chunkCount > 1)
+		{
+			threadPool->ParallelFor(chunkCount, run);
+		}
+		else
+		{
+			for (uint32 chunk = 0; chunk < chunkCount; ++chunk) run(chunk);
+		}
+	}
+
+	// v with its component along the unit normal n removed.
+	XMVECTOR ProjectOnPlane(const XMVECTOR v, const XMVECTOR n)
+	{
+		return v - XMVector3Dot(n, v) * n;
+	}
+
+	// Any unit vector perpendicular to n, for vertices without usable UVs.
+	XMVECTOR AnyPerpendicular(const XMVECTOR n)
+	{
+		const XMVECTOR axis = std::fabs(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		return XMVector3Normalize(ProjectOnPlane(axis, n));
+	}
+}
+
+void DX::GenerateTangents(const GeometryGenerator::Vertex* vertices, const size_t vertexCount,
+	const std::uint32_t* indices, const size_t indexCount, XMFLOAT4* tangents, ThreadPool* threadPool)
+{
+	DX_PROFILE_ZONE("GenerateTangents");
+	assert(indexCount % 3 == 0);
+
+	// Every corner's contribution: the face tangent in its vertex's tangent
+	// plane times the corner angle in xyz, and that angle signed by the face
+	// handedness in w.
+	std::vector<XMFLOAT4> corners(indexCount);
+
+	ForEachChunk(threadPool, indexCount / 3, TRIANGLE_CHUNK, [&](const size_t firstTriangle, const size_t lastTriangle)
+	{
+		for (size_t t = firstTriangle; t < lastTriangle; ++t)
+		{
+			const uint32* tri = &indices[t * 3];
+			const GeometryGenerator::Vertex* v[3] = { &vertices[tri[0]], &vertices[tri[1]], &vertices[tri[2]] };
+
+			const XMVECTOR p0 = XMLoadFloat3(&v[0]->Position);
+			const XMVECTOR d1 = XMLoadFloat3(&v[1]->Position) - p0;
+			const XMVECTOR d2 = XMLoadFloat3(&v[2]->Position) - p0;
+
+			const float s1 = v[1]->TexC.x - v[0]->TexC.x;
+			const float t1 = v[1]->TexC.y - v[0]->TexC.y;
+			const float s2 = v[2]->TexC.x - v[0]->TexC.x;
+			const float t2 = v[2]->TexC.y - v[0]->TexC.y;
+
+			// Texture-space tangent up to scale, and which way the UVs wind.
+			const float signedArea = s1 * t2 - t1 * s2;
+			const XMVECTOR faceTangent = t2 * d1 - t1 * d2;
+			const float orientation = signedArea > 0.0f ? 1.0f : -1.0f;
+			const bool hasTangent = signedArea != 0.0f && XMVectorGetX(XMVector3LengthSq(faceTangent)) > 0.0f;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				const XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&v[k]->Normal));
+				const XMVECTOR p = XMLoadFloat3(&v[k]->Position);
+
+				// The corner angle, measured in the vertex's tangent plane.
+				const XMVECTOR e0 = XMVector3Normalize(ProjectOnPlane(XMLoadFloat3(&v[(k + 1) % 3]->Position) - p, n));
+				const XMVECTOR e1 = XMVector3Normalize(ProjectOnPlane(XMLoadFloat3(&v[(k + 2) % 3]->Position) - p, n));
+				const float cosine = std::clamp(XMVectorGetX(XMVector3Dot(e0, e1)), -1.0f, 1.0f);
+				const float angle = std::acos(cosine);
+
+				XMVECTOR contribution = XMVectorZero();
+				if (hasTangent)
+				{
+					const XMVECTOR projected = ProjectOnPlane(orientation * faceTangent, n);
+					if (XMVectorGetX(XMVector3LengthSq(projected)) > 0.0f)
+					{
+						contribution = angle * XMVector3Normalize(projected);
+					}
+				}
+
+				XMFLOAT4& corner = corners[t * 3 + k];
+				XMStoreFloat4(&corner, contribution);
+				corner.w = hasTangent ? orientation * angle : 0.0f;
+			}
+		}
+	});
+
+	// Corners around each vertex, in index order, so the sums below do not
+	// depend on how the faces were split between threads.
+	std::vector<uint32> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; ++i) ++offsets[indices[i] + 1];
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	std::vector<uint32> vertexCorners(indexCount);
+	{
+		std::vector<uint32> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i) vertexCorners[cursor[indices[i]]++] = static_cast<uint32>(i);
+	}
+
+	ForEachChunk(threadPool, vertexCount, VERTEX_CHUNK, [&](const size_t firstVertex, const size_t lastVertex)
+	{
+		for (size_t i = firstVertex; i < lastVertex; ++i)
+		{
+			XMVECTOR sum = XMVectorZero();
+			float handedness = 0.0f;
+			for (uint32 c = offsets[i]; c < offsets[i + 1]; ++c)
+			{
+				const XMFLOAT4& corner = corners[vertexCorners[c]];
+				sum += XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&corner));
+				handedness += corner.w;
+			}
+
+			const XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&vertices[i].Normal));
+			XMVECTOR tangent = ProjectOnPlane(sum, n);
+			tangent = XMVectorGetX(XMVector3LengthSq(tangent)) > 0.0f ? XMVector3Normalize(tangent) : AnyPerpendicular(n);
+
+			XMStoreFloat4(&tangents[i], tangent);
+			tangents[i].w = handedness < 0.0f ? -1.0f : 1.0f;
+		}
+	});
+}
+
+void DX::GenerateTangents(GeometryGenerator::MeshData& meshData, ThreadPool* threadPool)
+{
+	auto& vertices = meshData.Vertices;
+	std::vector<XMFLOAT4> tangents(vertices.size());
+	GenerateTangents(vertices.data(), vertices.size(), meshData.Indices32.data(), meshData.Indices32.size(),
+		tangents.data(), threadPool);
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		vertices[i].TangentU = XMFLOAT3(tangents[i].x, tangents[i].y, tangents[i].z);
+	}
+}
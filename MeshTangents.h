@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+
+#include "GeometryGenerator.h"
+#include "ThreadPool.h"
+
+namespace DX
+{
+	// Per-vertex tangents the way MikkTSpace computes them, from positions,
+	// normals and texture coordinates. Every face contributes its texture
+	// space tangent projected onto the tangent plane of each corner's normal,
+	// weighted by the corner angle; the sums are orthonormalized against the
+	// normal. w is the bitangent sign, bitangent = w * cross(normal, tangent).
+	// MikkTSpace additionally splits vertices whose faces disagree in
+	// handedness; here such a vertex takes the sign of the larger angle sum,
+	// so meshes need seams where their UVs are mirrored, as the
+	// GeometryGenerator shapes have.
+	//
+	// Faces are processed in parallel triangle ranges, each writing only its
+	// own corners, and each vertex then sums its corners in a fixed order, so
+	// nothing is shared between threads and the result does not depend on
+	// the thread count.
+	void GenerateTangents(const GeometryGenerator::Vertex* vertices, size_t vertexCount,
+		const std::uint32_t* indices, size_t indexCount, DirectX::XMFLOAT4* tangents, ThreadPool* threadPool = nullptr);
+
+	// Overwrites TangentU of every vertex; the handedness is dropped since
+	// the vertex format has no room for it.
+	void GenerateTangents(GeometryGenerator::MeshData& meshData, ThreadPool* threadPool = nullptr);
+}
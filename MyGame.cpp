@@ -10,6 +10,8 @@
 
 #include "MyGame.h"
 #include "GeometryGenerator.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
 #include "3rdparty/DirectXTK12/Inc/DDSTextureLoader.h"
 #include "3rdparty/DirectXTK12/Inc/ResourceUploadBatch.h"
 
@@ -18,6 +20,10 @@ using namespace DX;
 namespace 
 {
 	const float* gRenderTargetCleanValue = DirectX::Colors::Black.f;
+
+	// Part of every mesh cache key. Bump it whenever a Build*Geometry
+	// function changes what it generates, so older cached meshes miss.
+	constexpr std::uint32_t GEOMETRY_REVISION = 1;
 }
 
 MyGame::MyGame(HINSTANCE hInstance) : D3DApp(hInstance) {}
@@ -32,6 +38,7 @@ MyGame::~MyGame()
 
 bool MyGame::Initialize()
 {
+	DX_PROFILE_ZONE("MyGame::Initialize");
 	if (!D3DApp::Initialize()) return false;
 
 	ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
@@ -178,6 +185,7 @@ void MyGame::OnResize()
 
 void MyGame::Update(const GameTimer& gameTimer)
 {
+	DX_PROFILE_ZONE("MyGame::Update");
 	OnKeyboardInput(gameTimer);
 	UpdateCamera(gameTimer);
 
@@ -204,6 +212,7 @@ void MyGame::Update(const GameTimer& gameTimer)
 
 void MyGame::Draw(const GameTimer& gameTimer)
 {
+	DX_PROFILE_ZONE("MyGame::Draw");
 	using namespace DirectX;
 
 	const auto& cmdListAlloc = mCurrFrameResource->CmdListAlloc;
@@ -259,6 +268,7 @@ void MyGame::Draw(const GameTimer& gameTimer)
 		DrawIndexedRenderItems(mCommandList.Get(), mRenderItemLayer[static_cast<int>(RenderLayer::Transparent)]);
 
 		mCommandList->SetGraphicsRootDescriptorTable(4, mWaves->GetDisplacementMap());
+		mCommandList->SetGraphicsRootDescriptorTable(5, mWaves->GetNormalMap());
 		mCommandList->SetPipelineState(mPipelineStateObjects["wavesRender"].Get());
 		DrawIndexedRenderItems(mCommandList.Get(), mRenderItemLayer[static_cast<int>(RenderLayer::GpuWaves)]);
 
@@ -425,30 +435,67 @@ void MyGame::AnimateMaterials(const GameTimer& gameTimer)
 	water->NumFrameDirty = FRAME_RESOURCES_NUM;
 }
 
-void MyGame::UpdateObjectConstBuffs(const GameTimer& gameTimer) const
+void MyGame::UpdateObjectConstBuffs(const GameTimer& gameTimer)
 {
+	DX_PROFILE_ZONE("MyGame::UpdateObjectConstBuffs");
 	using namespace DirectX;
 
-	const auto currObjCb = mCurrFrameResource->ObjConstBuff.get();
+	mDirtyItems.clear();
 	for (auto & ri : mRenderItems)
 	{
-		if (ri->NumFrameDirty > 0)
+		if (ri->NumFrameDirty > 0) mDirtyItems.push_back(ri.get());
+	}
+	if (mDirtyItems.empty()) return;
+
+	// Rigid, uniformly scaled and affine worlds take their closed forms
+	// directly; projective ones are gathered so their inverse-transposes are
+	// computed in one batch, then scattered back.
+	const size_t count = mDirtyItems.size();
+	mWorldInvTs.resize(count);
+	mBatchedItems.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const RenderItem* ri = mDirtyItems[i];
+		if (ri->GetWorldClass() != TransformClass::General)
 		{
-			const XMMATRIX world = XMLoadFloat4x4(&ri->World);
-			const XMMATRIX texTransform = XMLoadFloat4x4(&ri->TexTransform);
-			const XMMATRIX worldInvT = MathHelper::InverseTranspose(world);
+			XMStoreFloat4x4(&mWorldInvTs[i], MathHelper::InverseTranspose(XMLoadFloat4x4(&ri->GetWorld()), ri->GetWorldClass()));
+		}
+		else
+		{
+			mBatchedItems.push_back(i);
+		}
+	}
 
-			ObjectConstants objConst;
-			XMStoreFloat4x4(&objConst.World, XMMatrixTranspose(world));
-			XMStoreFloat4x4(&objConst.TexTransform, XMMatrixTranspose(texTransform));
-			XMStoreFloat4x4(&objConst.WorldInvTranspose, XMMatrixTranspose(worldInvT));
-			objConst.DisplacementMapTexelSize = ri->DisplacementMapTexelSize;
-			objConst.GridSpatialStep = ri->GridSpatialStep;
+	if (!mBatchedItems.empty())
+	{
+		const size_t batchCount = mBatchedItems.size();
+		mBatchedTransforms.resize(16 * batchCount);
+		const MatrixSoa soa{ mBatchedTransforms.data(), batchCount };
 
-			currObjCb->CopyData(ri->ObjConstBuffIndex, objConst);
+		for (size_t b = 0; b < batchCount; ++b) MathHelper::StoreSoa(soa, b, mDirtyItems[mBatchedItems[b]]->GetWorld());
+		MathHelper::InverseTransposeBatch(soa, soa, batchCount);
+		for (size_t b = 0; b < batchCount; ++b) mWorldInvTs[mBatchedItems[b]] = MathHelper::LoadSoa(soa, b);
+	}
 
-			ri->NumFrameDirty--;
-		}
+	const auto currObjCb = mCurrFrameResource->ObjConstBuff.get();
+	for (size_t i = 0; i < count; ++i)
+	{
+		RenderItem* ri = mDirtyItems[i];
+		const XMMATRIX world = XMLoadFloat4x4(&ri->GetWorld());
+		const XMMATRIX texTransform = XMLoadFloat4x4(&ri->TexTransform);
+		const XMMATRIX worldInvT = XMLoadFloat4x4(&mWorldInvTs[i]);
+
+		ObjectConstants objConst;
+		XMStoreFloat4x4(&objConst.World, XMMatrixTranspose(world));
+		XMStoreFloat4x4(&objConst.TexTransform, XMMatrixTranspose(texTransform));
+		XMStoreFloat4x4(&objConst.WorldInvTranspose, XMMatrixTranspose(worldInvT));
+		objConst.DisplacementMapTexelSize = ri->DisplacementMapTexelSize;
+		objConst.GridSpatialStep = ri->GridSpatialStep;
+		objConst.DisplacementScale = ri->DisplacementScale;
+
+		currObjCb->CopyData(ri->ObjConstBuffIndex, objConst);
+
+		ri->NumFrameDirty--;
 	}
 }
 
@@ -522,27 +569,36 @@ void MyGame::UpdateMainPassConstBuffs(const GameTimer& gameTimer)
 
 void MyGame::UpdateWavesGpu(const GameTimer& gameTimer)
 {
+	DX_PROFILE_ZONE("MyGame::UpdateWavesGpu");
 	static float tBase = 0.0f;
 
-	if (gameTimer.TotalTime() - tBase >= 0.25f)
+	// Catch up on every drop due since the last frame, then apply them in one batch.
+	mWaveDrops.clear();
+	while (gameTimer.TotalTime() - tBase >= 0.25f)
 	{
 		tBase += 0.25f;
 
-		int i = MathHelper::Rand(4, mWaves->GetRowCount() - 5);
-		int j = MathHelper::Rand(4, mWaves->GetColumnCount() - 5);
-
-		float r = MathHelper::RandF(1.0f, 2.0f);
-
-		mWaves->Disturb(mCommandList.Get(), mWavesRootSignature.Get(),
-			mPipelineStateObjects["wavesDisturb"].Get(), i, j, r);
+		WaveDisturbance drop;
+		drop.Row = MathHelper::Rand(4, mWaves->GetRowCount() - 5);
+		drop.Col = MathHelper::Rand(4, mWaves->GetColumnCount() - 5);
+		drop.Magnitude = MathHelper::RandF(1.0f, 2.0f);
+		mWaveDrops.push_back(drop);
 	}
 
+	mWaves->DisturbBatch(mCommandList.Get(), mWavesRootSignature.Get(),
+		mPipelineStateObjects["wavesDisturbBatch"].Get(), mCurrFrameResource->WavesDisturbBuff,
+		mWaveDrops.data(), static_cast<UINT>(mWaveDrops.size()));
+
 	mWaves->Update(gameTimer, mCommandList.Get(), mWavesRootSignature.Get(), 
 		mPipelineStateObjects["wavesUpdate"].Get());
+
+	mWaves->UpdateNormals(mCommandList.Get(), mWavesRootSignature.Get(),
+		mPipelineStateObjects["wavesNormal"].Get());
 }
 
 void MyGame::BuildDescriptorHeaps()
 {
+	DX_PROFILE_ZONE("MyGame::BuildDescriptorHeaps");
 	// Create descriptor heaps for MSAA render target views and depth stencil views.
 	{
 		D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc{};
@@ -637,6 +693,7 @@ void MyGame::BuildDescriptorHeaps()
 
 void MyGame::LoadTextures()
 {
+	DX_PROFILE_ZONE("MyGame::LoadTextures");
 	const std::unordered_map<std::string, std::wstring> tbl =
 	{
 		{"grassTex",		L"Textures/grass12.dds"},
@@ -664,22 +721,27 @@ void MyGame::LoadTextures()
 
 void MyGame::BuildRootSignature()
 {
+	DX_PROFILE_ZONE("MyGame::BuildRootSignature");
 	CD3DX12_DESCRIPTOR_RANGE texTbl;
 	texTbl.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
 
 	CD3DX12_DESCRIPTOR_RANGE dispMapTbl;
 	dispMapTbl.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
 
-	CD3DX12_ROOT_PARAMETER slotRootParameter[5];
+	CD3DX12_DESCRIPTOR_RANGE normalMapTbl;
+	normalMapTbl.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2);
+
+	CD3DX12_ROOT_PARAMETER slotRootParameter[6];
 	slotRootParameter[0].InitAsDescriptorTable(1, &texTbl, D3D12_SHADER_VISIBILITY_PIXEL);	// diffuse texture
 	slotRootParameter[1].InitAsConstantBufferView(0);	// object constants at b0
 	slotRootParameter[2].InitAsConstantBufferView(1);	// pass constants at b1
 	slotRootParameter[3].InitAsConstantBufferView(2);	// material constants at b2
 	slotRootParameter[4].InitAsDescriptorTable(1, &dispMapTbl, D3D12_SHADER_VISIBILITY_ALL);	// material constants at t1
+	slotRootParameter[5].InitAsDescriptorTable(1, &normalMapTbl, D3D12_SHADER_VISIBILITY_VERTEX);	// wave normals at t2
 
 	const auto& staticSamplers = GetStaticSamplers();
 
-	const CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(5, slotRootParameter, 
+	const CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(6, slotRootParameter, 
 		static_cast<UINT>(staticSamplers.size()), staticSamplers.data(), 
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -703,6 +765,7 @@ void MyGame::BuildRootSignature()
 
 void MyGame::BuildPostProcessRootSignature()
 {
+	DX_PROFILE_ZONE("MyGame::BuildPostProcessRootSignature");
 	{	// blur filter root signature
 		CD3DX12_DESCRIPTOR_RANGE srvTbl, uavTbl;
 		srvTbl.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
@@ -774,20 +837,25 @@ void MyGame::BuildPostProcessRootSignature()
 
 void MyGame::BuildWavesRootSignature()
 {
+	DX_PROFILE_ZONE("MyGame::BuildWavesRootSignature");
 	CD3DX12_DESCRIPTOR_RANGE uavTbl0;
 	uavTbl0.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
 	CD3DX12_DESCRIPTOR_RANGE uavTbl1;
 	uavTbl1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 1);
 	CD3DX12_DESCRIPTOR_RANGE uavTbl2;
 	uavTbl2.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 2);
+	CD3DX12_DESCRIPTOR_RANGE uavTbl3;
+	uavTbl3.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 3);
 
-	CD3DX12_ROOT_PARAMETER rootParams[4];
-	rootParams[0].InitAsConstants(6, 0);
+	CD3DX12_ROOT_PARAMETER rootParams[6];
+	rootParams[0].InitAsConstants(9, 0);
 	rootParams[1].InitAsDescriptorTable(1, &uavTbl0);
 	rootParams[2].InitAsDescriptorTable(1, &uavTbl1);
 	rootParams[3].InitAsDescriptorTable(1, &uavTbl2);
+	rootParams[4].InitAsShaderResourceView(0);
+	rootParams[5].InitAsDescriptorTable(1, &uavTbl3);
 
-	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(4, rootParams);
+	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(6, rootParams);
 	Microsoft::WRL::ComPtr<ID3DBlob> serializedRootSig = nullptr;
 	Microsoft::WRL::ComPtr<ID3DBlob> errorBlob = nullptr;
 	HRESULT hr = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1,
@@ -808,6 +876,7 @@ void MyGame::BuildWavesRootSignature()
 
 void MyGame::BuildShadersAndInputLayout()
 {
+	DX_PROFILE_ZONE("MyGame::BuildShadersAndInputLayout");
 	mShaders["defaultVS"] = LoadBinary(L"CompiledShaders/defaultVS.cso");
 	mShaders["defaultPS"] = LoadBinary(L"CompiledShaders/defaultPS.cso");
 	mShaders["alphaTestedPS"] = LoadBinary(L"CompiledShaders/alphaTestedPS.cso");
@@ -834,6 +903,8 @@ void MyGame::BuildShadersAndInputLayout()
 	mShaders["wavesVS"] = LoadBinary(L"CompiledShaders/wavesVS.cso");
 	mShaders["wavesUpdateCS"] = LoadBinary(L"CompiledShaders/wavesUpdateCS.cso");
 	mShaders["wavesDisturbCS"] = LoadBinary(L"CompiledShaders/wavesDisturbCS.cso");
+	mShaders["wavesDisturbBatchCS"] = LoadBinary(L"CompiledShaders/wavesDisturbBatchCS.cso");
+	mShaders["wavesNormalCS"] = LoadBinary(L"CompiledShaders/wavesNormalCS.cso");
 
 	mShaders["sobelCS"] = LoadBinary(L"CompiledShaders/sobelCS.cso");
 	mShaders["compositeVS"] = LoadBinary(L"CompiledShaders/compositeVS.cso");
@@ -865,106 +936,149 @@ void MyGame::BuildShadersAndInputLayout()
 
 void MyGame::BuildLandGeometry()
 {
-	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.f, 50, 50);
+	DX_PROFILE_ZONE("MyGame::BuildLandGeometry");
+	constexpr float gridWidth = 160.0f;
+	constexpr float gridDepth = 160.0f;
+	constexpr UINT gridRows = 50;
+	constexpr UINT gridCols = 50;
+
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = "landGeo";
+
+	MeshCacheKey key("land");
+	key.Add(GEOMETRY_REVISION).Add(sizeof(Vertex)).Add(gridWidth).Add(gridDepth).Add(gridRows).Add(gridCols);
 
-	std::vector<Vertex> vertices(grid.Vertices.size());
-	for (size_t i = 0; i < grid.Vertices.size(); ++i)
+	if (const auto cached = mMeshCache.Find(key))
 	{
-		const auto& pos = grid.Vertices[i].Position;
-		vertices[i].Position = pos;
-		vertices[i].Position.y = GetHillsHeight(pos.x, pos.z);
-		vertices[i].Normal = GetHillsNormal(pos.x, pos.z);
-		vertices[i].TexCoord = grid.Vertices[i].TexC;
+		UploadGeometry(*geo, "grid", cached->GetData());
+		mGeometries[geo->Name] = std::move(geo);
+		return;
 	}
 
-	std::vector<uint16_t> indices = grid.GetIndices16();
-	const UINT vbByteSize = static_cast<UINT>(vertices.size()) * sizeof(Vertex);
-	const UINT ibByteSize = static_cast<UINT>(indices.size()) * sizeof(uint16_t);
+	const auto gridSize = GeometryGenerator::GetGridSize(gridRows, gridCols);
 
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "landGeo";
+	// The hills reshape the generated grid into our vertex format.
+	MeshArena arena(gridSize.VertexCount * (sizeof(GeometryGenerator::Vertex) + sizeof(Vertex)) +
+		gridSize.IndexCount * sizeof(uint16_t) + 3 * alignof(std::max_align_t));
+	auto* grid = arena.Allocate<GeometryGenerator::Vertex>(gridSize.VertexCount);
+	auto* vertices = arena.Allocate<Vertex>(gridSize.VertexCount);
+	auto* indices = arena.Allocate<uint16_t>(gridSize.IndexCount);
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, geo->VertexBufferCPU.GetAddressOf()));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, geo->IndexBufferCPU.GetAddressOf()));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	GeometryGenerator geoGen;
+	geoGen.CreateGrid(gridWidth, gridDepth, gridRows, gridCols, grid, indices);
 
-	geo->VertexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		vertices.data(), vbByteSize, geo->VertexBufferUploader);
-	geo->IndexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		indices.data(), ibByteSize, geo->IndexBufferUploader);
+	for (size_t i = 0; i < gridSize.VertexCount; ++i)
+	{
+		const auto& pos = grid[i].Position;
+		vertices[i].Position = pos;
+		vertices[i].Position.y = GetHillsHeight(pos.x, pos.z);
+		vertices[i].Normal = GetHillsNormal(pos.x, pos.z);
+		vertices[i].TexCoord = grid[i].TexC;
+	}
 
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+	MeshPart part;
+	part.IndexCount = gridSize.IndexCount;
 
-	SubmeshGeometry submesh;
-	submesh.IndexCount = static_cast<UINT>(indices.size());
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	MeshCacheData mesh;
+	mesh.VertexData   = vertices;
+	mesh.VertexStride = sizeof(Vertex);
+	mesh.VertexCount  = gridSize.VertexCount;
+	mesh.IndexData    = indices;
+	mesh.IndexStride  = sizeof(uint16_t);
+	mesh.IndexCount   = gridSize.IndexCount;
+	mesh.Parts        = &part;
+	mesh.PartCount    = 1;
 
-	geo->DrawArgs["grid"] = submesh;
+	mMeshCache.Store(key, mesh);
+	UploadGeometry(*geo, "grid", mesh);
 
-	mGeometries["landGeo"] = std::move(geo);
+	mGeometries[geo->Name] = std::move(geo);
 }
 
 void MyGame::BuildWavesGeometry()
 {
-	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 
-		mWaves->GetRowCount(), mWaves->GetColumnCount());
+	DX_PROFILE_ZONE("MyGame::BuildWavesGeometry");
+	constexpr float gridWidth = 160.0f;
+	constexpr float gridDepth = 160.0f;
+	const UINT gridRows = mWaves->GetRowCount();
+	const UINT gridCols = mWaves->GetColumnCount();
 
-	std::vector<Vertex> vertices(grid.Vertices.size());
-	for (int i = 0; i < vertices.size(); ++i)
-	{
-		vertices[i].Position = grid.Vertices[i].Position;
-		vertices[i].Normal   = grid.Vertices[i].Normal;
-		vertices[i].TexCoord = grid.Vertices[i].TexC;
-	}
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = "waterGeo";
 
-	std::vector indices(grid.Indices32);
+	MeshCacheKey key("waves");
+	key.Add(GEOMETRY_REVISION).Add(sizeof(Vertex)).Add(gridWidth).Add(gridDepth).Add(gridRows).Add(gridCols);
 
-	const UINT vbByteSize = mWaves->GetVertexCount() * sizeof(Vertex);
-	const UINT ibByteSize = static_cast<UINT>(indices.size()) * sizeof(uint32_t);
+	if (const auto cached = mMeshCache.Find(key))
+	{
+		UploadGeometry(*geo, "grid", cached->GetData());
+		mGeometries[geo->Name] = std::move(geo);
+		return;
+	}
 
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "waterGeo";
+	const auto gridSize = GeometryGenerator::GetGridSize(gridRows, gridCols);
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	memcpy(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	MeshArena arena(gridSize.VertexCount * (sizeof(GeometryGenerator::Vertex) + sizeof(Vertex)) +
+		gridSize.IndexCount * sizeof(uint32_t) + 3 * alignof(std::max_align_t));
+	auto* grid = arena.Allocate<GeometryGenerator::Vertex>(gridSize.VertexCount);
+	auto* vertices = arena.Allocate<Vertex>(gridSize.VertexCount);
+	auto* indices = arena.Allocate<uint32_t>(gridSize.IndexCount);
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, geo->IndexBufferCPU.GetAddressOf()));
-	memcpy(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	GeometryGenerator geoGen;
+	geoGen.CreateGrid(gridWidth, gridDepth, gridRows, gridCols, grid, indices);
 
-	geo->VertexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	// Only the triangle order changes, the vertices still line up with the solution texels.
+	OptimizeVertexCache(indices, gridSize.IndexCount, gridSize.VertexCount);
 
-	geo->IndexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		indices.data(), ibByteSize, geo->IndexBufferUploader);
+	for (size_t i = 0; i < gridSize.VertexCount; ++i)
+	{
+		vertices[i].Position = grid[i].Position;
+		vertices[i].Normal   = grid[i].Normal;
+		vertices[i].TexCoord = grid[i].TexC;
+	}
 
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat         = DXGI_FORMAT_R32_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
+	MeshPart part;
+	part.IndexCount = gridSize.IndexCount;
 
-	SubmeshGeometry submesh;
-	submesh.IndexCount         = static_cast<UINT>(indices.size());
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	MeshCacheData mesh;
+	mesh.VertexData   = vertices;
+	mesh.VertexStride = sizeof(Vertex);
+	mesh.VertexCount  = gridSize.VertexCount;
+	mesh.IndexData    = indices;
+	mesh.IndexStride  = sizeof(uint32_t);
+	mesh.IndexCount   = gridSize.IndexCount;
+	mesh.Parts        = &part;
+	mesh.PartCount    = 1;
 
-	geo->DrawArgs["grid"] = submesh;
+	mMeshCache.Store(key, mesh);
+	UploadGeometry(*geo, "grid", mesh);
 
 	mGeometries[geo->Name] = std::move(geo);
 }
 
 void MyGame::BuildSphereGeometry()
 {
+	DX_PROFILE_ZONE("MyGame::BuildSphereGeometry");
 	using namespace DirectX;
 
+	constexpr float radius = 8.0f;
+	constexpr UINT subdivisions = 0;
+
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = "sphereGeo";
+
+	MeshCacheKey key("sphere");
+	key.Add(GEOMETRY_REVISION).Add(sizeof(Vertex)).Add(radius).Add(subdivisions);
+
+	if (const auto cached = mMeshCache.Find(key))
+	{
+		UploadGeometry(*geo, "sphere", cached->GetData());
+		mGeometries[geo->Name] = std::move(geo);
+		return;
+	}
+
 	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData sphere = geoGen.CreateGeosphere(8.0f, 0);
+	const PackagedMesh sphere = PackageMesh(geoGen.CreateGeosphere(radius, subdivisions));
 
 	std::vector<Vertex> vertices(sphere.Vertices.size());
 	for (int i = 0; i < sphere.Vertices.size(); ++i)
@@ -975,40 +1089,25 @@ void MyGame::BuildSphereGeometry()
 		XMStoreFloat2(&vertices[i].TexCoord, XMVector2Transform(XMLoadFloat2(&sphere.Vertices[i].TexC), m));
 	}
 
-	std::vector<uint16_t> indices = sphere.GetIndices16();
-	const UINT vbByteSize = static_cast<UINT>(vertices.size()) * sizeof(Vertex);
-	const UINT ibByteSize = static_cast<UINT>(indices.size()) * sizeof(uint16_t);
-
-	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "sphereGeo";
-
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, geo->VertexBufferCPU.GetAddressOf()));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, geo->IndexBufferCPU.GetAddressOf()));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-	geo->VertexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		vertices.data(), vbByteSize, geo->VertexBufferUploader);
-	geo->IndexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
-		indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-	geo->IndexBufferByteSize = ibByteSize;
-
-	SubmeshGeometry submesh;
-	submesh.IndexCount = static_cast<UINT>(indices.size());
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	MeshCacheData mesh;
+	mesh.VertexData   = vertices.data();
+	mesh.VertexStride = sizeof(Vertex);
+	mesh.VertexCount  = static_cast<uint32_t>(vertices.size());
+	mesh.IndexData    = sphere.GetIndexData();
+	mesh.IndexStride  = static_cast<uint32_t>(sphere.Width == IndexWidth::Bits16 ? sizeof(uint16_t) : sizeof(uint32_t));
+	mesh.IndexCount   = static_cast<uint32_t>(sphere.GetIndexCount());
+	mesh.Parts        = sphere.Parts.data();
+	mesh.PartCount    = static_cast<uint32_t>(sphere.Parts.size());
 
-	geo->DrawArgs["sphere"] = submesh;
+	mMeshCache.Store(key, mesh);
+	UploadGeometry(*geo, "sphere", mesh);
 
-	mGeometries["sphereGeo"] = std::move(geo);
+	mGeometries[geo->Name] = std::move(geo);
 }
 
 void MyGame::BuildTreeSpriteGeometry()
 {
+	DX_PROFILE_ZONE("MyGame::BuildTreeSpriteGeometry");
 	using namespace DirectX;
 	struct TreeSpriteVertex
 	{
@@ -1061,6 +1160,18 @@ void MyGame::BuildTreeSpriteGeometry()
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 
+	// The geometry shader grows each point into a quad that turns about the
+	// y axis to face the eye.
+	const MeshBounds centers = ComputeBounds(&vertices[0].Pos, vertices.size(), sizeof(TreeSpriteVertex));
+	const float halfWidth = 0.5f * vertices[0].Size.x;
+	const float halfHeight = 0.5f * vertices[0].Size.y;
+	submesh.Bounds = centers.Box;
+	submesh.Bounds.Extents.x += halfWidth;
+	submesh.Bounds.Extents.y += halfHeight;
+	submesh.Bounds.Extents.z += halfWidth;
+	submesh.SphereBounds = centers.Sphere;
+	submesh.SphereBounds.Radius += sqrtf(halfWidth * halfWidth + halfHeight * halfHeight);
+
 	geo->DrawArgs["points"] = submesh;
 
 	mGeometries[geo->Name] = std::move(geo);
@@ -1068,6 +1179,7 @@ void MyGame::BuildTreeSpriteGeometry()
 
 void MyGame::BuildQuadPatchGeometry()
 {
+	DX_PROFILE_ZONE("MyGame::BuildQuadPatchGeometry");
 	using namespace DirectX;
 
 	const std::array<XMFLOAT3, 4> vertices =
@@ -1108,13 +1220,52 @@ void MyGame::BuildQuadPatchGeometry()
 	quadSubmesh.StartIndexLocation = 0;
 	quadSubmesh.BaseVertexLocation = 0;
 
+	// The domain shader lifts the patch onto the same hills as the land grid.
+	quadSubmesh.Bounds       = mGeometries["landGeo"]->DrawArgs["grid"].Bounds;
+	quadSubmesh.SphereBounds = mGeometries["landGeo"]->DrawArgs["grid"].SphereBounds;
+
 	geo->DrawArgs["quadpatch"] = quadSubmesh;
 
 	mGeometries[geo->Name] = std::move(geo);
 }
 
+void MyGame::UploadGeometry(MeshGeometry& geo, const std::string& drawArgName, const MeshCacheData& mesh)
+{
+	const auto vbByteSize = static_cast<UINT>(mesh.GetVertexBufferByteSize());
+	const auto ibByteSize = static_cast<UINT>(mesh.GetIndexBufferByteSize());
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, geo.VertexBufferCPU.GetAddressOf()));
+	CopyMemory(geo.VertexBufferCPU->GetBufferPointer(), mesh.VertexData, vbByteSize);
+
+	ThrowIfFailed(D3DCreateBlob(ibByteSize, geo.IndexBufferCPU.GetAddressOf()));
+	CopyMemory(geo.IndexBufferCPU->GetBufferPointer(), mesh.IndexData, ibByteSize);
+
+	geo.VertexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
+		mesh.VertexData, vbByteSize, geo.VertexBufferUploader);
+	geo.IndexBufferGPU = CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
+		mesh.IndexData, ibByteSize, geo.IndexBufferUploader);
+
+	geo.VertexByteStride     = mesh.VertexStride;
+	geo.VertexBufferByteSize = vbByteSize;
+	geo.IndexFormat          = mesh.IndexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	geo.IndexBufferByteSize  = ibByteSize;
+
+	// Every cached mesh is made of Vertex.
+	std::vector<MeshPart> parts(mesh.Parts, mesh.Parts + mesh.PartCount);
+	std::vector<MeshBounds> bounds;
+	bounds.reserve(parts.size());
+	for (const auto& part : parts)
+	{
+		bounds.push_back(ComputePartBounds(mesh.VertexData, mesh.VertexStride, offsetof(Vertex, Position),
+			mesh.IndexData, mesh.IndexStride, part));
+	}
+
+	geo.AddDrawArgs(drawArgName, parts, bounds);
+}
+
 void MyGame::BuildPipelineStateObjects()
 {
+	DX_PROFILE_ZONE("MyGame::BuildPipelineStateObjects");
 	// PSO for opaque objects.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC opaquePsoDesc{};
 	opaquePsoDesc.InputLayout.pInputElementDescs = mInputLayout.data();
@@ -1281,6 +1432,13 @@ void MyGame::BuildPipelineStateObjects()
 	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&wavesDisturbPso,
 		IID_PPV_ARGS(&mPipelineStateObjects["wavesDisturb"])));
 
+	D3D12_COMPUTE_PIPELINE_STATE_DESC wavesDisturbBatchPso{};
+	wavesDisturbBatchPso.pRootSignature = mWavesRootSignature.Get();
+	wavesDisturbBatchPso.CS.pShaderBytecode = mShaders["wavesDisturbBatchCS"]->GetBufferPointer();
+	wavesDisturbBatchPso.CS.BytecodeLength = mShaders["wavesDisturbBatchCS"]->GetBufferSize();
+	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&wavesDisturbBatchPso,
+		IID_PPV_ARGS(&mPipelineStateObjects["wavesDisturbBatch"])));
+
 	D3D12_COMPUTE_PIPELINE_STATE_DESC wavesUpdatePso{};
 	wavesUpdatePso.pRootSignature = mWavesRootSignature.Get();
 	wavesUpdatePso.CS.pShaderBytecode = mShaders["wavesUpdateCS"]->GetBufferPointer();
@@ -1288,6 +1446,13 @@ void MyGame::BuildPipelineStateObjects()
 	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&wavesUpdatePso,
 		IID_PPV_ARGS(&mPipelineStateObjects["wavesUpdate"])));
 
+	D3D12_COMPUTE_PIPELINE_STATE_DESC wavesNormalPso{};
+	wavesNormalPso.pRootSignature = mWavesRootSignature.Get();
+	wavesNormalPso.CS.pShaderBytecode = mShaders["wavesNormalCS"]->GetBufferPointer();
+	wavesNormalPso.CS.BytecodeLength = mShaders["wavesNormalCS"]->GetBufferSize();
+	ThrowIfFailed(md3dDevice->CreateComputePipelineState(&wavesNormalPso,
+		IID_PPV_ARGS(&mPipelineStateObjects["wavesNormal"])));
+
 	// PSO for composition of Sobel filter
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC compositePsoDesc = opaquePsoDesc;
 	compositePsoDesc.SampleDesc.Count = 1;
@@ -1314,6 +1479,7 @@ void MyGame::BuildPipelineStateObjects()
 
 void MyGame::BuildFrameResources()
 {
+	DX_PROFILE_ZONE("MyGame::BuildFrameResources");
 	for (int i = 0; i < FRAME_RESOURCES_NUM; ++i)
 	{
 		mFrameResources.push_back(
@@ -1322,7 +1488,8 @@ void MyGame::BuildFrameResources()
 				md3dDevice.Get(),
 				1,
 				static_cast<UINT>(mRenderItems.size()),
-				static_cast<UINT>(mMaterials.size())
+				static_cast<UINT>(mMaterials.size()),
+				Waves::MAX_DISTURB_CELLS
 			)
 		);
 	}
@@ -1330,6 +1497,7 @@ void MyGame::BuildFrameResources()
 
 void MyGame::BuildMaterials()
 {
+	DX_PROFILE_ZONE("MyGame::BuildMaterials");
 	using namespace DirectX;
 
 	auto grass = std::make_unique<Material>();
@@ -1372,15 +1540,17 @@ void MyGame::BuildMaterials()
 
 void MyGame::BuildRenderItems()
 {
+	DX_PROFILE_ZONE("MyGame::BuildRenderItems");
 	using namespace DirectX;
 
 	// be careful with member ObjConstBuffIdx
 	int objConstBuffIndex = 0;
 	
 	auto wave = std::make_unique<RenderItem>();
-	wave->World              = MathHelper::Identity4x4();
+	wave->SetWorld(XMMatrixIdentity());
 	XMStoreFloat4x4(&wave->TexTransform, XMMatrixScaling(5.0f, 5.0f, 1.0f));
 	wave->GridSpatialStep = mWaves->GetSpatialStep();
+	wave->DisplacementScale = mWaves->GetDisplacementScale();
 	wave->DisplacementMapTexelSize = { 1.0f / mWaves->GetColumnCount(), 1.0f / mWaves->GetRowCount() };
 	wave->ObjConstBuffIndex  = objConstBuffIndex++;
 	wave->Material           = mMaterials["water"].get();
@@ -1389,12 +1559,19 @@ void MyGame::BuildRenderItems()
 	wave->IndexCount         = wave->Geometry->DrawArgs["grid"].IndexCount;
 	wave->StartIndexLocation = wave->Geometry->DrawArgs["grid"].StartIndexLocation;
 	wave->BaseVertexLocation = wave->Geometry->DrawArgs["grid"].BaseVertexLocation;
+	wave->Bounds             = wave->Geometry->DrawArgs["grid"].Bounds;
+	wave->SphereBounds       = wave->Geometry->DrawArgs["grid"].SphereBounds;
+
+	// The grid is cached flat; wavesVS moves it up or down by at most this much.
+	const float maxDisplacement = mWaves->GetDisplacementRange() * mWaves->GetDisplacementScale();
+	wave->Bounds.Extents.y    += maxDisplacement;
+	wave->SphereBounds.Radius += maxDisplacement;
 
 	mRenderItemLayer[static_cast<int>(RenderLayer::GpuWaves)].push_back(wave.get());
 	mRenderItems.push_back(std::move(wave));
 	
 	//auto land = std::make_unique<RenderItem>();
-	//land->World              = MathHelper::Identity4x4();
+	//land->SetWorld(XMMatrixIdentity());
 	//XMStoreFloat4x4(&land->TexTransform, XMMatrixScaling(20.0f, 20.0f, 1.0f));
 	//land->ObjConstBuffIndex  = objConstBuffIndex++;
 	//land->Material           = mMaterials["grass"].get();
@@ -1407,21 +1584,30 @@ void MyGame::BuildRenderItems()
 	//mRenderItemLayer[static_cast<int>(RenderLayer::Opaque)].push_back(land.get());
 	//mRenderItems.push_back(std::move(land));
 	
-	auto sphere = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&sphere->World, XMMatrixTranslation(3.0f, 5.0f, -9.0f));
-	sphere->ObjConstBuffIndex  = objConstBuffIndex++;
-	sphere->Material           = mMaterials["wireFence"].get();
-	sphere->Geometry           = mGeometries["sphereGeo"].get();
-	sphere->PrimitiveType      = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	sphere->IndexCount         = sphere->Geometry->DrawArgs["sphere"].IndexCount;
-	sphere->StartIndexLocation = sphere->Geometry->DrawArgs["sphere"].StartIndexLocation;
-	sphere->BaseVertexLocation = sphere->Geometry->DrawArgs["sphere"].BaseVertexLocation;
-
-	mRenderItemLayer[static_cast<int>(RenderLayer::AlphaTested)].push_back(sphere.get());
-	mRenderItems.push_back(std::move(sphere));
+	// PackageMesh splits the sphere into sphere#0, sphere#1, ... once it
+	// outgrows 16-bit indices; each part is its own render item.
+	const auto sphereParts = mGeometries["sphereGeo"]->FindDrawArgs("sphere");
+	assert(!sphereParts.empty());
+	for (const SubmeshGeometry* part : sphereParts)
+	{
+		auto sphere = std::make_unique<RenderItem>();
+		sphere->SetWorld(XMMatrixTranslation(3.0f, 5.0f, -9.0f));
+		sphere->ObjConstBuffIndex  = objConstBuffIndex++;
+		sphere->Material           = mMaterials["wireFence"].get();
+		sphere->Geometry           = mGeometries["sphereGeo"].get();
+		sphere->PrimitiveType      = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		sphere->IndexCount         = part->IndexCount;
+		sphere->StartIndexLocation = part->StartIndexLocation;
+		sphere->BaseVertexLocation = part->BaseVertexLocation;
+		sphere->Bounds             = part->Bounds;
+		sphere->SphereBounds       = part->SphereBounds;
+
+		mRenderItemLayer[static_cast<int>(RenderLayer::AlphaTested)].push_back(sphere.get());
+		mRenderItems.push_back(std::move(sphere));
+	}
 	
 	auto treeSprite = std::make_unique<RenderItem>();
-	treeSprite->World              = MathHelper::Identity4x4();
+	treeSprite->SetWorld(XMMatrixIdentity());
 	treeSprite->ObjConstBuffIndex  = objConstBuffIndex++;
 	treeSprite->Material           = mMaterials["treeSprite"].get();
 	treeSprite->Geometry           = mGeometries["treeSpriteGeo"].get();
@@ -1429,12 +1615,14 @@ void MyGame::BuildRenderItems()
 	treeSprite->IndexCount         = treeSprite->Geometry->DrawArgs["points"].IndexCount;
 	treeSprite->StartIndexLocation = treeSprite->Geometry->DrawArgs["points"].StartIndexLocation;
 	treeSprite->BaseVertexLocation = treeSprite->Geometry->DrawArgs["points"].BaseVertexLocation;
+	treeSprite->Bounds             = treeSprite->Geometry->DrawArgs["points"].Bounds;
+	treeSprite->SphereBounds       = treeSprite->Geometry->DrawArgs["points"].SphereBounds;
 
 	mRenderItemLayer[static_cast<int>(RenderLayer::AlphaTestedTreeSprite)].push_back(treeSprite.get());
 	mRenderItems.push_back(std::move(treeSprite));
 	
 	auto quadPatch = std::make_unique<RenderItem>();
-	quadPatch->World              = MathHelper::Identity4x4();
+	quadPatch->SetWorld(XMMatrixIdentity());
 	XMStoreFloat4x4(&quadPatch->TexTransform, XMMatrixScaling(20.0f, 20.0f, 1.0f));
 	quadPatch->ObjConstBuffIndex  = objConstBuffIndex++;
 	quadPatch->Material           = mMaterials["grass"].get();
@@ -1443,6 +1631,8 @@ void MyGame::BuildRenderItems()
 	quadPatch->IndexCount         = quadPatch->Geometry->DrawArgs["quadpatch"].IndexCount;
 	quadPatch->StartIndexLocation = quadPatch->Geometry->DrawArgs["quadpatch"].StartIndexLocation;
 	quadPatch->BaseVertexLocation = quadPatch->Geometry->DrawArgs["quadpatch"].BaseVertexLocation;
+	quadPatch->Bounds             = quadPatch->Geometry->DrawArgs["quadpatch"].Bounds;
+	quadPatch->SphereBounds       = quadPatch->Geometry->DrawArgs["quadpatch"].SphereBounds;
 
 	mRenderItemLayer[(int)RenderLayer::Tessellation].push_back(quadPatch.get());
 	mRenderItems.push_back(std::move(quadPatch));
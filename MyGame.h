@@ -8,6 +8,7 @@
 #include "BlurFilter.h"
 #include "MidwayTexture.h"
 #include "SobelFilter.h"
+#include "MeshCache.h"
 
 #ifdef _DEBUG
 	//#define VISUALIZE_NORMAL
@@ -16,11 +17,23 @@
 struct RenderItem
 {
 	RenderItem() = default;
-	DirectX::XMFLOAT4X4 World                   = DX::MathHelper::Identity4x4();
+
+	// Classifies the world matrix for its inverse-transpose and marks the item dirty.
+	void XM_CALLCONV SetWorld(DirectX::FXMMATRIX world)
+	{
+		DirectX::XMStoreFloat4x4(&mWorld, world);
+		mWorldClass = DX::MathHelper::ClassifyTransform(world);
+		NumFrameDirty = DX::FRAME_RESOURCES_NUM;
+	}
+
+	[[nodiscard]] const DirectX::XMFLOAT4X4& GetWorld() const { return mWorld; }
+	[[nodiscard]] DX::TransformClass GetWorldClass() const { return mWorldClass; }
+
 	DirectX::XMFLOAT4X4 TexTransform            = DX::MathHelper::Identity4x4();
 
 	DirectX::XMFLOAT2 DisplacementMapTexelSize  = { 1.0f, 1.0f };
 	float GridSpatialStep                       = 1.0f;
+	float DisplacementScale                     = 1.0f;
 
 	int NumFrameDirty                           = DX::FRAME_RESOURCES_NUM;
 	UINT ObjConstBuffIndex                      = -1;
@@ -31,6 +44,15 @@ struct RenderItem
 	UINT IndexCount                             = 0;
 	UINT StartIndexLocation                     = 0;
 	int BaseVertexLocation                      = 0;
+
+	// Object space; transform by the world matrix before culling.
+	DirectX::BoundingBox Bounds                 = {};
+	DirectX::BoundingSphere SphereBounds        = {};
+
+private:
+	// Only SetWorld writes these, so the class always matches the matrix.
+	DirectX::XMFLOAT4X4 mWorld                  = DX::MathHelper::Identity4x4();
+	DX::TransformClass mWorldClass              = DX::TransformClass::Rigid;
 };
 
 enum class RenderLayer : int
@@ -71,7 +93,7 @@ private:
 	void OnKeyboardInput         (const GameTimer& gameTimer);
 	void UpdateCamera            (const GameTimer& gameTimer);
 	void AnimateMaterials		 (const GameTimer& gameTimer);
-	void UpdateObjectConstBuffs  (const GameTimer& gameTimer) const;
+	void UpdateObjectConstBuffs  (const GameTimer& gameTimer);
 	void UpdateMaterialConstBuffs(const GameTimer& gameTimer) const;
 	void UpdateMainPassConstBuffs(const GameTimer& gameTimer);
 	void UpdateWavesGpu			 (const GameTimer& gameTimer);
@@ -87,6 +109,7 @@ private:
 	void BuildSphereGeometry();
 	void BuildTreeSpriteGeometry();
 	void BuildQuadPatchGeometry();
+	void UploadGeometry(DX::MeshGeometry& geo, const std::string& drawArgName, const DX::MeshCacheData& mesh);
 	void BuildPipelineStateObjects();
 	void BuildFrameResources();
 	void BuildMaterials();
@@ -133,11 +156,22 @@ private:
 	std::vector<std::unique_ptr<RenderItem>> mRenderItems{};
 	std::vector<RenderItem*> mRenderItemLayer[static_cast<int>(RenderLayer::Count)]{};
 
+	// Scratch of UpdateObjectConstBuffs, members so their storage is reused.
+	std::vector<RenderItem*> mDirtyItems{};
+	std::vector<DirectX::XMFLOAT4X4> mWorldInvTs{};
+	std::vector<size_t> mBatchedItems{};
+	std::vector<float> mBatchedTransforms{};
+
 	std::unique_ptr<DX::Waves>         mWaves{};
+	// Drops due this frame, a member so its storage is reused.
+	std::vector<DX::WaveDisturbance>   mWaveDrops{};
 	std::unique_ptr<DX::BlurFilter>    mBlurFilter{};
 	std::unique_ptr<DX::SobelFilter>   mSobelFilter{};
 	std::unique_ptr<DX::MidwayTexture> mMsaaResolveDest;
 
+	// Generated meshes, kept next to the executable between launches.
+	DX::MeshCache mMeshCache{ "MeshCache" };
+
 	DX::PassConstants mMainPassConstBuff;
 
 	DirectX::XMFLOAT3 mEyePos{};
@@ -0,0 +1,253 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using SteadyClock = std::chrono::steady_clock;
+
+	// The time stamp counter is calibrated against steady_clock over at
+	// least this long, waiting out the rest if an export comes sooner.
+	constexpr std::chrono::milliseconds MIN_CALIBRATION_TIME{ 50 };
+
+	struct Origin
+	{
+		uint64 Ticks = DX::Profiler::GetTicks();
+		SteadyClock::time_point Time = SteadyClock::now();
+	};
+
+	const Origin& GetOrigin()
+	{
+		static const Origin origin;
+		return origin;
+	}
+
+	double GetTicksPerSecond()
+	{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		const Origin& origin = GetOrigin();
+		std::this_thread::sleep_until(origin.Time + MIN_CALIBRATION_TIME);
+
+		const Origin now;
+		const std::chrono::duration<double> elapsed = now.Time - origin.Time;
+		return static_cast<double>(now.Ticks - origin.Ticks) / elapsed.count();
+#else
+		using Period = SteadyClock::period;
+		return static_cast<double>(Period::den) / static_cast<double>(Period::num);
+#endif
+	}
+
+	void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* c = text; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\') stream << '\\' << *c;
+			else if (static_cast<unsigned char>(*c) < 0x20) stream << ' ';
+			else stream << *c;
+		}
+		stream << '"';
+	}
+}
+
+struct DX::Profiler::Registry
+{
+	std::mutex Mutex;
+	std::vector<std::unique_ptr<ThreadEvents>> Threads;
+	std::vector<std::string> Names;
+};
+
+DX::Profiler::Registry& DX::Profiler::GetRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+DX::Profiler::ThreadEvents* DX::Profiler::RegisterThread()
+{
+	GetOrigin();
+
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.Mutex);
+	registry.Threads.push_back(std::make_unique<ThreadEvents>());
+	registry.Names.push_back("Thread " + std::to_string(registry.Threads.size() - 1));
+
+	tEvents = registry.Threads.back().get();
+	return tEvents;
+}
+
+void DX::Profiler::SetThreadName(const std::string& name)
+{
+	const ThreadEvents* events = tEvents != nullptr ? tEvents : RegisterThread();
+
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.Mutex);
+	for (size_t i = 0; i < registry.Threads.size(); ++i)
+	{
+		if (registry.Threads[i].get() == events) registry.Names[i] = name;
+	}
+}
+
+void DX::Profiler::Clear()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.Mutex);
+	for (const auto& events : registry.Threads)
+	{
+		events->First.store(events->Count.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+}
+
+std::vector<DX::Profiler::ThreadSnapshot> DX::Profiler::TakeSnapshots()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock(registry.Mutex);
+
+	std::vector<ThreadSnapshot> snapshots(registry.Threads.size());
+	for (size_t t = 0; t < registry.Threads.size(); ++t)
+	{
+		const ThreadEvents& events = *registry.Threads[t];
+		ThreadSnapshot& snapshot = snapshots[t];
+		snapshot.Name = registry.Names[t];
+
+		const uint64 count = events.Count.load(std::memory_order_acquire);
+		uint64 first = std::max(events.First.load(std::memory_order_relaxed), count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0);
+		for (uint64 i = first; i < count; ++i)
+		{
+			const Event& event = events.Events[i % EVENTS_PER_THREAD];
+			snapshot.Events.push_back({
+				event.Name.load(std::memory_order_relaxed),
+				event.Begin.load(std::memory_order_relaxed),
+				event.End.load(std::memory_order_relaxed) });
+		}
+
+		// Drop the oldest slots if the writer came round to them during the copy;
+		// the one at index after may be half written.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64 after = events.Count.load(std::memory_order_relaxed);
+		if (after + 1 > first + EVENTS_PER_THREAD)
+		{
+			const uint64 stale = std::min<uint64>(after + 1 - EVENTS_PER_THREAD - first, snapshot.Events.size());
+			snapshot.Events.erase(snapshot.Events.begin(), snapshot.Events.begin() + static_cast<std::ptrdiff_t>(stale));
+		}
+
+		// Parents before their children, so nesting can be rebuilt with a stack.
+		std::sort(snapshot.Events.begin(), snapshot.Events.end(), [](const EventCopy& a, const EventCopy& b)
+		{
+			return a.Begin != b.Begin ? a.Begin < b.Begin : a.End > b.End;
+		});
+	}
+	return snapshots;
+}
+
+void DX::Profiler::WriteChromeTrace(std::ostream& stream)
+{
+	const auto snapshots = TakeSnapshots();
+	const double ticksPerMicrosecond = GetTicksPerSecond() * 1e-6;
+	const auto originTicks = static_cast<double>(GetOrigin().Ticks);
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (size_t t = 0; t < snapshots.size(); ++t)
+	{
+		stream << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t << ",\"args\":{\"name\":";
+		WriteJsonString(stream, snapshots[t].Name.c_str());
+		stream << "}}";
+		first = false;
+
+		for (const EventCopy& event : snapshots[t].Events)
+		{
+			const double begin = (static_cast<double>(event.Begin) - originTicks) / ticksPerMicrosecond;
+			const double duration = static_cast<double>(event.End - event.Begin) / ticksPerMicrosecond;
+
+			stream << ",\n{\"name\":";
+			WriteJsonString(stream, event.Name);
+			stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << t << std::fixed << std::setprecision(3)
+				<< ",\"ts\":" << begin << ",\"dur\":" << duration << "}";
+			stream.unsetf(std::ios_base::floatfield);
+		}
+	}
+	stream << "\n]}\n";
+}
+
+bool DX::Profiler::WriteChromeTrace(const std::string& fileName)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file) return false;
+	WriteChromeTrace(file);
+	return static_cast<bool>(file);
+}
+
+std::vector<DX::Profiler::ZoneStats> DX::Profiler::GetSummary()
+{
+	const auto snapshots = TakeSnapshots();
+	const double ticksPerMillisecond = GetTicksPerSecond() * 1e-3;
+
+	std::unordered_map<std::string, ZoneStats> zones;
+	for (const ThreadSnapshot& snapshot : snapshots)
+	{
+		const auto& events = snapshot.Events;
+
+		// Time of the zones directly inside each event.
+		std::vector<uint64> childTicks(events.size(), 0);
+		std::vector<size_t> open;
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			while (!open.empty() && events[open.back()].End <= events[i].Begin) open.pop_back();
+			if (!open.empty()) childTicks[open.back()] += events[i].End - events[i].Begin;
+			open.push_back(i);
+		}
+
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			const uint64 ticks = events[i].End - events[i].Begin;
+			const double ms = static_cast<double>(ticks) / ticksPerMillisecond;
+
+			ZoneStats& zone = zones[events[i].Name];
+			++zone.Count;
+			zone.TotalMs += ms;
+			zone.SelfMs += static_cast<double>(ticks - std::min(ticks, childTicks[i])) / ticksPerMillisecond;
+			zone.MaxMs = std::max(zone.MaxMs, ms);
+		}
+	}
+
+	std::vector<ZoneStats> summary;
+	summary.reserve(zones.size());
+	for (auto& [name, zone] : zones)
+	{
+		zone.Name = name;
+		summary.push_back(std::move(zone));
+	}
+	std::sort(summary.begin(), summary.end(), [](const ZoneStats& a, const ZoneStats& b) { return a.TotalMs > b.TotalMs; });
+	return summary;
+}
+
+void DX::Profiler::WriteSummary(std::ostream& stream)
+{
+	const auto summary = GetSummary();
+
+	size_t nameWidth = 4;
+	for (const ZoneStats& zone : summary) nameWidth = std::max(nameWidth, zone.Name.size());
+
+	stream << std::left << std::setw(static_cast<int>(nameWidth)) << "zone" << std::right
+		<< std::setw(10) << "count" << std::setw(12) << "total ms" << std::setw(12) << "self ms"
+		<< std::setw(12) << "avg ms" << std::setw(12) << "max ms" << '\n';
+
+	stream << std::fixed << std::setprecision(3);
+	for (const ZoneStats& zone : summary)
+	{
+		stream << std::left << std::setw(static_cast<int>(nameWidth)) << zone.Name << std::right
+			<< std::setw(10) << zone.Count << std::setw(12) << zone.TotalMs << std::setw(12) << zone.SelfMs
+			<< std::setw(12) << zone.TotalMs / static_cast<double>(zone.Count) << std::setw(12) << zone.MaxMs << '\n';
+	}
+	stream.unsetf(std::ios_base::floatfield);
+}
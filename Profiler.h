@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Set to 0 to compile every DX_PROFILE_ZONE out. The export functions stay
+// and report nothing, so tools that call them build either way. D3DApp
+// writes Profile.json (Chrome trace) and Profile.txt (summary) on F9 and
+// when the app exits.
+#if !defined(DX_PROFILER)
+#define DX_PROFILER 1
+#endif
+
+namespace DX
+{
+	class ProfileZone;
+
+	/**
+	 * \brief Scoped CPU zones recorded into one ring buffer per thread and
+	 * exported as Chrome trace_event JSON (chrome://tracing, Perfetto) or as
+	 * a flat per-zone summary. A zone reads the time stamp counter when it
+	 * opens and closes and writes one event into its thread's ring; there
+	 * are no locks or shared writes on that path, only the first zone of a
+	 * thread takes a lock to register its ring. The two counter reads are
+	 * nearly all a zone costs, so that follows rdtsc: some 20-40 cycles on
+	 * bare metal, far more where a hypervisor traps it. The rings keep the
+	 * most recent EVENTS_PER_THREAD zones of each thread and can be
+	 * exported from any thread while others record.
+	 */
+	class Profiler
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+		using uint64 = std::uint64_t;
+
+		static constexpr uint32 EVENTS_PER_THREAD = 1 << 16;
+
+		struct ZoneStats
+		{
+			std::string Name;
+			uint64 Count = 0;
+			double TotalMs = 0.0;
+			// Total less the time spent in zones nested inside, on the same thread.
+			double SelfMs = 0.0;
+			double MaxMs = 0.0;
+		};
+
+		Profiler() = delete;
+
+		[[nodiscard]] static uint64 GetTicks()
+		{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return static_cast<uint64>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+		}
+
+		static void Record(const char* name, const uint64 begin, const uint64 end)
+		{
+			Write(GetThreadEvents(), name, begin, end);
+		}
+
+		// Names the calling thread in traces; threads are "Thread N" otherwise.
+		static void SetThreadName(const std::string& name);
+
+		// Drops everything recorded so far, on every thread.
+		static void Clear();
+
+		static void WriteChromeTrace(std::ostream& stream);
+		static bool WriteChromeTrace(const std::string& fileName);
+
+		// One entry per zone name, by decreasing total time.
+		[[nodiscard]] static std::vector<ZoneStats> GetSummary();
+		static void WriteSummary(std::ostream& stream);
+
+	private:
+		friend class ProfileZone;
+
+		// Relaxed atomics, plain stores on x86 and x64, so that a reader
+		// copying a slot the writer is overwriting is not a data race.
+		struct Event
+		{
+			std::atomic<const char*> Name = nullptr;
+			std::atomic<uint64> Begin = 0;
+			std::atomic<uint64> End = 0;
+		};
+
+		struct ThreadEvents
+		{
+			std::atomic<uint64> Count = 0;
+			// Events below this index were cleared.
+			std::atomic<uint64> First = 0;
+			std::array<Event, EVENTS_PER_THREAD> Events{};
+		};
+
+		struct EventCopy
+		{
+			const char* Name;
+			uint64 Begin;
+			uint64 End;
+		};
+
+		struct ThreadSnapshot
+		{
+			std::string Name;
+			std::vector<EventCopy> Events;
+		};
+
+		struct Registry;
+
+		static Registry& GetRegistry();
+		static ThreadEvents* RegisterThread();
+
+		// The calling thread's ring. The first call on a thread registers it,
+		// and with it the trace origin, so zones that fetch their ring before
+		// reading the counter never begin before the origin.
+		static ThreadEvents& GetThreadEvents()
+		{
+			ThreadEvents* events = tEvents;
+			return events != nullptr ? *events : *RegisterThread();
+		}
+
+		static void Write(ThreadEvents& events, const char* name, const uint64 begin, const uint64 end)
+		{
+			const uint64 count = events.Count.load(std::memory_order_relaxed);
+			Event& event = events.Events[count % EVENTS_PER_THREAD];
+			event.Name.store(name, std::memory_order_relaxed);
+			event.Begin.store(begin, std::memory_order_relaxed);
+			event.End.store(end, std::memory_order_relaxed);
+			events.Count.store(count + 1, std::memory_order_release);
+		}
+
+		// Every thread's events in order of Begin, parents before children.
+		static std::vector<ThreadSnapshot> TakeSnapshots();
+
+		static inline thread_local ThreadEvents* tEvents = nullptr;
+	};
+
+	// Holds on to its thread's ring so that closing makes no thread-local
+	// lookup; the two counter reads are most of what a zone costs.
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name) :
+			mEvents(Profiler::GetThreadEvents()), mName(name), mBegin(Profiler::GetTicks()) {}
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone(const ProfileZone&&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&&) = delete;
+		~ProfileZone() { Profiler::Write(mEvents, mName, mBegin, Profiler::GetTicks()); }
+
+	private:
+		Profiler::ThreadEvents& mEvents;
+		const char* mName;
+		Profiler::uint64 mBegin;
+	};
+}
+
+#define DX_PROFILE_CONCAT_INNER(a, b) a##b
+#define DX_PROFILE_CONCAT(a, b) DX_PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope. name must outlive the export,
+// which string literals do.
+#if DX_PROFILER
+#define DX_PROFILE_ZONE(name) const ::DX::ProfileZone DX_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define DX_PROFILE_ZONE(name) ((void)0)
+#endif
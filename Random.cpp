@@ -0,0 +1,189 @@
+#include "Random.h"
+#include "CpuFeatures.h"
+#include "RandomKernels.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	// Draws converted per round of the batch fills, kept on the stack.
+	constexpr size_t FILL_BLOCKS = 32;
+
+	// The AVX2 lane stepper when both the processor and the build have it.
+	const DX::RandomKernels::NextBlocksKernel gAvx2NextBlocks =
+		DX::GetCpuFeatures().Avx2 ? DX::RandomKernels::GetAvx2NextBlocks() : nullptr;
+
+	std::atomic<uint64> gGlobalSeed = DX::Random::DEFAULT_SEED;
+	std::atomic<uint64> gThreadOrdinal = 0;
+
+	uint32 Rotl(const uint32 x, const int k)
+	{
+		return (x << k) | (x >> (32 - k));
+	}
+
+	// Spreads a 64-bit seed over generator state, as the xoshiro authors recommend.
+	uint64 SplitMix64(uint64& state)
+	{
+		uint64 z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// xoshiro128** step on one state.
+	uint32 Next(uint32& s0, uint32& s1, uint32& s2, uint32& s3)
+	{
+		const uint32 result = Rotl(s1 * 5, 7) * 9;
+		const uint32 t = s1 << 9;
+
+		s2 ^= s0;
+		s3 ^= s1;
+		s1 ^= s2;
+		s0 ^= s3;
+		s2 ^= t;
+		s3 = Rotl(s3, 11);
+
+		return result;
+	}
+
+	float ToUnitFloat(const uint32 x)
+	{
+		return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+void DX::RandomKernels::NextBlocksScalar(uint32* lanes, uint32* values, const size_t blockCount)
+{
+	constexpr size_t LANE_COUNT = Random::LANE_COUNT;
+	uint32* s0 = lanes;
+	uint32* s1 = lanes + LANE_COUNT;
+	uint32* s2 = lanes + 2 * LANE_COUNT;
+	uint32* s3 = lanes + 3 * LANE_COUNT;
+
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		for (size_t lane = 0; lane < LANE_COUNT; ++lane)
+		{
+			values[block * LANE_COUNT + lane] = Next(s0[lane], s1[lane], s2[lane], s3[lane]);
+		}
+	}
+}
+
+DX::Random::Random(const uint64 seed)
+{
+	Seed(seed);
+}
+
+void DX::Random::Seed(uint64 seed)
+{
+	// SplitMix64 keeps xoshiro away from the all-zero state it cannot leave.
+	for (uint32& word : mState) word = static_cast<uint32>(SplitMix64(seed));
+	for (auto& lane : mLanes)
+	{
+		for (uint32& word : lane) word = static_cast<uint32>(SplitMix64(seed));
+	}
+}
+
+DX::Random::uint32 DX::Random::NextUInt()
+{
+	return Next(mState[0], mState[1], mState[2], mState[3]);
+}
+
+float DX::Random::NextFloat()
+{
+	return ToUnitFloat(NextUInt());
+}
+
+float DX::Random::NextFloat(const float a, const float b)
+{
+	return a + NextFloat() * (b - a);
+}
+
+int DX::Random::NextInt(const int a, const int b)
+{
+	// Lemire's multiply-shift, redrawing the few values that would bias it.
+	const uint32 range = static_cast<uint32>(b) - static_cast<uint32>(a) + 1;
+	if (range == 0) return static_cast<int>(NextUInt());
+
+	uint64 product = uint64(NextUInt()) * range;
+	if (static_cast<uint32>(product) < range)
+	{
+		const uint32 threshold = (0u - range) % range;
+		while (static_cast<uint32>(product) < threshold) product = uint64(NextUInt()) * range;
+	}
+	return static_cast<int>(static_cast<uint32>(a) + static_cast<uint32>(product >> 32));
+}
+
+void DX::Random::NextBlocks(uint32* values, const size_t blockCount)
+{
+	static_assert(sizeof(mLanes) == 4 * LANE_COUNT * sizeof(uint32));
+
+	if (gAvx2NextBlocks != nullptr)
+	{
+		gAvx2NextBlocks(&mLanes[0][0], values, blockCount);
+		return;
+	}
+
+	RandomKernels::NextBlocksScalar(&mLanes[0][0], values, blockCount);
+}
+
+void DX::Random::Fill(uint32* values, const size_t count)
+{
+	const size_t fullBlocks = count / LANE_COUNT;
+	NextBlocks(values, fullBlocks);
+
+	const size_t done = fullBlocks * LANE_COUNT;
+	if (done < count)
+	{
+		uint32 block[LANE_COUNT];
+		NextBlocks(block, 1);
+		std::copy(block, block + (count - done), values + done);
+	}
+}
+
+void DX::Random::Fill(float* values, const size_t count, const float a, const float b)
+{
+	uint32 bits[FILL_BLOCKS * LANE_COUNT];
+	const float range = b - a;
+
+	for (size_t done = 0; done < count;)
+	{
+		const size_t n = std::min(count - done, FILL_BLOCKS * LANE_COUNT);
+		NextBlocks(bits, (n + LANE_COUNT - 1) / LANE_COUNT);
+		for (size_t i = 0; i < n; ++i) values[done + i] = a + ToUnitFloat(bits[i]) * range;
+		done += n;
+	}
+}
+
+void DX::Random::Fill(int* values, const size_t count, const int a, const int b)
+{
+	uint32 bits[FILL_BLOCKS * LANE_COUNT];
+	const uint32 range = static_cast<uint32>(b) - static_cast<uint32>(a) + 1;
+
+	for (size_t done = 0; done < count;)
+	{
+		const size_t n = std::min(count - done, FILL_BLOCKS * LANE_COUNT);
+		NextBlocks(bits, (n + LANE_COUNT - 1) / LANE_COUNT);
+		for (size_t i = 0; i < n; ++i)
+		{
+			const uint32 offset = range == 0 ? bits[i] : static_cast<uint32>((uint64(bits[i]) * range) >> 32);
+			values[done + i] = static_cast<int>(static_cast<uint32>(a) + offset);
+		}
+		done += n;
+	}
+}
+
+DX::Random& DX::Random::ThreadLocal()
+{
+	thread_local Random random(gGlobalSeed.load() ^ (gThreadOrdinal++ * 0x9e3779b97f4a7c15ull));
+	return random;
+}
+
+void DX::Random::SetGlobalSeed(const uint64 seed)
+{
+	gGlobalSeed = seed;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+	/**
+	 * \brief Seedable xoshiro128** generator. Single draws come from one
+	 * state; the Fill functions run eight further interleaved states in
+	 * lock step, with AVX2 when the processor has it and an identical
+	 * scalar loop otherwise, so a seed gives the same bits on every
+	 * platform and instruction set. Not thread-safe; use ThreadLocal.
+	 */
+	class Random
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+		using uint64 = std::uint64_t;
+
+		static constexpr uint64 DEFAULT_SEED = 0x853c49e6748fea9bull;
+		static constexpr size_t LANE_COUNT = 8;
+
+		explicit Random(uint64 seed = DEFAULT_SEED);
+
+		void Seed(uint64 seed);
+
+		uint32 NextUInt();
+
+		// Uniform in [0, 1), with 24 random bits.
+		float NextFloat();
+
+		// Uniform in [a, b).
+		float NextFloat(float a, float b);
+
+		// Uniform in [a, b], without modulo bias.
+		int NextInt(int a, int b);
+
+		// Batch forms of the draws above. Draws are made eight at a time and
+		// the ones past count are discarded. The integer form uses a
+		// multiply-shift without rejection, biased by less than (b - a + 1) / 2^32.
+		void Fill(uint32* values, size_t count);
+		void Fill(float* values, size_t count, float a = 0.0f, float b = 1.0f);
+		void Fill(int* values, size_t count, int a, int b);
+
+		// This thread's generator. Each thread is seeded from the global seed
+		// and the order in which threads first call this, so a run that
+		// starts its threads in the same order repeats itself.
+		static Random& ThreadLocal();
+
+		// Takes effect for threads that have not called ThreadLocal yet; call
+		// it at startup to reseed the whole program.
+		static void SetGlobalSeed(uint64 seed);
+
+	private:
+		// Steps the lanes blockCount times, writing LANE_COUNT outputs per step.
+		void NextBlocks(uint32* values, size_t blockCount);
+
+	private:
+		uint32 mState[4];
+		alignas(32) uint32 mLanes[4][LANE_COUNT];
+	};
+}
@@ -0,0 +1,52 @@
+#include "RandomKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+	constexpr size_t LANE_COUNT = 8;
+
+	void NextBlocks(std::uint32_t* lanes, std::uint32_t* values, const size_t blockCount)
+	{
+		auto* words = reinterpret_cast<__m256i*>(lanes);
+		__m256i s0 = _mm256_load_si256(words + 0);
+		__m256i s1 = _mm256_load_si256(words + 1);
+		__m256i s2 = _mm256_load_si256(words + 2);
+		__m256i s3 = _mm256_load_si256(words + 3);
+
+		const __m256i five = _mm256_set1_epi32(5);
+		const __m256i nine = _mm256_set1_epi32(9);
+
+		for (size_t block = 0; block < blockCount; ++block)
+		{
+			const __m256i m = _mm256_mullo_epi32(s1, five);
+			const __m256i rotated = _mm256_or_si256(_mm256_slli_epi32(m, 7), _mm256_srli_epi32(m, 25));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + block * LANE_COUNT), _mm256_mullo_epi32(rotated, nine));
+
+			const __m256i t = _mm256_slli_epi32(s1, 9);
+			s2 = _mm256_xor_si256(s2, s0);
+			s3 = _mm256_xor_si256(s3, s1);
+			s1 = _mm256_xor_si256(s1, s2);
+			s0 = _mm256_xor_si256(s0, s3);
+			s2 = _mm256_xor_si256(s2, t);
+			s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+		}
+
+		_mm256_store_si256(words + 0, s0);
+		_mm256_store_si256(words + 1, s1);
+		_mm256_store_si256(words + 2, s2);
+		_mm256_store_si256(words + 3, s3);
+	}
+}
+
+DX::RandomKernels::NextBlocksKernel DX::RandomKernels::GetAvx2NextBlocks()
+{
+	return NextBlocks;
+}
+#else
+DX::RandomKernels::NextBlocksKernel DX::RandomKernels::GetAvx2NextBlocks()
+{
+	return nullptr;
+}
+#endif
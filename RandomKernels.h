@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+	namespace RandomKernels
+	{
+		// Steps the eight interleaved xoshiro128** states blockCount times,
+		// writing eight outputs per step. lanes holds the four state words
+		// of every lane, word-major, and is 32-byte aligned. Gives the same
+		// bits as stepping each lane on its own. Built with AVX2 in
+		// RandomAvx2.cpp.
+		using NextBlocksKernel = void (*)(std::uint32_t* lanes, std::uint32_t* values, size_t blockCount);
+
+		// The portable loop Random uses without AVX2, in Random.cpp.
+		void NextBlocksScalar(std::uint32_t* lanes, std::uint32_t* values, size_t blockCount);
+
+		// nullptr when the file was built without AVX2. Only call it once
+		// GetCpuFeatures reports AVX2.
+		NextBlocksKernel GetAvx2NextBlocks();
+	}
+}
@@ -6,8 +6,17 @@ cbuffer cbUpdateSettings
 
     float gDisturbMag;
     int2 gDisturbIndex;
+
+    uint gDisturbCount;
+
+    // Stored units per height, 1 unless heights are kept as snorm. The
+    // update is linear, so only disturbances need to convert.
+    float gInvHeightScale;
+
+    float gGridSpatialStep;
 }
 
 RWTexture2D<float> gPrevSolInput : register(u0);
 RWTexture2D<float> gCurrSolInput : register(u1);
-RWTexture2D<float> gOutput       : register(u2);
\ No newline at end of file
+RWTexture2D<float> gOutput       : register(u2);
+RWTexture2D<float4> gNormalOutput : register(u3);
\ No newline at end of file
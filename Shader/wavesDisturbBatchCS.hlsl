@@ -0,0 +1,21 @@
+#include "waveSim.hlsli"
+
+struct CellDelta
+{
+    uint Row;
+    uint Col;
+    float Delta;
+};
+
+// Compacted on the CPU, so no two entries touch the same cell.
+StructuredBuffer<CellDelta> gCellDeltas : register(t0);
+
+[numthreads(64, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    if (DTid.x >= gDisturbCount)
+        return;
+
+    const CellDelta cell = gCellDeltas[DTid.x];
+    gOutput[int2(cell.Col, cell.Row)] += cell.Delta * gInvHeightScale;
+}
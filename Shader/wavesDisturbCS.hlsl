@@ -6,9 +6,10 @@ void main()
     int x = gDisturbIndex.x;
     int y = gDisturbIndex.y;
 
-    const float halfMag = 0.5f * gDisturbMag;
+    const float mag = gDisturbMag * gInvHeightScale;
+    const float halfMag = 0.5f * mag;
 
-    gOutput[int2(x, y)]     += gDisturbMag;
+    gOutput[int2(x, y)]     += mag;
     gOutput[int2(x + 1, y)] += halfMag;
     gOutput[int2(x - 1, y)] += halfMag;
     gOutput[int2(x, y + 1)] += halfMag;
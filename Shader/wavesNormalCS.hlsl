@@ -0,0 +1,26 @@
+#include "waveSim.hlsli"
+
+// The central differences wavesVS used to take per vertex and per frame,
+// now taken once per cell after the simulation stepped. Clamped reads
+// match the point-clamp sampling at the edges.
+[numthreads(16, 16, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    uint width, height;
+    gNormalOutput.GetDimensions(width, height);
+    if (DTid.x >= width || DTid.y >= height)
+        return;
+
+    const int x = DTid.x;
+    const int y = DTid.y;
+
+    const float lft = gCurrSolInput[int2(max(x - 1, 0), y)].r;
+    const float rht = gCurrSolInput[int2(min(x + 1, (int)width - 1), y)].r;
+    const float top = gCurrSolInput[int2(x, max(y - 1, 0))].r;
+    const float btm = gCurrSolInput[int2(x, min(y + 1, (int)height - 1))].r;
+
+    // Heights are in stored units; scaling the vertical term by the inverse
+    // of the height scale gives the same direction as scaling the differences.
+    const float3 normal = normalize(float3(lft - rht, 2.0f * gGridSpatialStep * gInvHeightScale, btm - top));
+    gNormalOutput[int2(x, y)] = float4(normal, 0.0f);
+}
\ No newline at end of file
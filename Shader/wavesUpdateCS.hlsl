@@ -6,6 +6,13 @@ void main(uint3 DTid : SV_DispatchThreadID)
     int x = DTid.x;
     int y = DTid.y;
 
+    // Edge groups of grids that are not a multiple of 16. Reads past the
+    // edge return 0, which keeps the boundary fixed at rest either way.
+    uint width, height;
+    gOutput.GetDimensions(width, height);
+    if (DTid.x >= width || DTid.y >= height)
+        return;
+
     gOutput[int2(x, y)] =
 		gWaveConstant0 * gPrevSolInput[int2(x, y)].r +
 		gWaveConstant1 * gCurrSolInput[int2(x, y)].r +
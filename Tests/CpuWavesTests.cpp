@@ -0,0 +1,355 @@
+#include "TestHarness.h"
+
+#include "CpuWaves.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	using DX::CpuWaves;
+	using uint32 = std::uint32_t;
+
+	constexpr float SPATIAL_STEP = 0.25f;
+	constexpr float TIME_STEP = 0.03f;
+	constexpr float SPEED = 2.0f;
+	constexpr float DAMPING = 0.2f;
+
+	// Straightforward solver over zero-bordered planes, written the way
+	// wavesUpdateCS.hlsl reads, to check CpuWaves against.
+	class ReferenceWaves
+	{
+	public:
+		ReferenceWaves(const uint32 m, const uint32 n) :
+			mRows(m), mCols(n), mPrev((m + 2) * (n + 2), 0.0f), mCurr(mPrev), mNext(mPrev)
+		{
+			const float d = DAMPING * TIME_STEP + 2.0f;
+			const float e = (SPEED * SPEED) * (TIME_STEP * TIME_STEP) / (SPATIAL_STEP * SPATIAL_STEP);
+			mK[0] = (DAMPING * TIME_STEP - 2.0f) / d;
+			mK[1] = (4.0f - 8.0f * e) / d;
+			mK[2] = (2.0f * e) / d;
+		}
+
+		void Step()
+		{
+			for (uint32 i = 0; i < mRows; ++i)
+			{
+				for (uint32 j = 0; j < mCols; ++j)
+				{
+					const float down = mCurr[Index(i + 1, j)];
+					const float up = mCurr[Index(i - 1, j)];
+					const float right = mCurr[Index(i, j + 1)];
+					const float left = mCurr[Index(i, j - 1)];
+					mNext[Index(i, j)] = mK[0] * mPrev[Index(i, j)] + mK[1] * mCurr[Index(i, j)] +
+						mK[2] * (down + up + right + left);
+				}
+			}
+			std::swap(mPrev, mCurr);
+			std::swap(mCurr, mNext);
+		}
+
+		void Disturb(const uint32 i, const uint32 j, const float magnitude)
+		{
+			const float halfMag = 0.5f * magnitude;
+			mCurr[Index(i, j)] += magnitude;
+			if (j + 1 < mCols) mCurr[Index(i, j + 1)] += halfMag;
+			if (j > 0)         mCurr[Index(i, j - 1)] += halfMag;
+			if (i + 1 < mRows) mCurr[Index(i + 1, j)] += halfMag;
+			if (i > 0)         mCurr[Index(i - 1, j)] += halfMag;
+		}
+
+		[[nodiscard]] float GetHeight(const uint32 i, const uint32 j) const { return mCurr[Index(i, j)]; }
+
+	private:
+		// i and j may be -1 (wrapped) or one past the end, which land on the border.
+		[[nodiscard]] size_t Index(const uint32 i, const uint32 j) const
+		{
+			return static_cast<size_t>(i + 1) * (mCols + 2) + (j + 1);
+		}
+
+		uint32 mRows;
+		uint32 mCols;
+		float mK[3]{};
+		std::vector<float> mPrev;
+		std::vector<float> mCurr;
+		std::vector<float> mNext;
+	};
+
+	// Small deterministic generator so the drops do not depend on the library under test.
+	struct DropSequence
+	{
+		std::uint32_t State = 12345u;
+
+		uint32 Next(const uint32 bound)
+		{
+			State = State * 1664525u + 1013904223u;
+			return (State >> 8) % bound;
+		}
+	};
+
+	void Drop(CpuWaves& waves, ReferenceWaves& reference, DropSequence& drops)
+	{
+		const uint32 i = drops.Next(waves.GetRowCount());
+		const uint32 j = drops.Next(waves.GetColumnCount());
+		const float magnitude = 0.25f + 0.01f * static_cast<float>(drops.Next(100));
+		waves.Disturb(i, j, magnitude);
+		reference.Disturb(i, j, magnitude);
+	}
+
+	bool MatchesBitForBit(const CpuWaves& waves, const ReferenceWaves& reference)
+	{
+		std::vector<float> row(waves.GetColumnCount());
+		for (uint32 i = 0; i < waves.GetRowCount(); ++i)
+		{
+			waves.GetSolutionRow(i, row.data());
+			for (uint32 j = 0; j < waves.GetColumnCount(); ++j)
+			{
+				if (!DX::Test::BitEqual(row[j], reference.GetHeight(i, j))) return false;
+			}
+		}
+		return true;
+	}
+
+	// Steps both solvers with a drop every few steps and compares after each one.
+	bool RunAgainstReference(CpuWaves& waves, const uint32 stepCount)
+	{
+		ReferenceWaves reference(waves.GetRowCount(), waves.GetColumnCount());
+		DropSequence drops;
+
+		for (uint32 step = 0; step < stepCount; ++step)
+		{
+			if (step % 4 == 0) Drop(waves, reference, drops);
+
+			waves.Step();
+			reference.Step();
+			if (!MatchesBitForBit(waves, reference)) return false;
+		}
+		return true;
+	}
+}
+
+DX_TEST(SimdStencilMatchesScalarReference)
+{
+	// Widths around the vector sizes exercise the vector loop and every tail length.
+	for (const uint32 cols : { 1u, 3u, 4u, 7u, 8u, 9u, 16u, 31u, 64u, 133u })
+	{
+		CpuWaves waves(37, cols, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING);
+		waves.SetKernel(CpuWaves::Kernel::Simd);
+		DX_CHECK(RunAgainstReference(waves, 60));
+	}
+}
+
+DX_TEST(ScalarStencilMatchesScalarReference)
+{
+	CpuWaves waves(37, 133, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING);
+	waves.SetKernel(CpuWaves::Kernel::Scalar);
+	DX_CHECK(RunAgainstReference(waves, 60));
+}
+
+DX_TEST(SimdPackedStencilsMatchScalar)
+{
+	for (const auto storage : { DX::WaveStorage::Float16, DX::WaveStorage::Int16 })
+	{
+		CpuWaves simd(41, 77, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING, storage);
+		CpuWaves scalar(41, 77, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING, storage);
+		simd.SetKernel(CpuWaves::Kernel::Simd);
+		scalar.SetKernel(CpuWaves::Kernel::Scalar);
+
+		DropSequence drops;
+		bool identical = true;
+		std::vector<float> simdRow(77), scalarRow(77);
+		for (uint32 step = 0; step < 80 && identical; ++step)
+		{
+			if (step % 4 == 0)
+			{
+				const uint32 i = drops.Next(41);
+				const uint32 j = drops.Next(77);
+				simd.Disturb(i, j, 0.5f);
+				scalar.Disturb(i, j, 0.5f);
+			}
+
+			simd.Step();
+			scalar.Step();
+			for (uint32 i = 0; i < 41 && identical; ++i)
+			{
+				simd.GetSolutionRow(i, simdRow.data());
+				scalar.GetSolutionRow(i, scalarRow.data());
+				identical = std::equal(simdRow.begin(), simdRow.end(), scalarRow.begin(), DX::Test::BitEqual);
+			}
+		}
+		DX_CHECK(identical);
+	}
+}
+
+DX_TEST(ActiveTilesTrackDenseSolver)
+{
+	// Drops stay in one corner, so most tiles should sleep. Clearing a
+	// sleeping tile drops heights below the threshold, which the waves
+	// then carry on; the error stays well under a percent of a drop.
+	constexpr uint32 ROWS = 300;
+	constexpr uint32 COLS = 260;
+	constexpr float THRESHOLD = 1e-4f;
+	constexpr float TOLERANCE = 4e-3f;
+
+	CpuWaves dense(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING);
+	CpuWaves active(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING);
+	active.SetActiveThreshold(THRESHOLD);
+
+	DropSequence drops;
+	float maxError = 0.0f;
+	uint32 fewestTiles = UINT32_MAX;
+	std::vector<float> denseRow(COLS), activeRow(COLS);
+	for (uint32 step = 0; step < 400; ++step)
+	{
+		if (step % 8 == 0 && step < 200)
+		{
+			const uint32 i = drops.Next(48);
+			const uint32 j = drops.Next(48);
+			dense.Disturb(i, j, 0.5f);
+			active.Disturb(i, j, 0.5f);
+		}
+
+		dense.Step();
+		active.Step();
+		fewestTiles = std::min(fewestTiles, active.GetActiveTileCount());
+
+		for (uint32 i = 0; i < ROWS; ++i)
+		{
+			dense.GetSolutionRow(i, denseRow.data());
+			active.GetSolutionRow(i, activeRow.data());
+			for (uint32 j = 0; j < COLS; ++j) maxError = std::max(maxError, std::abs(denseRow[j] - activeRow[j]));
+		}
+	}
+
+	DX_CHECK(maxError <= TOLERANCE);
+	// Of the 5 x 5 tiles, only the corner one and its border should remain.
+	DX_CHECK(fewestTiles <= 4u);
+}
+
+DX_TEST(OddGridSizesMatchScalarReference)
+{
+	// Sizes that are no multiple of the row alignment or the vector width,
+	// swept densely and with temporal blocking.
+	const uint32 sizes[][2] = { { 1000, 777 }, { 777, 1000 }, { 17, 33 }, { 3, 5 }, { 2, 129 }, { 1, 1 } };
+	for (const auto& size : sizes)
+	{
+		for (const uint32 stepsPerBatch : { 1u, 4u })
+		{
+			CpuWaves waves(static_cast<int>(size[0]), static_cast<int>(size[1]), SPATIAL_STEP, TIME_STEP, SPEED, DAMPING);
+			waves.SetStepsPerBatch(stepsPerBatch);
+
+			ReferenceWaves reference(size[0], size[1]);
+			DropSequence drops;
+			bool identical = true;
+			for (uint32 batch = 0; batch < 6 && identical; ++batch)
+			{
+				Drop(waves, reference, drops);
+				waves.Step(stepsPerBatch);
+				for (uint32 step = 0; step < stepsPerBatch; ++step) reference.Step();
+				identical = MatchesBitForBit(waves, reference);
+			}
+			DX_CHECK(identical);
+		}
+	}
+}
+
+DX_TEST(PooledStepsMatchSerial)
+{
+	// Tiles only write the rows they own, so running them on a pool must not
+	// change a bit, whatever order they finish in. The odd size leaves a
+	// short last tile.
+	constexpr uint32 ROWS = 700;
+	constexpr uint32 COLS = 333;
+
+	struct Config
+	{
+		DX::WaveStorage Storage;
+		uint32 StepsPerBatch;
+	};
+
+	DX::ThreadPool pool(4);
+	for (const Config& config : { Config{ DX::WaveStorage::Float32, 1 }, Config{ DX::WaveStorage::Float32, 4 },
+		Config{ DX::WaveStorage::Float16, 1 } })
+	{
+		CpuWaves serial(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING, config.Storage);
+		CpuWaves pooled(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING, config.Storage);
+		serial.SetStepsPerBatch(config.StepsPerBatch);
+		pooled.SetStepsPerBatch(config.StepsPerBatch);
+		pooled.SetThreadPool(&pool);
+
+		DropSequence drops;
+		bool identical = true;
+		std::vector<float> serialRow(COLS), pooledRow(COLS);
+		for (uint32 batch = 0; batch < 8 && identical; ++batch)
+		{
+			const uint32 i = drops.Next(ROWS);
+			const uint32 j = drops.Next(COLS);
+			serial.Disturb(i, j, 0.5f);
+			pooled.Disturb(i, j, 0.5f);
+
+			serial.Step(config.StepsPerBatch);
+			pooled.Step(config.StepsPerBatch);
+			for (uint32 row = 0; row < ROWS && identical; ++row)
+			{
+				serial.GetSolutionRow(row, serialRow.data());
+				pooled.GetSolutionRow(row, pooledRow.data());
+				identical = std::equal(serialRow.begin(), serialRow.end(), pooledRow.begin(), DX::Test::BitEqual);
+			}
+		}
+		DX_CHECK(identical);
+	}
+}
+
+DX_TEST(DisturbBatchMatchesDisturbLoop)
+{
+	// Overlapping drops and drops on every edge and corner.
+	constexpr uint32 ROWS = 23;
+	constexpr uint32 COLS = 19;
+
+	std::vector<DX::WaveDisturbance> drops;
+	DropSequence sequence;
+	for (uint32 k = 0; k < 200; ++k)
+	{
+		drops.push_back({ sequence.Next(ROWS), sequence.Next(COLS), 0.01f * static_cast<float>(1 + sequence.Next(100)) });
+	}
+	drops.push_back({ 0, 0, 1.0f });
+	drops.push_back({ ROWS - 1, COLS - 1, 1.0f });
+	drops.push_back({ 0, COLS - 1, 1.0f });
+	drops.push_back({ ROWS - 1, 0, 1.0f });
+
+	for (const auto storage : { DX::WaveStorage::Float32, DX::WaveStorage::Float16, DX::WaveStorage::Int16 })
+	{
+		CpuWaves batch(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING, storage);
+		CpuWaves loop(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING, storage);
+
+		batch.DisturbBatch(drops.data(), drops.size());
+		for (const auto& drop : drops) loop.Disturb(drop.Row, drop.Col, drop.Magnitude);
+
+		bool identical = true;
+		std::vector<float> batchRow(COLS), loopRow(COLS);
+		for (uint32 i = 0; i < ROWS && identical; ++i)
+		{
+			batch.GetSolutionRow(i, batchRow.data());
+			loop.GetSolutionRow(i, loopRow.data());
+			identical = std::equal(batchRow.begin(), batchRow.end(), loopRow.begin(), DX::Test::BitEqual);
+		}
+		DX_CHECK(identical);
+	}
+
+	// A drop centred just outside the grid only lands on the cell next to it.
+	CpuWaves waves(ROWS, COLS, SPATIAL_STEP, TIME_STEP, SPEED, DAMPING);
+	const DX::WaveDisturbance outside[] = { { ROWS, 3, 1.0f }, { 5, COLS, 1.0f } };
+	waves.DisturbBatch(outside, 2);
+
+	float total = 0.0f;
+	for (uint32 i = 0; i < ROWS; ++i)
+	{
+		for (uint32 j = 0; j < COLS; ++j) total += waves.GetHeight(i, j);
+	}
+	DX_CHECK(waves.GetHeight(ROWS - 1, 3) == 0.5f);
+	DX_CHECK(waves.GetHeight(5, COLS - 1) == 0.5f);
+	DX_CHECK(total == 1.0f);
+}
@@ -0,0 +1,85 @@
+#include "TestHarness.h"
+
+#include "FixedStepClock.h"
+
+#include <cstdint>
+
+namespace
+{
+	using DX::FixedStepClock;
+	using uint32 = std::uint32_t;
+
+	// Steps and frame times are multiples of 1/64 s so the accumulator is exact.
+	constexpr float TIME_STEP = 0.25f;
+}
+
+DX_TEST(FixedStepClockCarriesLeftoverTime)
+{
+	FixedStepClock clock(TIME_STEP);
+
+	DX_CHECK(clock.Advance(0.125f) == 0);
+	DX_CHECK(clock.GetAlpha() == 0.5f);
+	DX_CHECK(clock.Advance(0.125f) == 1);
+	DX_CHECK(clock.GetAlpha() == 0.0f);
+	DX_CHECK(clock.Advance(0.625f) == 2);
+	DX_CHECK(clock.GetAlpha() == 0.5f);
+
+	// Frames shorter than a step still add up to wall time.
+	FixedStepClock frames(TIME_STEP);
+	uint32 steps = 0;
+	uint32 sixtyFourths = 0;
+	for (uint32 frame = 0; frame < 1000; ++frame)
+	{
+		const uint32 frameTime = 1 + frame % 7;
+		sixtyFourths += frameTime;
+		steps += frames.Advance(static_cast<float>(frameTime) / 64.0f);
+	}
+	DX_CHECK(steps == sixtyFourths / 16);
+	DX_CHECK(frames.GetAlpha() == static_cast<float>(sixtyFourths % 16) / 16.0f);
+	DX_CHECK(frames.GetDroppedSteps() == 0);
+}
+
+DX_TEST(FixedStepClockCapsCatchUp)
+{
+	FixedStepClock clock(TIME_STEP, 4);
+
+	// A 2 s hitch is 8 steps, of which 4 run and 4 are dropped with no time left over.
+	DX_CHECK(clock.Advance(2.0f) == 4);
+	DX_CHECK(clock.GetDroppedSteps() == 4);
+	DX_CHECK(clock.GetAlpha() == 0.0f);
+
+	DX_CHECK(clock.Advance(0.25f) == 1);
+	DX_CHECK(clock.GetDroppedSteps() == 4);
+
+	clock.SetMaxSubsteps(2);
+	DX_CHECK(clock.Advance(1.125f) == 2);
+	DX_CHECK(clock.GetDroppedSteps() == 6);
+	DX_CHECK(clock.GetAlpha() == 0.5f);
+
+	// 0 would stall the simulation, so it means 1.
+	clock.SetMaxSubsteps(0);
+	DX_CHECK(clock.GetMaxSubsteps() == 1);
+
+	clock.Reset();
+	DX_CHECK(clock.GetDroppedSteps() == 0);
+	DX_CHECK(clock.GetAlpha() == 0.0f);
+}
+
+DX_TEST(FixedStepClockAlphaStaysInRange)
+{
+	FixedStepClock clock(1.0f / 60.0f);
+
+	// Uneven frame times around 60 Hz, plus the negative deltas a timer can report.
+	bool inRange = true;
+	for (int frame = 0; frame < 10000; ++frame)
+	{
+		const float deltaTime = frame % 97 == 0 ? -0.001f : 0.01f + 0.0001f * static_cast<float>(frame % 113);
+		const float before = clock.GetAlpha();
+		const uint32 steps = clock.Advance(deltaTime);
+		const float alpha = clock.GetAlpha();
+
+		inRange = inRange && alpha >= 0.0f && alpha < 1.0f;
+		if (deltaTime <= 0.0f) inRange = inRange && steps == 0 && alpha == before;
+	}
+	DX_CHECK(inRange);
+}
@@ -0,0 +1,68 @@
+#include "TestHarness.h"
+
+#include "FrameTimeHistory.h"
+
+#include <cstdint>
+
+namespace
+{
+	using DX::FrameTimeHistory;
+	using uint32 = std::uint32_t;
+
+	constexpr uint32 CAPACITY = FrameTimeHistory::CAPACITY;
+}
+
+DX_TEST(FrameTimeHistoryReportsNearestRankPercentiles)
+{
+	FrameTimeHistory history;
+	DX_CHECK(history.GetStats().Count == 0);
+	DX_CHECK(history.GetPercentile(0.5f) == 0.0f);
+
+	// 1 to 100 out of order, so the nth rank is n and every value is exact.
+	for (uint32 k = 0; k < 100; ++k) history.Push(static_cast<float>(k * 7 % 100 + 1));
+
+	const FrameTimeHistory::Stats stats = history.GetStats();
+	DX_CHECK(stats.Count == 100);
+	DX_CHECK(stats.Average == 50.5f);
+	DX_CHECK(stats.P50 == 50.0f);
+	DX_CHECK(stats.P95 == 95.0f);
+	DX_CHECK(stats.P99 == 99.0f);
+	DX_CHECK(stats.Max == 100.0f);
+
+	DX_CHECK(history.GetPercentile(0.50f) == stats.P50);
+	DX_CHECK(history.GetPercentile(0.95f) == stats.P95);
+	DX_CHECK(history.GetPercentile(0.99f) == stats.P99);
+	DX_CHECK(history.GetPercentile(0.0f) == 1.0f);
+	DX_CHECK(history.GetPercentile(1.0f) == 100.0f);
+	DX_CHECK(history.GetMax() == 100.0f);
+}
+
+DX_TEST(FrameTimeHistoryKeepsTheLatestCapacitySamples)
+{
+	FrameTimeHistory history;
+
+	// Long frames that the ring must overwrite, then 1 to CAPACITY out of order.
+	for (uint32 k = 0; k < 500; ++k) history.Push(10000.0f);
+	for (uint32 k = 0; k < CAPACITY; ++k) history.Push(static_cast<float>(k * 397 % CAPACITY + 1));
+
+	DX_CHECK(history.GetTotalCount() == 500 + CAPACITY);
+	const FrameTimeHistory::Stats stats = history.GetStats();
+	DX_CHECK(stats.Count == CAPACITY);
+	DX_CHECK(stats.Average == 512.5f);
+	DX_CHECK(stats.P50 == 512.0f);
+	DX_CHECK(stats.P95 == 973.0f);
+	DX_CHECK(stats.P99 == 1014.0f);
+	DX_CHECK(stats.Max == static_cast<float>(CAPACITY));
+	DX_CHECK(history.GetPercentile(0.99f) == stats.P99);
+	DX_CHECK(history.GetMax() == stats.Max);
+
+	// A partial lap drops only the oldest samples.
+	FrameTimeHistory ramp;
+	for (uint32 k = 1; k <= CAPACITY + 3; ++k) ramp.Push(static_cast<float>(k));
+	DX_CHECK(ramp.GetPercentile(0.0f) == 4.0f);
+	DX_CHECK(ramp.GetMax() == static_cast<float>(CAPACITY + 3));
+
+	ramp.Clear();
+	DX_CHECK(ramp.GetTotalCount() == 0);
+	DX_CHECK(ramp.GetStats().Count == 0);
+}
@@ -0,0 +1,153 @@
+#include "TestHarness.h"
+
+#include "GeometryGenerator.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	using DX::GeometryGenerator;
+	using uint32 = std::uint32_t;
+	using Triangle = std::array<uint32, 3>;
+
+	// Rotates the smallest index to the front, which keeps the winding, so
+	// triangle lists can be compared as sorted sets.
+	Triangle Canonical(const uint32 a, const uint32 b, const uint32 c)
+	{
+		if (a <= b && a <= c) return { a, b, c };
+		if (b <= a && b <= c) return { b, c, a };
+		return { c, a, b };
+	}
+
+	struct GridCase
+	{
+		uint32 M;
+		uint32 N;
+		uint32 TileQuads;
+	};
+
+	const GridCase GRID_CASES[] = {
+		{ 50, 70, 16 }, { 257, 129, 64 }, { 33, 33, 32 }, { 33, 33, 8 }, { 5, 9, 3 }, { 2, 2, 1 }, { 2, 40, 7 },
+	};
+
+	constexpr float WIDTH = 160.0f;
+	constexpr float DEPTH = 120.0f;
+	constexpr float SKIRT_DEPTH = 0.5f;
+}
+
+// The tiles of CreateGridTiles, stitched back together by their grid
+// coordinates, must repeat CreateGrid's vertices byte for byte and its
+// triangles with the same winding, whatever the tile size or thread count.
+DX_TEST(StitchedGridTilesMatchCreateGrid)
+{
+	GeometryGenerator geoGen;
+	DX::ThreadPool threadPool(4);
+
+	for (const GridCase& c : GRID_CASES)
+	{
+		const GeometryGenerator::MeshData grid = geoGen.CreateGrid(WIDTH, DEPTH, c.M, c.N);
+
+		std::vector<Triangle> expected;
+		for (size_t k = 0; k < grid.Indices32.size(); k += 3)
+		{
+			expected.push_back(Canonical(grid.Indices32[k], grid.Indices32[k + 1], grid.Indices32[k + 2]));
+		}
+		std::sort(expected.begin(), expected.end());
+
+		for (DX::ThreadPool* pool : { static_cast<DX::ThreadPool*>(nullptr), &threadPool })
+		{
+			for (const float skirtDepth : { 0.0f, SKIRT_DEPTH })
+			{
+				std::mutex mutex;
+				std::vector<Triangle> stitched;
+				std::vector<uint32> covered(grid.Vertices.size(), 0);
+				bool verticesMatch = true;
+				bool skirtsMatch = true;
+
+				geoGen.CreateGridTiles(WIDTH, DEPTH, c.M, c.N, c.TileQuads, skirtDepth,
+					[&](const GeometryGenerator::GridTile& tile)
+				{
+					const std::lock_guard<std::mutex> lock(mutex);
+					const auto global = [&tile, &c](const uint32 local)
+					{
+						return (tile.FirstRow + local / tile.ColCount) * c.N + tile.FirstCol + local % tile.ColCount;
+					};
+
+					const uint32 gridVertexCount = tile.RowCount * tile.ColCount;
+					for (uint32 v = 0; v < gridVertexCount; ++v)
+					{
+						verticesMatch &= std::memcmp(&tile.Vertices[v], &grid.Vertices[global(v)],
+							sizeof(GeometryGenerator::Vertex)) == 0;
+						++covered[global(v)];
+					}
+
+					for (uint32 k = 0; k < tile.GridIndexCount; k += 3)
+					{
+						stitched.push_back(Canonical(global(tile.Indices[k]), global(tile.Indices[k + 1]),
+							global(tile.Indices[k + 2])));
+					}
+
+					// Skirts hang straight down, one vertex under each edge vertex.
+					const uint32 perimeter = 2 * (tile.RowCount + tile.ColCount);
+					skirtsMatch &= skirtDepth > 0.0f ?
+						tile.VertexCount == gridVertexCount + perimeter :
+						tile.VertexCount == gridVertexCount && tile.IndexCount == tile.GridIndexCount;
+					for (uint32 v = gridVertexCount; v < tile.VertexCount; ++v)
+					{
+						skirtsMatch &= tile.Vertices[v].Position.y == -skirtDepth;
+					}
+				}, pool);
+
+				std::sort(stitched.begin(), stitched.end());
+				DX_CHECK(verticesMatch);
+				DX_CHECK(skirtsMatch);
+				DX_CHECK(stitched == expected);
+				DX_CHECK(std::all_of(covered.begin(), covered.end(), [](const uint32 count) { return count > 0; }));
+			}
+		}
+	}
+}
+
+// Every skirt triangle must face away from the tile it hangs off.
+DX_TEST(GridTileSkirtsFaceOutwards)
+{
+	GeometryGenerator geoGen;
+
+	for (const GridCase& c : GRID_CASES)
+	{
+		bool outwards = true;
+		geoGen.CreateGridTiles(WIDTH, DEPTH, c.M, c.N, c.TileQuads, SKIRT_DEPTH,
+			[&outwards](const GeometryGenerator::GridTile& tile)
+		{
+			const auto& first = tile.Vertices[0].Position;
+			const auto& last = tile.Vertices[tile.RowCount * tile.ColCount - 1].Position;
+			const float centerX = 0.5f * (first.x + last.x);
+			const float centerZ = 0.5f * (first.z + last.z);
+
+			for (uint32 k = tile.GridIndexCount; k < tile.IndexCount; k += 3)
+			{
+				const auto& p0 = tile.Vertices[tile.Indices[k]].Position;
+				const auto& p1 = tile.Vertices[tile.Indices[k + 1]].Position;
+				const auto& p2 = tile.Vertices[tile.Indices[k + 2]].Position;
+
+				// Only x and z of the face normal matter, the skirt is vertical.
+				const float ax = p1.x - p0.x, ay = p1.y - p0.y, az = p1.z - p0.z;
+				const float bx = p2.x - p0.x, by = p2.y - p0.y, bz = p2.z - p0.z;
+				const float normalX = ay * bz - az * by;
+				const float normalZ = ax * by - ay * bx;
+
+				const float outX = (p0.x + p1.x + p2.x) / 3.0f - centerX;
+				const float outZ = (p0.z + p1.z + p2.z) / 3.0f - centerZ;
+				outwards &= normalX * outX + normalZ * outZ > 0.0f;
+			}
+		});
+
+		DX_CHECK(outwards);
+	}
+}
@@ -0,0 +1,126 @@
+#include "TestHarness.h"
+
+#include "MathHelper.h"
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	using namespace DirectX;
+	using DX::MathHelper;
+	using DX::TransformClass;
+
+	struct ClassifiedTransform
+	{
+		XMFLOAT4X4 Matrix;
+		TransformClass Class;
+	};
+
+	XMMATRIX RandomRotation(DX::Random& random)
+	{
+		return XMMatrixRotationX(random.NextFloat(-XM_PI, XM_PI)) *
+			XMMatrixRotationY(random.NextFloat(-XM_PI, XM_PI)) *
+			XMMatrixRotationZ(random.NextFloat(-XM_PI, XM_PI));
+	}
+
+	// Transforms of every class, built the way scenes build them: scales,
+	// rotations and a translation composed in floats.
+	std::vector<ClassifiedTransform> MakeTransforms(const size_t countPerClass)
+	{
+		DX::Random random(7);
+		std::vector<ClassifiedTransform> transforms;
+
+		for (size_t i = 0; i < countPerClass; ++i)
+		{
+			const XMMATRIX translation = XMMatrixTranslation(
+				random.NextFloat(-100.0f, 100.0f), random.NextFloat(-100.0f, 100.0f), random.NextFloat(-100.0f, 100.0f));
+			const float scale = random.NextFloat(0.1f, 10.0f);
+
+			XMMATRIX rigid = RandomRotation(random) * translation;
+			XMMATRIX uniform = XMMatrixScaling(scale, scale, scale) * RandomRotation(random) * translation;
+			XMMATRIX affine = XMMatrixScaling(scale, random.NextFloat(0.1f, 10.0f) + 0.5f * scale, 1.0f) *
+				RandomRotation(random) * translation;
+
+			XMMATRIX general = uniform;
+			general.r[0] = XMVectorSet(XMVectorGetX(general.r[0]), XMVectorGetY(general.r[0]), XMVectorGetZ(general.r[0]),
+				random.NextFloat(0.01f, 0.1f));
+
+			ClassifiedTransform transform;
+			XMStoreFloat4x4(&transform.Matrix, rigid);
+			transform.Class = TransformClass::Rigid;
+			transforms.push_back(transform);
+
+			XMStoreFloat4x4(&transform.Matrix, uniform);
+			transform.Class = TransformClass::UniformScale;
+			transforms.push_back(transform);
+
+			XMStoreFloat4x4(&transform.Matrix, affine);
+			transform.Class = TransformClass::Affine;
+			transforms.push_back(transform);
+
+			XMStoreFloat4x4(&transform.Matrix, general);
+			transform.Class = TransformClass::General;
+			transforms.push_back(transform);
+		}
+		return transforms;
+	}
+
+	// Largest element difference relative to the largest element of expected.
+	float RelativeDifference(const XMFLOAT4X4& actual, const XMFLOAT4X4& expected)
+	{
+		float difference = 0.0f;
+		float magnitude = 0.0f;
+		for (int r = 0; r < 4; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				difference = std::max(difference, std::fabs(actual.m[r][c] - expected.m[r][c]));
+				magnitude = std::max(magnitude, std::fabs(expected.m[r][c]));
+			}
+		}
+		return difference / magnitude;
+	}
+
+	constexpr size_t TRANSFORMS_PER_CLASS = 2500;
+
+	// The closed forms are exact up to rounding for exactly classified
+	// transforms; floats composed from rotations are orthogonal to ~1e-7.
+	constexpr float TOLERANCE = 1e-5f;
+}
+
+DX_TEST(TransformsClassifyAsBuilt)
+{
+	size_t misclassified = 0;
+	for (const ClassifiedTransform& transform : MakeTransforms(TRANSFORMS_PER_CLASS))
+	{
+		if (MathHelper::ClassifyTransform(XMLoadFloat4x4(&transform.Matrix)) != transform.Class) ++misclassified;
+	}
+	DX_CHECK(misclassified == 0);
+}
+
+// The classified inverse-transpose of every class must match the general
+// path, which inverts the full matrix.
+DX_TEST(ClassifiedInverseTransposeMatchesGeneralPath)
+{
+	float worst[4]{};
+	for (const ClassifiedTransform& transform : MakeTransforms(TRANSFORMS_PER_CLASS))
+	{
+		const XMMATRIX m = XMLoadFloat4x4(&transform.Matrix);
+		XMFLOAT4X4 classified, general;
+		XMStoreFloat4x4(&classified, MathHelper::InverseTranspose(m, MathHelper::ClassifyTransform(m)));
+		XMStoreFloat4x4(&general, MathHelper::InverseTranspose(m));
+
+		float& classWorst = worst[static_cast<int>(transform.Class)];
+		classWorst = std::max(classWorst, RelativeDifference(classified, general));
+	}
+
+	DX_CHECK(worst[static_cast<int>(TransformClass::Rigid)] <= TOLERANCE);
+	DX_CHECK(worst[static_cast<int>(TransformClass::UniformScale)] <= TOLERANCE);
+	DX_CHECK(worst[static_cast<int>(TransformClass::Affine)] <= TOLERANCE);
+	DX_CHECK(worst[static_cast<int>(TransformClass::General)] == 0.0f);
+}
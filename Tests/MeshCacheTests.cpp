@@ -0,0 +1,123 @@
+#include "TestHarness.h"
+
+#include "MeshCache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	using DX::MeshCache;
+	using DX::MeshCacheData;
+	using DX::MeshCacheHeader;
+	using DX::MeshCacheKey;
+	using DX::MeshPart;
+
+	struct SampleMesh
+	{
+		std::vector<float> Vertices = std::vector<float>(4 * 3, 1.0f);
+		std::vector<std::uint16_t> Indices = { 0, 1, 2, 2, 1, 3 };
+		std::vector<MeshPart> Parts = { { 3, 0, 0 }, { 3, 3, 1 } };
+
+		[[nodiscard]] MeshCacheData GetData() const
+		{
+			MeshCacheData data;
+			data.VertexData = Vertices.data();
+			data.VertexStride = 3 * sizeof(float);
+			data.VertexCount = 4;
+			data.IndexData = Indices.data();
+			data.IndexStride = sizeof(std::uint16_t);
+			data.IndexCount = static_cast<std::uint32_t>(Indices.size());
+			data.Parts = Parts.data();
+			data.PartCount = static_cast<std::uint32_t>(Parts.size());
+			return data;
+		}
+	};
+
+	std::filesystem::path GetCacheDirectory()
+	{
+		return std::filesystem::temp_directory_path() / "D3DAppTests.MeshCache";
+	}
+
+	template <class T>
+	void Overwrite(const std::filesystem::path& path, const std::uint64_t offset, const T& value)
+	{
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(static_cast<std::streamoff>(offset));
+		file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	MeshCacheHeader ReadHeader(const std::filesystem::path& path)
+	{
+		MeshCacheHeader header;
+		std::ifstream file(path, std::ios::binary);
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		return header;
+	}
+}
+
+DX_TEST(MeshCacheRoundTrips)
+{
+	const MeshCache cache(GetCacheDirectory());
+	const MeshCacheKey key = MeshCacheKey("MeshCacheRoundTrips").Add(1);
+	const SampleMesh mesh;
+
+	DX_CHECK(cache.Store(key, mesh.GetData()));
+
+	const auto entry = cache.Find(key);
+	DX_CHECK(entry != nullptr);
+	if (entry == nullptr) return;
+
+	const MeshCacheData& data = entry->GetData();
+	DX_CHECK(data.VertexCount == 4 && data.IndexCount == 6 && data.PartCount == 2);
+	DX_CHECK(std::memcmp(data.VertexData, mesh.Vertices.data(), data.GetVertexBufferByteSize()) == 0);
+	DX_CHECK(std::memcmp(data.IndexData, mesh.Indices.data(), data.GetIndexBufferByteSize()) == 0);
+	DX_CHECK(data.Parts[1].BaseVertexLocation == 1);
+}
+
+// Each kind of damage turns the entry into a miss instead of handing out
+// buffers the GPU would read out of bounds.
+DX_TEST(MeshCacheRejectsDamagedEntries)
+{
+	const MeshCache cache(GetCacheDirectory());
+	const MeshCacheKey key = MeshCacheKey("MeshCacheRejectsDamagedEntries").Add(1);
+	const std::filesystem::path path = GetCacheDirectory() / key.GetFileName();
+	const SampleMesh mesh;
+
+	// A flipped vertex byte fails the checksum.
+	DX_CHECK(cache.Store(key, mesh.GetData()));
+	DX_CHECK(cache.Find(key) != nullptr);
+	Overwrite(path, ReadHeader(path).VertexOffset, std::uint8_t{ 0x55 });
+	DX_CHECK(cache.Find(key) == nullptr);
+
+	// The header is not checksummed, an index stride other than 2 or 4 is caught on its own.
+	DX_CHECK(cache.Store(key, mesh.GetData()));
+	Overwrite(path, offsetof(MeshCacheHeader, IndexStride), std::uint32_t{ 3 });
+	DX_CHECK(cache.Find(key) == nullptr);
+}
+
+// Parts are checked against the buffers even when the checksum matches,
+// since a bad entry may have been written that way.
+DX_TEST(MeshCacheRejectsPartsOutsideTheBuffers)
+{
+	const MeshCache cache(GetCacheDirectory());
+	const MeshCacheKey key = MeshCacheKey("MeshCacheRejectsPartsOutsideTheBuffers").Add(1);
+
+	const auto isRejected = [&cache, &key](const MeshPart& part)
+	{
+		SampleMesh mesh;
+		mesh.Parts[1] = part;
+		DX_CHECK(cache.Store(key, mesh.GetData()));
+		return cache.Find(key) == nullptr;
+	};
+
+	DX_CHECK(!isRejected({ 3, 3, 3 }));
+	DX_CHECK(isRejected({ 3, 4, 0 }));
+	DX_CHECK(isRejected({ 7, 0, 0 }));
+	DX_CHECK(isRejected({ 3, 3, 4 }));
+	DX_CHECK(isRejected({ 3, 3, -1 }));
+}
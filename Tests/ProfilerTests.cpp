@@ -0,0 +1,67 @@
+#include "TestHarness.h"
+
+#include "Profiler.h"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if DX_PROFILER
+
+namespace
+{
+	using DX::Profiler;
+
+	const Profiler::ZoneStats* FindZone(const std::vector<Profiler::ZoneStats>& summary, const std::string& name)
+	{
+		for (const auto& zone : summary)
+		{
+			if (zone.Name == name) return &zone;
+		}
+		return nullptr;
+	}
+}
+
+// Self time leaves out the zones nested inside, on the same thread only.
+DX_TEST(ProfilerSummaryNestsZones)
+{
+	Profiler::Clear();
+	{
+		DX_PROFILE_ZONE("ProfilerTests outer");
+		for (int i = 0; i < 3; ++i)
+		{
+			DX_PROFILE_ZONE("ProfilerTests inner");
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+	}
+
+	const auto summary = Profiler::GetSummary();
+	const Profiler::ZoneStats* outer = FindZone(summary, "ProfilerTests outer");
+	const Profiler::ZoneStats* inner = FindZone(summary, "ProfilerTests inner");
+	DX_CHECK(outer != nullptr && inner != nullptr);
+	if (outer == nullptr || inner == nullptr) return;
+
+	DX_CHECK(outer->Count == 1 && inner->Count == 3);
+	DX_CHECK(inner->TotalMs >= 5.0);
+	DX_CHECK(outer->TotalMs >= inner->TotalMs);
+	DX_CHECK(outer->SelfMs < inner->TotalMs);
+	DX_CHECK(inner->SelfMs == inner->TotalMs);
+}
+
+// A thread's first zone begins after the trace origin, so no event has a negative ts.
+DX_TEST(ChromeTraceStartsAtTheOrigin)
+{
+	std::thread([] { DX_PROFILE_ZONE("ProfilerTests first zone of a thread"); }).join();
+
+	std::ostringstream trace;
+	Profiler::WriteChromeTrace(trace);
+	const std::string json = trace.str();
+
+	DX_CHECK(json.find("ProfilerTests first zone of a thread") != std::string::npos);
+	DX_CHECK(json.find("\"ts\":-") == std::string::npos);
+	Profiler::Clear();
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace DX
+{
+	namespace Test
+	{
+		struct TestCase
+		{
+			const char* Name;
+			void (*Body)();
+		};
+
+		std::vector<TestCase>& GetTests();
+		void ReportFailure(const char* file, int line, const char* expression);
+
+		struct Registrar
+		{
+			Registrar(const char* name, void (*body)()) { GetTests().push_back({ name, body }); }
+		};
+
+		// Compares the bit patterns, so -0 differs from 0 and NaNs compare equal to themselves.
+		inline bool BitEqual(const float a, const float b)
+		{
+			std::uint32_t x, y;
+			std::memcpy(&x, &a, sizeof(x));
+			std::memcpy(&y, &b, sizeof(y));
+			return x == y;
+		}
+	}
+}
+
+// Defines and registers a test; it fails if any DX_CHECK in it fails.
+#define DX_TEST(name) \
+	static void name(); \
+	static const ::DX::Test::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define DX_CHECK(expression) \
+	((expression) ? (void)0 : ::DX::Test::ReportFailure(__FILE__, __LINE__, #expression))
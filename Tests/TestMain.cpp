@@ -0,0 +1,44 @@
+#include "TestHarness.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	int gFailures = 0;
+}
+
+std::vector<DX::Test::TestCase>& DX::Test::GetTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void DX::Test::ReportFailure(const char* file, const int line, const char* expression)
+{
+	std::printf("  %s(%d): check failed: %s\n", file, line, expression);
+	++gFailures;
+}
+
+// Runs every test, or only those whose name contains the first argument.
+int main(const int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int run = 0;
+	int failed = 0;
+	for (const auto& test : DX::Test::GetTests())
+	{
+		if (filter != nullptr && std::strstr(test.Name, filter) == nullptr) continue;
+
+		std::printf("%s\n", test.Name);
+		const int failuresBefore = gFailures;
+		test.Body();
+
+		++run;
+		if (gFailures != failuresBefore) ++failed;
+	}
+
+	std::printf("%d of %d tests passed\n", run - failed, run);
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "TestHarness.h"
+
+#include "CpuWaves.h"
+#include "WaveQuery.h"
+#include "WaveSurface.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	using DX::CpuWaves;
+	using DX::WaveQueryBatch;
+	using DX::WaveSurface;
+	using DX::WaveSurfaceView;
+	using uint32 = std::uint32_t;
+
+	constexpr uint32 ROWS = 100;
+	constexpr uint32 COLS = 130;
+	constexpr float SPATIAL_STEP = 0.25f;
+
+	std::unique_ptr<CpuWaves> MakeRipples()
+	{
+		auto waves = std::make_unique<CpuWaves>(ROWS, COLS, SPATIAL_STEP, 0.03f, 2.0f, 0.2f);
+		for (uint32 step = 0; step < 40; ++step)
+		{
+			if (step % 4 == 0) waves->Disturb(5 + step * 7 % (ROWS - 10), 5 + step * 11 % (COLS - 10), 1.0f);
+			waves->Step();
+		}
+		return waves;
+	}
+
+	// A batch with every output, over buffers it owns.
+	struct Queries
+	{
+		explicit Queries(const size_t count) :
+			X(count), Z(count), Heights(count), Velocities(count), NormalX(count), NormalY(count), NormalZ(count)
+		{
+		}
+
+		WaveQueryBatch Batch(const size_t first, const size_t count)
+		{
+			WaveQueryBatch batch;
+			batch.X = &X[first];
+			batch.Z = &Z[first];
+			batch.Count = count;
+			batch.Heights = &Heights[first];
+			batch.Velocities = &Velocities[first];
+			batch.NormalX = &NormalX[first];
+			batch.NormalY = &NormalY[first];
+			batch.NormalZ = &NormalZ[first];
+			return batch;
+		}
+
+		std::vector<float> X, Z, Heights, Velocities, NormalX, NormalY, NormalZ;
+	};
+
+	bool SameOutputs(const Queries& a, const Queries& b)
+	{
+		bool same = true;
+		for (size_t q = 0; q < a.X.size(); ++q)
+		{
+			same = same && DX::Test::BitEqual(a.Heights[q], b.Heights[q]) &&
+				DX::Test::BitEqual(a.Velocities[q], b.Velocities[q]) &&
+				DX::Test::BitEqual(a.NormalX[q], b.NormalX[q]) &&
+				DX::Test::BitEqual(a.NormalY[q], b.NormalY[q]) &&
+				DX::Test::BitEqual(a.NormalZ[q], b.NormalZ[q]);
+		}
+		return same;
+	}
+}
+
+DX_TEST(WaveQueryBatchesMatchSingleQueries)
+{
+	const auto waves = MakeRipples();
+	WaveSurface surface(*waves);
+	surface.Update(*waves);
+	const WaveSurfaceView view = surface.Acquire();
+
+	// Odd-sized, so the SIMD loops leave a tail, and partly off the grid.
+	constexpr size_t COUNT = 1003;
+	Queries batched(COUNT);
+	std::uint32_t state = 12345u;
+	for (size_t q = 0; q < COUNT; ++q)
+	{
+		state = state * 1664525u + 1013904223u;
+		batched.X[q] = (static_cast<float>(state >> 8) / 16777216.0f - 0.5f) * 1.1f * COLS * SPATIAL_STEP;
+		state = state * 1664525u + 1013904223u;
+		batched.Z[q] = (static_cast<float>(state >> 8) / 16777216.0f - 0.5f) * 1.1f * ROWS * SPATIAL_STEP;
+	}
+	Queries single = batched;
+
+	DX::SampleWaveSurface(view, batched.Batch(0, COUNT));
+	for (size_t q = 0; q < COUNT; ++q)
+	{
+		DX::SampleWaveSurface(view, single.Batch(q, 1));
+	}
+	DX_CHECK(SameOutputs(batched, single));
+
+	// Heights alone take their own plane and must agree with the full pass.
+	std::vector<float> heights(COUNT);
+	WaveQueryBatch heightsOnly;
+	heightsOnly.X = batched.X.data();
+	heightsOnly.Z = batched.Z.data();
+	heightsOnly.Count = COUNT;
+	heightsOnly.Heights = heights.data();
+	DX::SampleWaveSurface(view, heightsOnly);
+
+	bool sameHeights = true;
+	for (size_t q = 0; q < COUNT; ++q)
+	{
+		sameHeights = sameHeights && DX::Test::BitEqual(heights[q], batched.Heights[q]);
+	}
+	DX_CHECK(sameHeights);
+}
+
+DX_TEST(WaveQueriesAreExactAtGridPoints)
+{
+	const auto waves = MakeRipples();
+	WaveSurface surface(*waves);
+	surface.Update(*waves);
+
+	Queries queries(static_cast<size_t>(ROWS) * COLS);
+	for (uint32 i = 0; i < ROWS; ++i)
+	{
+		for (uint32 j = 0; j < COLS; ++j)
+		{
+			queries.X[i * COLS + j] = (static_cast<float>(j) - 0.5f * (COLS - 1)) * SPATIAL_STEP;
+			queries.Z[i * COLS + j] = (0.5f * (ROWS - 1) - static_cast<float>(i)) * SPATIAL_STEP;
+		}
+	}
+	const std::uint64_t epoch = DX::QueryWaveSurface(surface, queries.Batch(0, queries.X.size()));
+	DX_CHECK(epoch == waves->GetStepCount());
+
+	// The last row and column interpolate from the cells before them with
+	// weight 1, which is within rounding of the cell but not exact.
+	const WaveSurfaceView view = surface.Acquire();
+	const float invTimeStep = 1.0f / waves->GetTimeStep();
+	std::vector<float> curr(COLS), prev(COLS);
+	bool exact = true;
+	for (uint32 i = 0; i + 1 < ROWS; ++i)
+	{
+		waves->GetSolutionRow(i, curr.data());
+		waves->GetPrevSolutionRow(i, prev.data());
+		for (uint32 j = 0; j + 1 < COLS; ++j)
+		{
+			const size_t q = i * COLS + j;
+			const size_t cell = i * view.RowPitch + j;
+			exact = exact && DX::Test::BitEqual(queries.Heights[q], curr[j]) &&
+				DX::Test::BitEqual(queries.Velocities[q], (curr[j] - prev[j]) * invTimeStep) &&
+				DX::Test::BitEqual(queries.NormalX[q], view.NormalX[cell]) &&
+				DX::Test::BitEqual(queries.NormalY[q], view.NormalY[cell]) &&
+				DX::Test::BitEqual(queries.NormalZ[q], view.NormalZ[cell]);
+		}
+	}
+	DX_CHECK(exact);
+}
@@ -0,0 +1,215 @@
+#include "TestHarness.h"
+
+#include "CpuWaves.h"
+#include "WaveRecorder.h"
+#include "WaveSnapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	using DX::CpuWaves;
+	using DX::WaveSnapshot;
+	using DX::WaveStorage;
+	using uint32 = std::uint32_t;
+
+	constexpr uint32 ROWS = 37;
+	constexpr uint32 COLS = 53;
+
+	// Offsets into an encoded record, see the layout in WaveSnapshot.h.
+	constexpr size_t ROWS_OFFSET = 4;
+	constexpr size_t STORAGE_OFFSET = 12;
+	constexpr size_t PLANE_SIZES_OFFSET = 48;
+
+	constexpr WaveStorage STORAGES[] = { WaveStorage::Float32, WaveStorage::Float16, WaveStorage::Int16 };
+
+	CpuWaves MakeWaves(const WaveStorage storage)
+	{
+		return CpuWaves(ROWS, COLS, 0.25f, 0.03f, 2.0f, 0.2f, storage);
+	}
+
+	// Drops and steps, so both planes hold distinct, non-trivial heights.
+	void Run(CpuWaves& waves, const uint32 stepCount, std::uint32_t seed)
+	{
+		for (uint32 step = 0; step < stepCount; ++step)
+		{
+			if (step % 5 == 0)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				waves.Disturb((seed >> 8) % ROWS, (seed >> 16) % COLS, 0.5f);
+			}
+			waves.Step();
+		}
+	}
+
+	WaveSnapshot Capture(const CpuWaves& waves)
+	{
+		WaveSnapshot snapshot;
+		waves.Capture(snapshot);
+		return snapshot;
+	}
+
+	bool SameSnapshot(const WaveSnapshot& a, const WaveSnapshot& b)
+	{
+		return a.Rows == b.Rows && a.Cols == b.Cols && a.Storage == b.Storage &&
+			DX::Test::BitEqual(a.HeightScale, b.HeightScale) &&
+			std::memcmp(a.SimulationConstants, b.SimulationConstants, sizeof(a.SimulationConstants)) == 0 &&
+			DX::Test::BitEqual(a.TimeStep, b.TimeStep) && DX::Test::BitEqual(a.SpatialStep, b.SpatialStep) &&
+			a.StepCount == b.StepCount && a.PrevPlane == b.PrevPlane && a.CurrPlane == b.CurrPlane;
+	}
+
+	bool SameHeights(const CpuWaves& a, const CpuWaves& b)
+	{
+		std::vector<float> rowA(COLS), rowB(COLS);
+		for (uint32 i = 0; i < ROWS; ++i)
+		{
+			a.GetSolutionRow(i, rowA.data());
+			b.GetSolutionRow(i, rowB.data());
+			for (uint32 j = 0; j < COLS; ++j)
+			{
+				if (!DX::Test::BitEqual(rowA[j], rowB[j])) return false;
+			}
+		}
+		return true;
+	}
+
+	template <class T>
+	std::vector<std::uint8_t> Patched(std::vector<std::uint8_t> bytes, const size_t offset, const T& value)
+	{
+		std::memcpy(&bytes[offset], &value, sizeof(value));
+		return bytes;
+	}
+}
+
+DX_TEST(WaveSnapshotRoundTripsEveryStorage)
+{
+	for (const WaveStorage storage : STORAGES)
+	{
+		CpuWaves waves = MakeWaves(storage);
+		Run(waves, 40, 1);
+		const WaveSnapshot snapshot = Capture(waves);
+
+		std::vector<std::uint8_t> bytes;
+		DX::EncodeWaveSnapshot(snapshot, bytes);
+
+		WaveSnapshot decoded;
+		DX_CHECK(DX::DecodeWaveSnapshot(bytes.data(), bytes.size(), decoded) == bytes.size());
+		DX_CHECK(DX::PeekWaveRecordSize(bytes.data(), bytes.size()) == bytes.size());
+		DX_CHECK(SameSnapshot(snapshot, decoded));
+		DX_CHECK(decoded.GetPlaneSize() == snapshot.GetPlaneSize());
+	}
+}
+
+DX_TEST(WaveSnapshotRejectsTruncatedAndCorruptRecords)
+{
+	CpuWaves waves = MakeWaves(WaveStorage::Float32);
+	Run(waves, 40, 2);
+	std::vector<std::uint8_t> bytes;
+	DX::EncodeWaveSnapshot(Capture(waves), bytes);
+
+	WaveSnapshot decoded;
+	bool truncatedRejected = true;
+	for (size_t size = 0; size < bytes.size(); ++size)
+	{
+		truncatedRejected = truncatedRejected &&
+			DX::DecodeWaveSnapshot(bytes.data(), size, decoded) == 0 &&
+			DX::PeekWaveRecordSize(bytes.data(), size) == 0;
+	}
+	DX_CHECK(truncatedRejected);
+
+	std::uint64_t planeSizes[2];
+	std::memcpy(planeSizes, &bytes[PLANE_SIZES_OFFSET], sizeof(planeSizes));
+
+	const std::vector<std::uint8_t> corrupt[] =
+	{
+		Patched(bytes, 0, std::uint32_t{ 0x12345678 }),
+		Patched(bytes, ROWS_OFFSET, DX::WAVE_SNAPSHOT_MAX_SIZE + 1),
+		Patched(bytes, STORAGE_OFFSET, std::uint32_t{ 3 }),
+		Patched(bytes, PLANE_SIZES_OFFSET, planeSizes[0] + 1),
+		Patched(bytes, PLANE_SIZES_OFFSET + 8, ~std::uint64_t{ 0 }),
+	};
+	for (const auto& record : corrupt)
+	{
+		DX_CHECK(DX::DecodeWaveSnapshot(record.data(), record.size(), decoded) == 0);
+	}
+
+	// The header alone shows a wrong magic or plane sizes past the end.
+	DX_CHECK(DX::PeekWaveRecordSize(corrupt[0].data(), corrupt[0].size()) == 0);
+	DX_CHECK(DX::PeekWaveRecordSize(corrupt[3].data(), corrupt[3].size()) == 0);
+	DX_CHECK(DX::PeekWaveRecordSize(corrupt[4].data(), corrupt[4].size()) == 0);
+}
+
+DX_TEST(CpuWavesRestoreContinuesBitForBit)
+{
+	for (const WaveStorage storage : STORAGES)
+	{
+		CpuWaves original = MakeWaves(storage);
+		Run(original, 30, 3);
+
+		// Through the encoder too, as a replay would read it from a file.
+		std::vector<std::uint8_t> bytes;
+		DX::EncodeWaveSnapshot(Capture(original), bytes);
+		WaveSnapshot snapshot;
+		DX::DecodeWaveSnapshot(bytes.data(), bytes.size(), snapshot);
+
+		CpuWaves restored = MakeWaves(storage);
+		restored.Restore(snapshot);
+		DX_CHECK(restored.GetStepCount() == original.GetStepCount());
+
+		Run(original, 50, 4);
+		Run(restored, 50, 4);
+		DX_CHECK(SameHeights(original, restored));
+	}
+}
+
+DX_TEST(WaveRecorderRoundTripsThroughAFile)
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "D3DAppTests.WaveRecording.bin";
+	constexpr std::uint64_t INTERVAL = 5;
+
+	std::vector<WaveSnapshot> submitted;
+	{
+		DX::WaveRecorder recorder(path, INTERVAL, 64);
+		CpuWaves waves = MakeWaves(WaveStorage::Float16);
+		for (uint32 step = 0; step < 60; ++step)
+		{
+			if (recorder.IsDue(waves.GetStepCount()))
+			{
+				submitted.push_back(Capture(waves));
+				WaveSnapshot frame = submitted.back();
+				DX_CHECK(recorder.Submit(std::move(frame)));
+			}
+			Run(waves, 1, step);
+		}
+		recorder.Flush();
+		DX_CHECK(!recorder.HasFailed());
+		DX_CHECK(recorder.GetRecordedFrames() == submitted.size());
+		DX_CHECK(recorder.GetDroppedFrames() == 0);
+	}
+	DX_CHECK(submitted.size() == 12);
+
+	{
+		const DX::WaveRecordingReader reader(path);
+		DX_CHECK(reader.GetFrameCount() == submitted.size());
+
+		bool identical = reader.GetFrameCount() == submitted.size();
+		for (size_t frame = 0; frame < reader.GetFrameCount() && identical; ++frame)
+		{
+			WaveSnapshot snapshot;
+			reader.ReadFrame(frame, snapshot);
+			identical = SameSnapshot(snapshot, submitted[frame]) && snapshot.StepCount % INTERVAL == 0;
+		}
+		DX_CHECK(identical);
+	}
+
+	// A last frame cut short, as by a crash while recording, is skipped.
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+	{
+		const DX::WaveRecordingReader reader(path);
+		DX_CHECK(reader.GetFrameCount() == submitted.size() - 1);
+	}
+	std::filesystem::remove(path);
+}
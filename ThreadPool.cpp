@@ -0,0 +1,132 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+DX::ThreadPool::ThreadPool(uint32 threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	for (uint32 i = 0; i < threadCount; ++i)
+	{
+		mQueues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	for (uint32 i = 0; i + 1 < threadCount; ++i)
+	{
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+DX::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(mWakeMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+void DX::ThreadPool::ParallelFor(const uint32 count, const std::function<void(uint32)>& body)
+{
+	if (count == 0) return;
+
+	if (count == 1 || mWorkers.empty())
+	{
+		for (uint32 i = 0; i < count; ++i) body(i);
+		return;
+	}
+
+	std::atomic<uint32> pending = count;
+	mQueuedTasks += count;
+
+	// Deal the indices out round-robin; stealing evens out whatever is left.
+	const auto queueCount = static_cast<uint32>(mQueues.size());
+	for (uint32 i = 0; i < count; ++i)
+	{
+		WorkQueue& queue = *mQueues[i % queueCount];
+		std::lock_guard lock(queue.Mutex);
+		queue.Tasks.push_back({ &body, i, &pending });
+	}
+
+	{
+		std::lock_guard lock(mWakeMutex);
+	}
+	mWake.notify_all();
+
+	const uint32 callerQueue = queueCount - 1;
+	while (pending.load(std::memory_order_acquire) > 0)
+	{
+		if (!TryRunTask(callerQueue))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void DX::ThreadPool::WorkerLoop(const uint32 queueIndex)
+{
+#if DX_PROFILER
+	Profiler::SetThreadName("Worker " + std::to_string(queueIndex));
+#endif
+
+	while (true)
+	{
+		if (TryRunTask(queueIndex)) continue;
+
+		std::unique_lock lock(mWakeMutex);
+		mWake.wait(lock, [this] { return mStopping || mQueuedTasks.load() > 0; });
+
+		if (mStopping && mQueuedTasks.load() == 0) return;
+	}
+}
+
+bool DX::ThreadPool::TryRunTask(const uint32 queueIndex)
+{
+	Task task;
+	if (!TryPop(queueIndex, task) && !TrySteal(queueIndex, task))
+	{
+		return false;
+	}
+
+	mQueuedTasks.fetch_sub(1);
+	(*task.Body)(task.Index);
+	task.Pending->fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+bool DX::ThreadPool::TryPop(const uint32 queueIndex, Task& task)
+{
+	WorkQueue& queue = *mQueues[queueIndex];
+	std::lock_guard lock(queue.Mutex);
+	if (queue.Tasks.empty()) return false;
+
+	task = queue.Tasks.back();
+	queue.Tasks.pop_back();
+	return true;
+}
+
+bool DX::ThreadPool::TrySteal(const uint32 thiefIndex, Task& task)
+{
+	const auto queueCount = static_cast<uint32>(mQueues.size());
+	for (uint32 offset = 1; offset < queueCount; ++offset)
+	{
+		WorkQueue& victim = *mQueues[(thiefIndex + offset) % queueCount];
+		std::lock_guard lock(victim.Mutex);
+		if (victim.Tasks.empty()) continue;
+
+		task = victim.Tasks.front();
+		victim.Tasks.pop_front();
+		return true;
+	}
+
+	return false;
+}
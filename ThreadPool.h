@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+	/**
+	 * \brief Fixed set of worker threads with one task queue each. A worker
+	 * pops from the back of its own queue and steals from the front of the
+	 * others when it runs dry, so uneven tiles balance themselves out.
+	 */
+	class ThreadPool
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+
+		// threadCount counts the calling thread, which joins in while it waits.
+		// 0 picks one thread per hardware thread.
+		explicit ThreadPool(uint32 threadCount = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(const ThreadPool&&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&&) = delete;
+		~ThreadPool();
+
+		[[nodiscard]] uint32 GetThreadCount() const { return static_cast<uint32>(mWorkers.size()) + 1; }
+
+		// Runs body(0) ... body(count - 1) across the pool and returns once all of them finished.
+		void ParallelFor(uint32 count, const std::function<void(uint32)>& body);
+
+	private:
+		struct Task
+		{
+			const std::function<void(uint32)>* Body = nullptr;
+			uint32 Index = 0;
+			std::atomic<uint32>* Pending = nullptr;
+		};
+
+		struct WorkQueue
+		{
+			std::mutex Mutex;
+			std::deque<Task> Tasks;
+		};
+
+		void WorkerLoop(uint32 queueIndex);
+		bool TryRunTask(uint32 queueIndex);
+		bool TryPop(uint32 queueIndex, Task& task);
+		bool TrySteal(uint32 thiefIndex, Task& task);
+
+	private:
+		// One queue per worker plus a last one owned by the calling thread.
+		std::vector<std::unique_ptr<WorkQueue>> mQueues;
+		std::vector<std::thread> mWorkers;
+
+		std::mutex mWakeMutex;
+		std::condition_variable mWake;
+		std::atomic<uint32> mQueuedTasks = 0;
+		bool mStopping = false;
+	};
+}
@@ -22,18 +22,26 @@ namespace DX
 			return mUploadBuffer.Get();
 		}
 
+		[[nodiscard]] UINT GetElementCount() const
+		{
+			return mElementCount;
+		}
+
 		void CopyData(int elementIndex, const T& data);
+		void CopyData(int firstElement, const T* data, UINT elementCount);
 
 	private:
 		Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer = nullptr;
 		BYTE* mMappedData = nullptr;
 
 		UINT mElementByteSize = 0;
+		UINT mElementCount = 0;
 		bool mIsConstantBuffer = false;
 	};
 
 	template <typename T>
 	UploadBuffer<T>::UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) :
+		mElementCount(elementCount),
 		mIsConstantBuffer(isConstantBuffer)
 	{
 		mElementByteSize = sizeof(T);
@@ -72,4 +80,19 @@ namespace DX
 	{
 		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
 	}
+
+	template <typename T>
+	void UploadBuffer<T>::CopyData(int firstElement, const T* data, UINT elementCount)
+	{
+		if (mIsConstantBuffer)
+		{
+			for (UINT i = 0; i < elementCount; ++i)
+			{
+				CopyData(firstElement + static_cast<int>(i), data[i]);
+			}
+			return;
+		}
+
+		memcpy(&mMappedData[firstElement * mElementByteSize], data, sizeof(T) * elementCount);
+	}
 }
@@ -0,0 +1,188 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include "CpuFeatures.h"
+#include "VertexPackingKernels.h"
+#include "WaveStorage.h"
+
+using namespace DirectX;
+using DX::GeometryGenerator;
+
+namespace
+{
+	using Vertex = GeometryGenerator::Vertex;
+	using DX::VertexPackingKernels::Kernels;
+	using DX::VertexPackingKernels::Quantizer;
+
+	// The AVX2 packers when the processor has AVX2 and F16C and the build has them.
+	const Kernels* const gAvx2Kernels = DX::GetCpuFeatures().Avx2 && DX::GetCpuFeatures().F16c ?
+		DX::VertexPackingKernels::GetAvx2Kernels() : nullptr;
+
+	constexpr float SNORM16_MAX = 32767.0f;
+
+	// w of every packed position, 1.0 once the input assembler expands the snorm.
+	constexpr std::int16_t SNORM16_ONE = 32767;
+
+	// Keeps a flat mesh, like a grid, from collapsing the dequantization scale.
+	constexpr float MIN_EXTENT = 1e-6f;
+
+	// Zero vectors encode as +z instead of dividing by zero.
+	constexpr float MIN_LENGTH = 1e-20f;
+
+	Quantizer MakeQuantizer(const DX::QuantizationBounds& bounds)
+	{
+		Quantizer quantizer{};
+		const float* center = &bounds.Center.x;
+		const float* extent = &bounds.Extent.x;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			quantizer.Center[axis] = center[axis];
+			quantizer.InvExtent[axis] = extent[axis] > 0.0f ? 1.0f / extent[axis] : 0.0f;
+		}
+		return quantizer;
+	}
+
+	std::int16_t QuantizeSnorm16(const float value)
+	{
+		return static_cast<std::int16_t>(std::nearbyint(std::min(std::max(value, -1.0f), 1.0f) * SNORM16_MAX));
+	}
+
+	void EncodeOctahedralScalar(const float x, const float y, const float z, std::int16_t encoded[2])
+	{
+		// Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower
+		// half over the diagonals so both halves share the unit square.
+		const float invLength = 1.0f / std::max(std::fabs(x) + std::fabs(y) + std::fabs(z), MIN_LENGTH);
+		float u = x * invLength;
+		float v = y * invLength;
+
+		if (z < 0.0f)
+		{
+			const float foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+			const float foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+			u = foldedU;
+			v = foldedV;
+		}
+
+		encoded[0] = QuantizeSnorm16(u);
+		encoded[1] = QuantizeSnorm16(v);
+	}
+
+	template <class Packed>
+	void PackCompactScalar(const Vertex* vertices, size_t first, size_t last, const Quantizer& quantizer, Packed* packed)
+	{
+		for (size_t i = first; i < last; ++i)
+		{
+			const Vertex& vertex = vertices[i];
+			Packed& out = packed[i];
+
+			const float* position = &vertex.Position.x;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				out.Position[axis] = QuantizeSnorm16((position[axis] - quantizer.Center[axis]) * quantizer.InvExtent[axis]);
+			}
+			out.Position[3] = SNORM16_ONE;
+
+			EncodeOctahedralScalar(vertex.Normal.x, vertex.Normal.y, vertex.Normal.z, out.Normal);
+			if constexpr (std::is_same_v<Packed, DX::CompactTangentVertex>)
+			{
+				EncodeOctahedralScalar(vertex.TangentU.x, vertex.TangentU.y, vertex.TangentU.z, out.Tangent);
+			}
+
+			out.TexC[0] = DX::FloatToHalf(vertex.TexC.x);
+			out.TexC[1] = DX::FloatToHalf(vertex.TexC.y);
+		}
+	}
+
+	static_assert(sizeof(Vertex) == 11 * sizeof(float));
+
+	template <class Packed>
+	void PackCompact(const Vertex* vertices, size_t count, const DX::QuantizationBounds& bounds, Packed* packed)
+	{
+		const Quantizer quantizer = MakeQuantizer(bounds);
+
+		size_t first = 0;
+		if (gAvx2Kernels != nullptr)
+		{
+			if constexpr (std::is_same_v<Packed, DX::CompactTangentVertex>)
+				first = gAvx2Kernels->PackCompactTangent(&vertices[0].Position.x, count, quantizer, packed);
+			else
+				first = gAvx2Kernels->PackCompact(&vertices[0].Position.x, count, quantizer, packed);
+		}
+		PackCompactScalar(vertices, first, count, quantizer, packed);
+	}
+}
+
+DX::QuantizationBounds DX::ComputeQuantizationBounds(const GeometryGenerator::Vertex* vertices, const size_t count)
+{
+	QuantizationBounds bounds;
+	if (count == 0) return bounds;
+
+	XMVECTOR lower = XMLoadFloat3(&vertices[0].Position);
+	XMVECTOR upper = lower;
+	for (size_t i = 1; i < count; ++i)
+	{
+		const XMVECTOR p = XMLoadFloat3(&vertices[i].Position);
+		lower = XMVectorMin(lower, p);
+		upper = XMVectorMax(upper, p);
+	}
+
+	XMStoreFloat3(&bounds.Center, 0.5f * (lower + upper));
+	XMStoreFloat3(&bounds.Extent, XMVectorMax(0.5f * (upper - lower), XMVectorReplicate(MIN_EXTENT)));
+	return bounds;
+}
+
+DirectX::XMFLOAT4X4 DX::GetDequantizationTransform(const QuantizationBounds& bounds)
+{
+	// Only valid for positions; normals are unit vectors and keep the plain world matrix.
+	XMFLOAT4X4 transform;
+	XMStoreFloat4x4(&transform,
+		XMMatrixScaling(bounds.Extent.x, bounds.Extent.y, bounds.Extent.z) *
+		XMMatrixTranslation(bounds.Center.x, bounds.Center.y, bounds.Center.z));
+	return transform;
+}
+
+void DX::EncodeOctahedral(const DirectX::XMFLOAT3& direction, std::int16_t encoded[2])
+{
+	EncodeOctahedralScalar(direction.x, direction.y, direction.z, encoded);
+}
+
+DirectX::XMFLOAT3 DX::DecodeOctahedral(const std::int16_t encoded[2])
+{
+	// Unfold the lower half, then renormalize off the octahedron.
+	const float u = std::max(encoded[0] / SNORM16_MAX, -1.0f);
+	const float v = std::max(encoded[1] / SNORM16_MAX, -1.0f);
+	const float z = 1.0f - std::fabs(u) - std::fabs(v);
+	const float fold = std::max(-z, 0.0f);
+
+	XMFLOAT3 direction(u >= 0.0f ? u - fold : u + fold, v >= 0.0f ? v - fold : v + fold, z);
+	XMStoreFloat3(&direction, XMVector3Normalize(XMLoadFloat3(&direction)));
+	return direction;
+}
+
+void DX::PackVertexStreams(const GeometryGenerator::Vertex* vertices, const size_t count, const VertexStreams& streams)
+{
+	// One pass per stream keeps each destination write sequential.
+	if (streams.Positions != nullptr)
+		for (size_t i = 0; i < count; ++i) streams.Positions[i] = vertices[i].Position;
+	if (streams.Normals != nullptr)
+		for (size_t i = 0; i < count; ++i) streams.Normals[i] = vertices[i].Normal;
+	if (streams.Tangents != nullptr)
+		for (size_t i = 0; i < count; ++i) streams.Tangents[i] = vertices[i].TangentU;
+	if (streams.TexCoords != nullptr)
+		for (size_t i = 0; i < count; ++i) streams.TexCoords[i] = vertices[i].TexC;
+}
+
+void DX::PackCompactVertices(const GeometryGenerator::Vertex* vertices, const size_t count,
+	const QuantizationBounds& bounds, CompactVertex* packed)
+{
+	PackCompact(vertices, count, bounds, packed);
+}
+
+void DX::PackCompactVertices(const GeometryGenerator::Vertex* vertices, const size_t count,
+	const QuantizationBounds& bounds, CompactTangentVertex* packed)
+{
+	PackCompact(vertices, count, bounds, packed);
+}
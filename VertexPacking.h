@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+
+#include "GeometryGenerator.h"
+
+namespace DX
+{
+	// Destination arrays for PackVertexStreams, one element per vertex.
+	// Streams left null are skipped, so e.g. a depth pass can take only
+	// the positions.
+	struct VertexStreams
+	{
+		DirectX::XMFLOAT3* Positions = nullptr;
+		DirectX::XMFLOAT3* Normals = nullptr;
+		DirectX::XMFLOAT3* Tangents = nullptr;
+		DirectX::XMFLOAT2* TexCoords = nullptr;
+	};
+
+	// Box the 16-bit positions are quantized over: position = Center + snorm * Extent.
+	struct QuantizationBounds
+	{
+		DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 Extent = { 1.0f, 1.0f, 1.0f };
+	};
+
+	// 16 bytes, the contents of DX::Vertex:
+	// R16G16B16A16_SNORM position (w is 1), R16G16_SNORM octahedral normal, R16G16_FLOAT uv.
+	struct CompactVertex
+	{
+		std::int16_t Position[4];
+		std::int16_t Normal[2];
+		std::uint16_t TexC[2];
+	};
+
+	// 20 bytes, CompactVertex plus an R16G16_SNORM octahedral tangent.
+	struct CompactTangentVertex
+	{
+		std::int16_t Position[4];
+		std::int16_t Normal[2];
+		std::int16_t Tangent[2];
+		std::uint16_t TexC[2];
+	};
+
+	static_assert(sizeof(CompactVertex) == 16);
+	static_assert(sizeof(CompactTangentVertex) == 20);
+
+	[[nodiscard]] QuantizationBounds ComputeQuantizationBounds(const GeometryGenerator::Vertex* vertices, size_t count);
+
+	// Maps the unit snorm cube onto bounds. Multiply it in front of the world
+	// matrix so quantized positions need no extra work in the vertex shader.
+	[[nodiscard]] DirectX::XMFLOAT4X4 GetDequantizationTransform(const QuantizationBounds& bounds);
+
+	// Octahedral encoding of a unit vector into two snorm16 values and back.
+	void EncodeOctahedral(const DirectX::XMFLOAT3& direction, std::int16_t encoded[2]);
+	[[nodiscard]] DirectX::XMFLOAT3 DecodeOctahedral(const std::int16_t encoded[2]);
+
+	// Splits interleaved vertices into separate attribute streams.
+	void PackVertexStreams(const GeometryGenerator::Vertex* vertices, size_t count, const VertexStreams& streams);
+
+	// Quantize vertices into a compact layout. Positions outside bounds are clamped.
+	void PackCompactVertices(const GeometryGenerator::Vertex* vertices, size_t count,
+		const QuantizationBounds& bounds, CompactVertex* packed);
+	void PackCompactVertices(const GeometryGenerator::Vertex* vertices, size_t count,
+		const QuantizationBounds& bounds, CompactTangentVertex* packed);
+}
@@ -0,0 +1,149 @@
+#include "VertexPackingKernels.h"
+
+// Only the plain structs of these headers are used here, so nothing inline
+// from them gets compiled for AVX2.
+#include "GeometryGenerator.h"
+#include "VertexPacking.h"
+#include "WaveStorage.h"
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#if defined(__F16C__) || defined(_MSC_VER)
+#define VERTEX_PACKING_F16C
+#endif
+
+namespace
+{
+	using DX::VertexPackingKernels::Quantizer;
+
+	constexpr float SNORM16_MAX = 32767.0f;
+	constexpr std::int16_t SNORM16_ONE = 32767;
+
+	// Zero vectors encode as +z instead of dividing by zero.
+	constexpr float MIN_LENGTH = 1e-20f;
+
+	// Eight vertices per iteration. The attributes are gathered out of the
+	// 44-byte vertices and go through the same float operations as the
+	// scalar path, so both produce identical bits.
+	constexpr size_t VERTEX_FLOATS = 11;
+	static_assert(sizeof(DX::GeometryGenerator::Vertex) == VERTEX_FLOATS * sizeof(float));
+
+	__m256i QuantizeSnorm16x8(const __m256 value)
+	{
+		const __m256 clamped = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+		return _mm256_cvtps_epi32(_mm256_mul_ps(clamped, _mm256_set1_ps(SNORM16_MAX)));
+	}
+
+	void EncodeOctahedralSimd(const __m256 x, const __m256 y, const __m256 z, __m256i& encodedU, __m256i& encodedV)
+	{
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 minusOne = _mm256_set1_ps(-1.0f);
+
+		const __m256 length = _mm256_add_ps(_mm256_add_ps(_mm256_and_ps(x, absMask), _mm256_and_ps(y, absMask)),
+			_mm256_and_ps(z, absMask));
+		const __m256 invLength = _mm256_div_ps(one, _mm256_max_ps(length, _mm256_set1_ps(MIN_LENGTH)));
+		const __m256 u = _mm256_mul_ps(x, invLength);
+		const __m256 v = _mm256_mul_ps(y, invLength);
+
+		const __m256 signU = _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+		const __m256 signV = _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+		const __m256 foldedU = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_and_ps(v, absMask)), signU);
+		const __m256 foldedV = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_and_ps(u, absMask)), signV);
+
+		const __m256 lower = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+		encodedU = QuantizeSnorm16x8(_mm256_blendv_ps(u, foldedU, lower));
+		encodedV = QuantizeSnorm16x8(_mm256_blendv_ps(v, foldedV, lower));
+	}
+
+	template <class Packed>
+	size_t PackCompact(const float* vertices, size_t count, const Quantizer& quantizer, Packed* packed)
+	{
+		constexpr bool hasTangent = std::is_same_v<Packed, DX::CompactTangentVertex>;
+		const __m256i lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+			_mm256_set1_epi32(static_cast<int>(VERTEX_FLOATS)));
+
+		const auto gather = [&lanes](const float* base, const int field)
+		{
+			return _mm256_i32gather_ps(base, _mm256_add_epi32(lanes, _mm256_set1_epi32(field)), sizeof(float));
+		};
+
+		alignas(32) std::int32_t position[3][8];
+		alignas(32) std::int32_t normal[2][8];
+		alignas(32) std::int32_t tangent[2][8];
+		alignas(32) std::uint16_t texC[2][8];
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const float* base = vertices + i * VERTEX_FLOATS;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const __m256 p = _mm256_sub_ps(gather(base, axis), _mm256_set1_ps(quantizer.Center[axis]));
+				const __m256i q = QuantizeSnorm16x8(_mm256_mul_ps(p, _mm256_set1_ps(quantizer.InvExtent[axis])));
+				_mm256_store_si256(reinterpret_cast<__m256i*>(position[axis]), q);
+			}
+
+			__m256i u, v;
+			EncodeOctahedralSimd(gather(base, 3), gather(base, 4), gather(base, 5), u, v);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(normal[0]), u);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(normal[1]), v);
+
+			if constexpr (hasTangent)
+			{
+				EncodeOctahedralSimd(gather(base, 6), gather(base, 7), gather(base, 8), u, v);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(tangent[0]), u);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(tangent[1]), v);
+			}
+
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				const __m256 t = gather(base, 9 + axis);
+#if defined(VERTEX_PACKING_F16C)
+				_mm_store_si128(reinterpret_cast<__m128i*>(texC[axis]), _mm256_cvtps_ph(t, _MM_FROUND_TO_NEAREST_INT));
+#else
+				alignas(32) float values[8];
+				_mm256_store_ps(values, t);
+				for (int lane = 0; lane < 8; ++lane) texC[axis][lane] = DX::FloatToHalf(values[lane]);
+#endif
+			}
+
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				Packed& out = packed[i + lane];
+				out.Position[0] = static_cast<std::int16_t>(position[0][lane]);
+				out.Position[1] = static_cast<std::int16_t>(position[1][lane]);
+				out.Position[2] = static_cast<std::int16_t>(position[2][lane]);
+				out.Position[3] = SNORM16_ONE;
+				out.Normal[0] = static_cast<std::int16_t>(normal[0][lane]);
+				out.Normal[1] = static_cast<std::int16_t>(normal[1][lane]);
+				if constexpr (hasTangent)
+				{
+					out.Tangent[0] = static_cast<std::int16_t>(tangent[0][lane]);
+					out.Tangent[1] = static_cast<std::int16_t>(tangent[1][lane]);
+				}
+				out.TexC[0] = texC[0][lane];
+				out.TexC[1] = texC[1][lane];
+			}
+		}
+
+		return i;
+	}
+}
+
+const DX::VertexPackingKernels::Kernels* DX::VertexPackingKernels::GetAvx2Kernels()
+{
+	static constexpr Kernels KERNELS = { PackCompact<CompactVertex>, PackCompact<CompactTangentVertex> };
+	return &KERNELS;
+}
+#else
+const DX::VertexPackingKernels::Kernels* DX::VertexPackingKernels::GetAvx2Kernels()
+{
+	return nullptr;
+}
+#endif
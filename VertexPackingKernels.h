@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+	struct CompactVertex;
+	struct CompactTangentVertex;
+
+	namespace VertexPackingKernels
+	{
+		// Per-batch constants shared by the scalar and SIMD packers.
+		struct Quantizer
+		{
+			float Center[3];
+			float InvExtent[3];
+		};
+
+		// Packers built with AVX2 and F16C in VertexPackingAvx2.cpp. vertices
+		// points at GeometryGenerator::Vertex data. Each handles whole groups
+		// of eight vertices and returns how many it did; the scalar packer
+		// finishes the rest with the same float operations, so the bits agree.
+		struct Kernels
+		{
+			size_t (*PackCompact)(const float* vertices, size_t count, const Quantizer& quantizer, CompactVertex* packed);
+			size_t (*PackCompactTangent)(const float* vertices, size_t count, const Quantizer& quantizer,
+				CompactTangentVertex* packed);
+		};
+
+		// nullptr when the file was built without AVX2. Only call these once
+		// GetCpuFeatures reports AVX2 and F16C.
+		const Kernels* GetAvx2Kernels();
+	}
+}
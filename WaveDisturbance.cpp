@@ -0,0 +1,85 @@
+#include "WaveDisturbance.h"
+
+namespace
+{
+	// Open-addressing map from a cell to its entry in cellDeltas, which
+	// also holds the keys. A load factor of at most 3/4 keeps probe runs
+	// short and the table small enough to stay in cache.
+	class CellTable
+	{
+	public:
+		static constexpr std::uint32_t EMPTY = 0xffffffffu;
+
+		void Reset(const size_t maxCells)
+		{
+			std::uint32_t bits = 4;
+			while ((size_t{ 3 } << bits) < maxCells * 4) ++bits;
+
+			mEntries.assign(size_t{ 1 } << bits, EMPTY);
+			mMask = (1u << bits) - 1;
+			mShift = 32 - bits;
+		}
+
+		// The entry of (row, col), or a reference to the EMPTY slot to claim for it.
+		std::uint32_t& Find(const std::uint32_t row, const std::uint32_t col, const std::vector<DX::WaveCellDelta>& cellDeltas)
+		{
+			// Multiplicative hash; the top bits are the well mixed ones.
+			std::uint32_t slot = ((row * 0x9e3779b1u + col) * 0x85ebca77u) >> mShift;
+			while (mEntries[slot] != EMPTY)
+			{
+				const auto& cell = cellDeltas[mEntries[slot]];
+				if (cell.Row == row && cell.Col == col) break;
+				slot = (slot + 1) & mMask;
+			}
+			return mEntries[slot];
+		}
+
+	private:
+		std::vector<std::uint32_t> mEntries;
+		std::uint32_t mMask = 0;
+		std::uint32_t mShift = 32;
+	};
+}
+
+size_t DX::CompactDisturbances(const WaveDisturbance* disturbances, const size_t count,
+	const std::uint32_t rows, const std::uint32_t cols, std::vector<WaveCellDelta>& cellDeltas)
+{
+	cellDeltas.clear();
+	if (count == 0) return 0;
+
+	thread_local CellTable table;
+	table.Reset(count * 5);
+	cellDeltas.reserve(count * 5);
+
+	// Hits on one cell are summed in drop order, cells are listed by first hit.
+	const auto addHit = [&](const std::int64_t row, const std::int64_t col, const float delta)
+	{
+		if (row < 0 || col < 0 || row >= rows || col >= cols) return;
+
+		std::uint32_t& entry = table.Find(static_cast<std::uint32_t>(row), static_cast<std::uint32_t>(col), cellDeltas);
+		if (entry != CellTable::EMPTY)
+		{
+			cellDeltas[entry].Delta += delta;
+			return;
+		}
+
+		entry = static_cast<std::uint32_t>(cellDeltas.size());
+		cellDeltas.push_back({ static_cast<std::uint32_t>(row), static_cast<std::uint32_t>(col), delta });
+	};
+
+	for (size_t k = 0; k < count; ++k)
+	{
+		const std::int64_t i = disturbances[k].Row;
+		const std::int64_t j = disturbances[k].Col;
+		const float magnitude = disturbances[k].Magnitude;
+		const float halfMag = 0.5f * magnitude;
+
+		addHit(i, j, magnitude);
+		addHit(i, j + 1, halfMag);
+		addHit(i, j - 1, halfMag);
+		addHit(i + 1, j, halfMag);
+		addHit(i - 1, j, halfMag);
+	}
+
+	return cellDeltas.size();
+}
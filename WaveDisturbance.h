@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// A drop on the wave grid, same footprint as wavesDisturbCS.hlsl:
+	// Magnitude on (Row, Col) and half of it on the four neighbours.
+	struct WaveDisturbance
+	{
+		std::uint32_t Row = 0;
+		std::uint32_t Col = 0;
+		float Magnitude = 0.0f;
+	};
+
+	// Height change of one cell. Layout matches CellDelta in wavesDisturbBatchCS.hlsl.
+	struct WaveCellDelta
+	{
+		std::uint32_t Row = 0;
+		std::uint32_t Col = 0;
+		float Delta = 0.0f;
+	};
+
+	/**
+	 * \brief Expands drops into their five-cell footprints, drops cells that
+	 * fall outside the rows x cols grid and merges hits on the same cell, so
+	 * every cell appears at most once in cellDeltas and the list can be
+	 * applied in any order, or in parallel, without conflicting writes.
+	 * Hits on one cell are summed in drop order, so the output is
+	 * deterministic. Returns the number of cell deltas written.
+	 */
+	size_t CompactDisturbances(const WaveDisturbance* disturbances, size_t count,
+		std::uint32_t rows, std::uint32_t cols, std::vector<WaveCellDelta>& cellDeltas);
+}
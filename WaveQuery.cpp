@@ -0,0 +1,294 @@
+#include "WaveQuery.h"
+#include "CpuFeatures.h"
+#include "WaveQueryKernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVE_QUERY_SSE2
+#endif
+
+namespace
+{
+	using DX::WaveQueryKernels::Lattice;
+
+	constexpr int CELL_STRIDE = static_cast<int>(DX::WaveSurfaceView::CELL_STRIDE);
+
+	// The AVX2 height sampler when both the processor and the build have it.
+	const DX::WaveQueryKernels::SampleKernel gAvx2SampleHeights =
+		DX::GetCpuFeatures().Avx2 ? DX::WaveQueryKernels::GetAvx2SampleHeights() : nullptr;
+
+	Lattice MakeLattice(const DX::WaveSurfaceView& view)
+	{
+		Lattice lattice{};
+		lattice.InvSpatialStep = 1.0f / view.SpatialStep;
+		lattice.HalfRows = 0.5f * static_cast<float>(view.Rows - 1);
+		lattice.HalfCols = 0.5f * static_cast<float>(view.Cols - 1);
+		lattice.MaxRow = static_cast<float>(view.Rows - 1);
+		lattice.MaxCol = static_cast<float>(view.Cols - 1);
+
+		// The base cell of the last row / column is the one before it, so
+		// a sample on the far edge interpolates towards it with weight 1.
+		lattice.LastRowBase = static_cast<float>(view.Rows > 1 ? view.Rows - 2 : 0);
+		lattice.LastColBase = static_cast<float>(view.Cols > 1 ? view.Cols - 2 : 0);
+		lattice.TwoSpatialStep = 2.0f * view.SpatialStep;
+		lattice.RowStep = view.Rows > 1 ? static_cast<int>(view.RowPitch) : 0;
+		lattice.ColStep = view.Cols > 1 ? 1 : 0;
+		lattice.Pitch = static_cast<int>(view.RowPitch);
+		return lattice;
+	}
+
+	// Base cell of a query and its weights towards the next row and column.
+	struct Footprint
+	{
+		int Index;
+		float Ti;
+		float Tj;
+	};
+
+	Footprint Locate(const Lattice& lattice, const float x, const float z)
+	{
+		const float fi = std::min(std::max(lattice.HalfRows - z * lattice.InvSpatialStep, 0.0f), lattice.MaxRow);
+		const float fj = std::min(std::max(x * lattice.InvSpatialStep + lattice.HalfCols, 0.0f), lattice.MaxCol);
+		const float baseI = std::min(std::floor(fi), lattice.LastRowBase);
+		const float baseJ = std::min(std::floor(fj), lattice.LastColBase);
+
+		Footprint footprint;
+		footprint.Index = static_cast<int>(baseI) * lattice.Pitch + static_cast<int>(baseJ);
+		footprint.Ti = fi - baseI;
+		footprint.Tj = fj - baseJ;
+		return footprint;
+	}
+
+	float Lerp(const float a, const float b, const float t)
+	{
+		return a + (b - a) * t;
+	}
+
+	bool WantsNormals(const DX::WaveQueryBatch& batch)
+	{
+		return batch.NormalX != nullptr || batch.NormalY != nullptr || batch.NormalZ != nullptr;
+	}
+
+	void SampleHeightsScalar(const DX::WaveSurfaceView& view, const Lattice& lattice, const DX::WaveQueryBatch& batch,
+		const size_t begin, const size_t end)
+	{
+		for (size_t q = begin; q < end; ++q)
+		{
+			const Footprint footprint = Locate(lattice, batch.X[q], batch.Z[q]);
+			const float* cell = view.Heights + footprint.Index;
+
+			const float top = Lerp(cell[0], cell[lattice.ColStep], footprint.Tj);
+			const float bottom = Lerp(cell[lattice.RowStep], cell[lattice.RowStep + lattice.ColStep], footprint.Tj);
+			batch.Heights[q] = Lerp(top, bottom, footprint.Ti);
+		}
+	}
+
+	// Every field of view.Cells, so a query reads two cache lines however
+	// many outputs it asks for.
+	void SampleCellsScalar(const DX::WaveSurfaceView& view, const Lattice& lattice, const DX::WaveQueryBatch& batch,
+		const size_t begin, const size_t end)
+	{
+		const int rowStep = lattice.RowStep * CELL_STRIDE;
+		const int colStep = lattice.ColStep * CELL_STRIDE;
+		const bool wantNormals = WantsNormals(batch);
+
+		for (size_t q = begin; q < end; ++q)
+		{
+			const Footprint footprint = Locate(lattice, batch.X[q], batch.Z[q]);
+			const float* cell = view.Cells + footprint.Index * CELL_STRIDE;
+
+			float fields[CELL_STRIDE];
+			for (int k = 0; k < CELL_STRIDE; ++k)
+			{
+				const float top = Lerp(cell[k], cell[colStep + k], footprint.Tj);
+				const float bottom = Lerp(cell[rowStep + k], cell[rowStep + colStep + k], footprint.Tj);
+				fields[k] = Lerp(top, bottom, footprint.Ti);
+			}
+
+			if (batch.Heights != nullptr)    batch.Heights[q] = fields[0];
+			if (batch.Velocities != nullptr) batch.Velocities[q] = fields[1];
+
+			if (wantNormals)
+			{
+				const float nx = fields[2];
+				const float ny = lattice.TwoSpatialStep;
+				const float nz = fields[3];
+				const float invLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+
+				if (batch.NormalX != nullptr) batch.NormalX[q] = nx * invLength;
+				if (batch.NormalY != nullptr) batch.NormalY[q] = ny * invLength;
+				if (batch.NormalZ != nullptr) batch.NormalZ[q] = nz * invLength;
+			}
+		}
+	}
+
+#if defined(WAVE_QUERY_SSE2)
+	__m128 Lerp4(const __m128 a, const __m128 b, const __m128 t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+	}
+
+	// SampleCellsScalar with the fields of a cell in one register, four
+	// queries at a time; returns how many it did. Queries are located a
+	// block ahead of the interpolation, prefetching their cells, so the
+	// cache misses of a block overlap rather than follow each other.
+	size_t SampleCellsSse2(const DX::WaveSurfaceView& view, const Lattice& lattice, const DX::WaveQueryBatch& batch)
+	{
+		constexpr size_t BLOCK = 64;
+
+		const __m128 invSpatialStep = _mm_set1_ps(lattice.InvSpatialStep);
+		const __m128 halfRows = _mm_set1_ps(lattice.HalfRows);
+		const __m128 halfCols = _mm_set1_ps(lattice.HalfCols);
+		const __m128 maxRow = _mm_set1_ps(lattice.MaxRow);
+		const __m128 maxCol = _mm_set1_ps(lattice.MaxCol);
+		const __m128 lastRowBase = _mm_set1_ps(lattice.LastRowBase);
+		const __m128 lastColBase = _mm_set1_ps(lattice.LastColBase);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 ny = _mm_set1_ps(lattice.TwoSpatialStep);
+		const int rowStep = lattice.RowStep * CELL_STRIDE;
+		const int colStep = lattice.ColStep * CELL_STRIDE;
+		const bool wantNormals = WantsNormals(batch);
+
+		alignas(16) float ti[BLOCK];
+		alignas(16) float tj[BLOCK];
+		alignas(16) int rows[BLOCK];
+		alignas(16) int cols[BLOCK];
+
+		size_t q = 0;
+		while (q + 4 <= batch.Count)
+		{
+			const size_t count = std::min(BLOCK, (batch.Count - q) / 4 * 4);
+
+			for (size_t k = 0; k < count; k += 4)
+			{
+				// Locate, four queries at a time. The coordinates are
+				// clamped to be non-negative, where truncation is floor.
+				__m128 fi = _mm_sub_ps(halfRows, _mm_mul_ps(_mm_loadu_ps(batch.Z + q + k), invSpatialStep));
+				__m128 fj = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(batch.X + q + k), invSpatialStep), halfCols);
+				fi = _mm_min_ps(_mm_max_ps(fi, zero), maxRow);
+				fj = _mm_min_ps(_mm_max_ps(fj, zero), maxCol);
+				const __m128 baseI = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fi)), lastRowBase);
+				const __m128 baseJ = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fj)), lastColBase);
+
+				_mm_store_ps(ti + k, _mm_sub_ps(fi, baseI));
+				_mm_store_ps(tj + k, _mm_sub_ps(fj, baseJ));
+				_mm_store_si128(reinterpret_cast<__m128i*>(rows + k), _mm_cvttps_epi32(baseI));
+				_mm_store_si128(reinterpret_cast<__m128i*>(cols + k), _mm_cvttps_epi32(baseJ));
+
+				for (size_t m = k; m < k + 4; ++m)
+				{
+					const float* cell = view.Cells + (rows[m] * lattice.Pitch + cols[m]) * CELL_STRIDE;
+					_mm_prefetch(reinterpret_cast<const char*>(cell), _MM_HINT_T0);
+					_mm_prefetch(reinterpret_cast<const char*>(cell + rowStep), _MM_HINT_T0);
+				}
+			}
+
+			for (size_t k = 0; k < count; k += 4)
+			{
+				__m128 fields[4];
+				for (size_t m = 0; m < 4; ++m)
+				{
+					const float* cell = view.Cells + (rows[k + m] * lattice.Pitch + cols[k + m]) * CELL_STRIDE;
+					const __m128 weightJ = _mm_set1_ps(tj[k + m]);
+
+					const __m128 top = Lerp4(_mm_loadu_ps(cell), _mm_loadu_ps(cell + colStep), weightJ);
+					const __m128 bottom = Lerp4(_mm_loadu_ps(cell + rowStep), _mm_loadu_ps(cell + rowStep + colStep), weightJ);
+					fields[m] = Lerp4(top, bottom, _mm_set1_ps(ti[k + m]));
+				}
+
+				// From one query per register to one field per register.
+				_MM_TRANSPOSE4_PS(fields[0], fields[1], fields[2], fields[3]);
+
+				if (batch.Heights != nullptr)    _mm_storeu_ps(batch.Heights + q + k, fields[0]);
+				if (batch.Velocities != nullptr) _mm_storeu_ps(batch.Velocities + q + k, fields[1]);
+
+				if (wantNormals)
+				{
+					const __m128 nx = fields[2];
+					const __m128 nz = fields[3];
+					const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+					const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+					if (batch.NormalX != nullptr) _mm_storeu_ps(batch.NormalX + q + k, _mm_mul_ps(nx, invLength));
+					if (batch.NormalY != nullptr) _mm_storeu_ps(batch.NormalY + q + k, _mm_mul_ps(ny, invLength));
+					if (batch.NormalZ != nullptr) _mm_storeu_ps(batch.NormalZ + q + k, _mm_mul_ps(nz, invLength));
+				}
+			}
+
+			q += count;
+		}
+		return q;
+	}
+#endif
+}
+
+void DX::SampleWaveSurface(const WaveSurfaceView& view, const WaveQueryBatch& batch)
+{
+	assert(view.Rows > 0 && view.Cols > 0);
+	// Gathers take 32-bit offsets.
+	assert(static_cast<std::uint64_t>(view.Rows) * view.RowPitch * WaveSurfaceView::CELL_STRIDE <
+		static_cast<std::uint64_t>(INT_MAX));
+
+	const Lattice lattice = MakeLattice(view);
+	size_t done = 0;
+
+	// Heights alone come from their own plane, a quarter the size of Cells.
+	if (batch.Velocities == nullptr && !WantsNormals(batch))
+	{
+		if (batch.Heights == nullptr) return;
+
+		if (gAvx2SampleHeights != nullptr)
+		{
+			done = gAvx2SampleHeights(view, lattice, batch);
+		}
+		SampleHeightsScalar(view, lattice, batch, done, batch.Count);
+		return;
+	}
+
+#if defined(WAVE_QUERY_SSE2)
+	done = SampleCellsSse2(view, lattice, batch);
+#endif
+	SampleCellsScalar(view, lattice, batch, done, batch.Count);
+}
+
+std::uint64_t DX::QueryWaveSurface(const WaveSurface& surface, const WaveQueryBatch& batch, ThreadPool* threadPool)
+{
+	const auto chunkCount = static_cast<std::uint32_t>((batch.Count + WAVE_QUERY_CHUNK - 1) / WAVE_QUERY_CHUNK);
+
+	while (true)
+	{
+		const WaveSurfaceView view = surface.Acquire();
+
+		if (threadPool == nullptr || chunkCount <= 1)
+		{
+			SampleWaveSurface(view, batch);
+		}
+		else
+		{
+			threadPool->ParallelFor(chunkCount, [&view, &batch](const std::uint32_t chunk)
+			{
+				const size_t first = chunk * WAVE_QUERY_CHUNK;
+				const auto offset = [first](auto* array) { return array != nullptr ? array + first : nullptr; };
+
+				WaveQueryBatch part;
+				part.X = batch.X + first;
+				part.Z = batch.Z + first;
+				part.Count = std::min(WAVE_QUERY_CHUNK, batch.Count - first);
+				part.Heights = offset(batch.Heights);
+				part.Velocities = offset(batch.Velocities);
+				part.NormalX = offset(batch.NormalX);
+				part.NormalY = offset(batch.NormalY);
+				part.NormalZ = offset(batch.NormalZ);
+				SampleWaveSurface(view, part);
+			});
+		}
+
+		if (surface.IsIntact(view)) return view.Epoch;
+	}
+}
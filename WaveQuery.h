@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ThreadPool.h"
+#include "WaveSurface.h"
+
+namespace DX
+{
+	// Structure-of-arrays batch of surface lookups. Positions are in the
+	// grid's local xz plane, centred like GeometryGenerator::CreateGrid:
+	// cell (i, j) sits at x = (j - (Cols - 1) / 2) * dx, z = ((Rows - 1) / 2 - i) * dx.
+	// Positions outside the grid read its nearest edge. Outputs left null
+	// are skipped.
+	struct WaveQueryBatch
+	{
+		const float* X = nullptr;
+		const float* Z = nullptr;
+		size_t Count = 0;
+
+		float* Heights = nullptr;
+		float* Velocities = nullptr;
+		float* NormalX = nullptr;
+		float* NormalY = nullptr;
+		float* NormalZ = nullptr;
+	};
+
+	// Queries per task when QueryWaveSurface splits a batch across a pool.
+	inline constexpr size_t WAVE_QUERY_CHUNK = 8192;
+
+	// Bilinearly interpolates the requested outputs of view at every
+	// position: heights alone from its Heights plane, anything more from its
+	// interleaved Cells in one pass. Normals are normalized from the
+	// interpolated height differences, so at grid points they match the
+	// surface's normal planes.
+	void SampleWaveSurface(const WaveSurfaceView& view, const WaveQueryBatch& batch);
+
+	// Samples the latest published step, retrying if the stage overwrote it
+	// while the batch ran. Returns the epoch (solver step) the results
+	// belong to. Safe to call from any thread while the simulation runs.
+	// Large batches are split into chunks across threadPool when given.
+	std::uint64_t QueryWaveSurface(const WaveSurface& surface, const WaveQueryBatch& batch,
+		ThreadPool* threadPool = nullptr);
+}
@@ -0,0 +1,90 @@
+#include "WaveQueryKernels.h"
+
+// Only the plain structs of this header are used here, so nothing inline
+// from it gets compiled for AVX2.
+#include "WaveQuery.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+	using DX::WaveQueryKernels::Lattice;
+
+	__m256 Lerp8(const __m256 a, const __m256 b, const __m256 t)
+	{
+		return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+	}
+
+	struct Footprint8
+	{
+		__m256i Index00;
+		__m256i Index01;
+		__m256i Index10;
+		__m256i Index11;
+		__m256 Ti;
+		__m256 Tj;
+	};
+
+	__m256 Bilinear8(const float* plane, const Footprint8& footprint)
+	{
+		const __m256 top = Lerp8(
+			_mm256_i32gather_ps(plane, footprint.Index00, 4),
+			_mm256_i32gather_ps(plane, footprint.Index01, 4), footprint.Tj);
+		const __m256 bottom = Lerp8(
+			_mm256_i32gather_ps(plane, footprint.Index10, 4),
+			_mm256_i32gather_ps(plane, footprint.Index11, 4), footprint.Tj);
+		return Lerp8(top, bottom, footprint.Ti);
+	}
+
+	size_t SampleHeights(const DX::WaveSurfaceView& view, const Lattice& lattice, const DX::WaveQueryBatch& batch)
+	{
+		const __m256 invSpatialStep = _mm256_set1_ps(lattice.InvSpatialStep);
+		const __m256 halfRows = _mm256_set1_ps(lattice.HalfRows);
+		const __m256 halfCols = _mm256_set1_ps(lattice.HalfCols);
+		const __m256 maxRow = _mm256_set1_ps(lattice.MaxRow);
+		const __m256 maxCol = _mm256_set1_ps(lattice.MaxCol);
+		const __m256 lastRowBase = _mm256_set1_ps(lattice.LastRowBase);
+		const __m256 lastColBase = _mm256_set1_ps(lattice.LastColBase);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256i pitch = _mm256_set1_epi32(lattice.Pitch);
+		const __m256i rowStep = _mm256_set1_epi32(lattice.RowStep);
+		const __m256i colStep = _mm256_set1_epi32(lattice.ColStep);
+
+		size_t q = 0;
+		for (; q + 8 <= batch.Count; q += 8)
+		{
+			// Same operation order as the scalar loop in WaveQuery.cpp, so both paths agree exactly.
+			__m256 fi = _mm256_sub_ps(halfRows, _mm256_mul_ps(_mm256_loadu_ps(batch.Z + q), invSpatialStep));
+			__m256 fj = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(batch.X + q), invSpatialStep), halfCols);
+			fi = _mm256_min_ps(_mm256_max_ps(fi, zero), maxRow);
+			fj = _mm256_min_ps(_mm256_max_ps(fj, zero), maxCol);
+			const __m256 baseI = _mm256_min_ps(_mm256_floor_ps(fi), lastRowBase);
+			const __m256 baseJ = _mm256_min_ps(_mm256_floor_ps(fj), lastColBase);
+
+			Footprint8 footprint;
+			footprint.Ti = _mm256_sub_ps(fi, baseI);
+			footprint.Tj = _mm256_sub_ps(fj, baseJ);
+			footprint.Index00 = _mm256_add_epi32(
+				_mm256_mullo_epi32(_mm256_cvttps_epi32(baseI), pitch), _mm256_cvttps_epi32(baseJ));
+			footprint.Index01 = _mm256_add_epi32(footprint.Index00, colStep);
+			footprint.Index10 = _mm256_add_epi32(footprint.Index00, rowStep);
+			footprint.Index11 = _mm256_add_epi32(footprint.Index10, colStep);
+
+			_mm256_storeu_ps(batch.Heights + q, Bilinear8(view.Heights, footprint));
+		}
+
+		return q;
+	}
+}
+
+DX::WaveQueryKernels::SampleKernel DX::WaveQueryKernels::GetAvx2SampleHeights()
+{
+	return SampleHeights;
+}
+#else
+DX::WaveQueryKernels::SampleKernel DX::WaveQueryKernels::GetAvx2SampleHeights()
+{
+	return nullptr;
+}
+#endif
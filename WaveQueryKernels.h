@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+	struct WaveSurfaceView;
+	struct WaveQueryBatch;
+
+	namespace WaveQueryKernels
+	{
+		// Per-batch constants shared by the scalar and SIMD paths.
+		struct Lattice
+		{
+			float InvSpatialStep;
+			float HalfRows;
+			float HalfCols;
+			float MaxRow;
+			float MaxCol;
+			float LastRowBase;
+			float LastColBase;
+			float TwoSpatialStep;
+			int RowStep;
+			int ColStep;
+			int Pitch;
+		};
+
+		// Samples the heights of the batch eight queries at a time from the
+		// Heights plane and returns how many it did; SampleWaveSurface
+		// finishes with its scalar loop, which evaluates the same expressions
+		// in the same order. Built with AVX2 in WaveQueryAvx2.cpp.
+		using SampleKernel = size_t (*)(const WaveSurfaceView& view, const Lattice& lattice, const WaveQueryBatch& batch);
+
+		// nullptr when the file was built without AVX2. Only call it once
+		// GetCpuFeatures reports AVX2.
+		SampleKernel GetAvx2SampleHeights();
+	}
+}
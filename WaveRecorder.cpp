@@ -0,0 +1,149 @@
+#include "WaveRecorder.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+DX::WaveRecorder::WaveRecorder(const std::filesystem::path& path, const uint64 interval, const uint32 maxPending) :
+	mFile(path, MappedFile::Mode::Write),
+	mInterval(interval > 0 ? interval : 1),
+	mMaxPending(maxPending > 0 ? maxPending : 1)
+{
+	const std::uint32_t header[2] = { WAVE_FILE_MAGIC, WAVE_FILE_VERSION };
+	mFile.Append(header, sizeof(header));
+
+	mWriter = std::thread(&WaveRecorder::WriterLoop, this);
+}
+
+DX::WaveRecorder::~WaveRecorder()
+{
+	{
+		std::lock_guard lock(mMutex);
+		mStopping = true;
+	}
+	mWake.notify_one();
+	mWriter.join();
+
+	mFile.Flush();
+}
+
+bool DX::WaveRecorder::Submit(WaveSnapshot&& snapshot)
+{
+	mNextDueStep = (snapshot.StepCount / mInterval + 1) * mInterval;
+
+	{
+		std::lock_guard lock(mMutex);
+		if (mFailed || mPending.size() >= mMaxPending)
+		{
+			++mDroppedFrames;
+			return false;
+		}
+		mPending.push_back(std::move(snapshot));
+	}
+	mWake.notify_one();
+	return true;
+}
+
+std::string DX::WaveRecorder::GetError()
+{
+	std::lock_guard lock(mMutex);
+	return mError;
+}
+
+void DX::WaveRecorder::Flush()
+{
+	std::unique_lock lock(mMutex);
+	mDrained.wait(lock, [this] { return mPending.empty() && !mWriting; });
+}
+
+void DX::WaveRecorder::WriterLoop()
+{
+	std::vector<std::uint8_t> record;
+
+	while (true)
+	{
+		WaveSnapshot snapshot;
+		{
+			std::unique_lock lock(mMutex);
+			mWake.wait(lock, [this] { return mStopping || !mPending.empty(); });
+
+			// Frames still queued at shutdown are written before the thread exits.
+			if (mPending.empty()) return;
+
+			snapshot = std::move(mPending.front());
+			mPending.pop_front();
+			mWriting = true;
+		}
+
+		std::string error;
+		try
+		{
+			record.clear();
+			EncodeWaveSnapshot(snapshot, record);
+			mFile.Append(record.data(), record.size());
+			++mRecordedFrames;
+		}
+		catch (const std::exception& e)
+		{
+			error = e.what();
+		}
+
+		{
+			std::lock_guard lock(mMutex);
+			mWriting = false;
+
+			// The file ends after the last complete frame; stop rather than
+			// retry, later frames would leave a gap in the recording.
+			if (!error.empty())
+			{
+				mError = std::move(error);
+				mFailed = true;
+				mDroppedFrames += mPending.size() + 1;
+				mPending.clear();
+			}
+		}
+		mDrained.notify_all();
+
+		if (mFailed) return;
+	}
+}
+
+DX::WaveRecordingReader::WaveRecordingReader(const std::filesystem::path& path) :
+	mFile(path, MappedFile::Mode::Read)
+{
+	const std::uint8_t* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	std::uint32_t header[2]{};
+	if (size >= WAVE_FILE_HEADER_SIZE)
+	{
+		std::memcpy(header, data, sizeof(header));
+	}
+
+	if (header[0] != WAVE_FILE_MAGIC || header[1] != WAVE_FILE_VERSION)
+	{
+		throw std::runtime_error("WaveRecordingReader: not a wave recording " + path.string());
+	}
+
+	// Walk the record headers once to find where each frame starts.
+	size_t offset = WAVE_FILE_HEADER_SIZE;
+	while (offset < size)
+	{
+		const size_t recordSize = PeekWaveRecordSize(data + offset, size - offset);
+		if (recordSize == 0) break;
+
+		mFrameOffsets.push_back(offset);
+		offset += recordSize;
+	}
+}
+
+void DX::WaveRecordingReader::ReadFrame(const size_t index, WaveSnapshot& snapshot) const
+{
+	assert(index < mFrameOffsets.size());
+
+	const size_t offset = mFrameOffsets[index];
+	if (DecodeWaveSnapshot(mFile.GetData() + offset, mFile.GetSize() - offset, snapshot) == 0)
+	{
+		throw std::runtime_error("WaveRecordingReader: corrupt frame");
+	}
+}
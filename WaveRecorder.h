@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+#include "WaveSnapshot.h"
+
+namespace DX
+{
+	/**
+	 * \brief Streams snapshots to a memory-mapped recording file. Submit only
+	 * moves the snapshot into a queue; encoding and writing happen on the
+	 * recorder's own thread. When that thread falls more than the pending
+	 * limit behind, new frames are dropped and counted instead of making
+	 * the simulation wait. If a write fails, for example because the disk is
+	 * full, recording stops: queued and later frames are dropped and
+	 * HasFailed reports the error.
+	 */
+	class WaveRecorder
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+		using uint64 = std::uint64_t;
+
+		static constexpr uint32 DEFAULT_MAX_PENDING = 8;
+
+		// Records a frame whenever the step count reaches a multiple of interval.
+		WaveRecorder(const std::filesystem::path& path, uint64 interval, uint32 maxPending = DEFAULT_MAX_PENDING);
+		WaveRecorder(const WaveRecorder&) = delete;
+		WaveRecorder(const WaveRecorder&&) = delete;
+		WaveRecorder& operator=(const WaveRecorder&) = delete;
+		WaveRecorder& operator=(const WaveRecorder&&) = delete;
+		~WaveRecorder();
+
+		[[nodiscard]] auto GetInterval()       const { return mInterval; }
+		[[nodiscard]] auto GetRecordedFrames() const { return mRecordedFrames.load(); }
+		[[nodiscard]] auto GetDroppedFrames()  const { return mDroppedFrames.load(); }
+		[[nodiscard]] bool HasFailed()         const { return mFailed.load(); }
+
+		// Why recording stopped, empty while HasFailed() is false.
+		[[nodiscard]] std::string GetError();
+
+		// True once stepCount has passed the next multiple of the interval.
+		[[nodiscard]] bool IsDue(uint64 stepCount) const { return stepCount >= mNextDueStep; }
+
+		// Returns false if the frame was dropped because the writer is behind or has failed.
+		bool Submit(WaveSnapshot&& snapshot);
+
+		// Blocks until every queued frame is in the file.
+		void Flush();
+
+	private:
+		void WriterLoop();
+
+	private:
+		MappedFile mFile;
+		uint64 mInterval;
+		uint32 mMaxPending;
+		uint64 mNextDueStep = 0;
+
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDrained;
+		std::deque<WaveSnapshot> mPending;
+		bool mWriting = false;
+		bool mStopping = false;
+		std::string mError;
+
+		std::atomic<uint64> mRecordedFrames = 0;
+		std::atomic<uint64> mDroppedFrames = 0;
+		std::atomic<bool> mFailed = false;
+
+		std::thread mWriter;
+	};
+
+	/**
+	 * \brief Random access to the frames of a recording or snapshot file.
+	 * A frame cut short by a crash while recording is ignored.
+	 */
+	class WaveRecordingReader
+	{
+	public:
+
+		// Throws std::runtime_error if the file is missing or not a recording.
+		explicit WaveRecordingReader(const std::filesystem::path& path);
+		WaveRecordingReader(const WaveRecordingReader&) = delete;
+		WaveRecordingReader(const WaveRecordingReader&&) = delete;
+		WaveRecordingReader& operator=(const WaveRecordingReader&) = delete;
+		WaveRecordingReader& operator=(const WaveRecordingReader&&) = delete;
+		~WaveRecordingReader() = default;
+
+		[[nodiscard]] size_t GetFrameCount() const { return mFrameOffsets.size(); }
+
+		void ReadFrame(size_t index, WaveSnapshot& snapshot) const;
+
+	private:
+		MappedFile mFile;
+		std::vector<size_t> mFrameOffsets;
+	};
+}
@@ -0,0 +1,314 @@
+#include "WaveSnapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+	// Fields are written in host byte order; every target we build for is little endian.
+	template <typename T>
+	void Put(std::vector<std::uint8_t>& out, const T& value)
+	{
+		const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	template <typename T>
+	bool Get(const std::uint8_t*& data, const std::uint8_t* end, T& value)
+	{
+		if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+		std::memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+		return true;
+	}
+
+	// magic, rows, cols, storage, scale, 3 constants, time step, spatial step
+	constexpr size_t RECORD_FIXED_FIELDS_SIZE = 10 * 4;
+	// step count and the two plane sizes
+	constexpr size_t RECORD_HEADER_SIZE = RECORD_FIXED_FIELDS_SIZE + 3 * 8;
+
+	void PutVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	bool GetVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64 && data < end; shift += 7)
+		{
+			const std::uint8_t byte = *data++;
+			value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) return true;
+		}
+		return false;
+	}
+
+	// Zero runs shorter than this are cheaper to keep inside a literal.
+	constexpr size_t MIN_ZERO_RUN = 3;
+
+	void EncodePlane(const std::uint8_t* plane, const size_t count, const size_t elementSize,
+		std::vector<std::uint8_t>& out)
+	{
+		const size_t byteCount = count * elementSize;
+		thread_local std::vector<std::uint8_t> shuffled;
+		shuffled.resize(byteCount);
+
+		std::uint32_t previous = 0;
+		for (size_t e = 0; e < count; ++e)
+		{
+			std::uint32_t value = 0;
+			std::memcpy(&value, plane + e * elementSize, elementSize);
+			const std::uint32_t delta = value ^ previous;
+			previous = value;
+
+			for (size_t b = 0; b < elementSize; ++b)
+			{
+				shuffled[b * count + e] = static_cast<std::uint8_t>(delta >> (8 * b));
+			}
+		}
+
+		// Tokens are varint(length << 1 | isZeroRun), literals carry their bytes.
+		size_t i = 0;
+		while (i < byteCount)
+		{
+			size_t run = 0;
+			while (i + run < byteCount && shuffled[i + run] == 0) ++run;
+
+			if (run >= MIN_ZERO_RUN || i + run == byteCount)
+			{
+				PutVarint(out, static_cast<std::uint64_t>(run) << 1 | 1);
+				i += run;
+				continue;
+			}
+
+			size_t literal = run;
+			while (i + literal < byteCount)
+			{
+				size_t zeros = 0;
+				while (zeros < MIN_ZERO_RUN && i + literal + zeros < byteCount && shuffled[i + literal + zeros] == 0) ++zeros;
+				if (zeros == MIN_ZERO_RUN) break;
+				literal += zeros == 0 ? 1 : zeros;
+			}
+
+			PutVarint(out, static_cast<std::uint64_t>(literal) << 1);
+			out.insert(out.end(), shuffled.begin() + i, shuffled.begin() + i + literal);
+			i += literal;
+		}
+	}
+
+	// Walks the tokens without writing anything, so a corrupt length cannot
+	// make the decoder allocate for more bytes than the plane will hold.
+	bool ValidatePlane(const std::uint8_t* data, const size_t size, const size_t byteCount)
+	{
+		const std::uint8_t* end = data + size;
+		size_t i = 0;
+		while (data < end)
+		{
+			std::uint64_t token = 0;
+			if (!GetVarint(data, end, token)) return false;
+
+			const std::uint64_t length = token >> 1;
+			if (length > byteCount - i) return false;
+
+			if ((token & 1) == 0)
+			{
+				if (length > static_cast<std::uint64_t>(end - data)) return false;
+				data += length;
+			}
+			i += static_cast<size_t>(length);
+		}
+		return i == byteCount;
+	}
+
+	bool DecodePlane(const std::uint8_t* data, const size_t size, const size_t count, const size_t elementSize,
+		std::vector<std::uint8_t>& plane)
+	{
+		const size_t byteCount = count * elementSize;
+		if (!ValidatePlane(data, size, byteCount)) return false;
+
+		thread_local std::vector<std::uint8_t> shuffled;
+		shuffled.resize(byteCount);
+
+		const std::uint8_t* end = data + size;
+		size_t i = 0;
+		while (data < end)
+		{
+			std::uint64_t token = 0;
+			GetVarint(data, end, token);
+
+			const size_t length = static_cast<size_t>(token >> 1);
+			if (token & 1)
+			{
+				std::memset(&shuffled[i], 0, length);
+			}
+			else
+			{
+				std::memcpy(&shuffled[i], data, length);
+				data += length;
+			}
+			i += length;
+		}
+
+		plane.resize(byteCount);
+		std::uint32_t previous = 0;
+		for (size_t e = 0; e < count; ++e)
+		{
+			std::uint32_t delta = 0;
+			for (size_t b = 0; b < elementSize; ++b)
+			{
+				delta |= static_cast<std::uint32_t>(shuffled[b * count + e]) << (8 * b);
+			}
+
+			previous ^= delta;
+			std::memcpy(&plane[e * elementSize], &previous, elementSize);
+		}
+		return true;
+	}
+}
+
+float DX::WaveSnapshot::GetHeight(const std::uint32_t i, const std::uint32_t j) const
+{
+	const size_t offset = (static_cast<size_t>(i) * Cols + j) * GetElementSize();
+
+	if (Storage == WaveStorage::Float32)
+	{
+		float height;
+		std::memcpy(&height, &CurrPlane[offset], sizeof(height));
+		return height;
+	}
+
+	std::uint16_t value;
+	std::memcpy(&value, &CurrPlane[offset], sizeof(value));
+	return Storage == WaveStorage::Float16 ?
+		HalfToFloat(value) :
+		static_cast<float>(static_cast<std::int16_t>(value)) * HeightScale;
+}
+
+void DX::EncodeWaveSnapshot(const WaveSnapshot& snapshot, std::vector<std::uint8_t>& out)
+{
+	const size_t count = static_cast<size_t>(snapshot.Rows) * snapshot.Cols;
+	const size_t elementSize = snapshot.GetElementSize();
+
+	Put(out, WAVE_RECORD_MAGIC);
+	Put(out, snapshot.Rows);
+	Put(out, snapshot.Cols);
+	Put(out, static_cast<std::uint32_t>(snapshot.Storage));
+	Put(out, snapshot.HeightScale);
+	Put(out, snapshot.SimulationConstants);
+	Put(out, snapshot.TimeStep);
+	Put(out, snapshot.SpatialStep);
+	Put(out, snapshot.StepCount);
+
+	// Plane sizes are patched in once the planes are encoded.
+	const size_t sizesOffset = out.size();
+	Put(out, std::uint64_t{ 0 });
+	Put(out, std::uint64_t{ 0 });
+
+	std::uint64_t planeBytes[2];
+	const std::vector<std::uint8_t>* planes[2] = { &snapshot.PrevPlane, &snapshot.CurrPlane };
+	for (int p = 0; p < 2; ++p)
+	{
+		const size_t start = out.size();
+		EncodePlane(planes[p]->data(), count, elementSize, out);
+		planeBytes[p] = out.size() - start;
+	}
+	std::memcpy(&out[sizesOffset], planeBytes, sizeof(planeBytes));
+}
+
+size_t DX::DecodeWaveSnapshot(const std::uint8_t* data, const size_t size, WaveSnapshot& snapshot)
+{
+	const std::uint8_t* cursor = data;
+	const std::uint8_t* end = data + size;
+
+	std::uint32_t magic = 0;
+	std::uint32_t storage = 0;
+	std::uint64_t planeBytes[2]{};
+	if (!Get(cursor, end, magic) || magic != WAVE_RECORD_MAGIC ||
+		!Get(cursor, end, snapshot.Rows) ||
+		!Get(cursor, end, snapshot.Cols) ||
+		snapshot.Rows > WAVE_SNAPSHOT_MAX_SIZE || snapshot.Cols > WAVE_SNAPSHOT_MAX_SIZE ||
+		!Get(cursor, end, storage) || storage > static_cast<std::uint32_t>(WaveStorage::Int16) ||
+		!Get(cursor, end, snapshot.HeightScale) ||
+		!Get(cursor, end, snapshot.SimulationConstants) ||
+		!Get(cursor, end, snapshot.TimeStep) ||
+		!Get(cursor, end, snapshot.SpatialStep) ||
+		!Get(cursor, end, snapshot.StepCount) ||
+		!Get(cursor, end, planeBytes))
+	{
+		return 0;
+	}
+	snapshot.Storage = static_cast<WaveStorage>(storage);
+
+	const size_t count = static_cast<size_t>(snapshot.Rows) * snapshot.Cols;
+	std::vector<std::uint8_t>* planes[2] = { &snapshot.PrevPlane, &snapshot.CurrPlane };
+	for (int p = 0; p < 2; ++p)
+	{
+		if (planeBytes[p] > static_cast<std::uint64_t>(end - cursor) ||
+			!DecodePlane(cursor, static_cast<size_t>(planeBytes[p]), count, snapshot.GetElementSize(), *planes[p]))
+		{
+			return 0;
+		}
+		cursor += planeBytes[p];
+	}
+
+	return static_cast<size_t>(cursor - data);
+}
+
+size_t DX::PeekWaveRecordSize(const std::uint8_t* data, const size_t size)
+{
+	std::uint32_t magic = 0;
+	std::uint64_t planeBytes[2]{};
+	if (size < RECORD_HEADER_SIZE) return 0;
+
+	std::memcpy(&magic, data, sizeof(magic));
+	std::memcpy(planeBytes, data + RECORD_HEADER_SIZE - sizeof(planeBytes), sizeof(planeBytes));
+	if (magic != WAVE_RECORD_MAGIC) return 0;
+
+	const std::uint64_t available = size - RECORD_HEADER_SIZE;
+	if (planeBytes[0] > available || planeBytes[1] > available - planeBytes[0]) return 0;
+
+	return RECORD_HEADER_SIZE + static_cast<size_t>(planeBytes[0] + planeBytes[1]);
+}
+
+void DX::SaveWaveSnapshot(const std::filesystem::path& path, const WaveSnapshot& snapshot)
+{
+	std::vector<std::uint8_t> bytes;
+	Put(bytes, WAVE_FILE_MAGIC);
+	Put(bytes, WAVE_FILE_VERSION);
+	EncodeWaveSnapshot(snapshot, bytes);
+
+	std::ofstream fout(path, std::ios::binary);
+	fout.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	if (!fout)
+	{
+		throw std::runtime_error("SaveWaveSnapshot: cannot write " + path.string());
+	}
+}
+
+DX::WaveSnapshot DX::LoadWaveSnapshot(const std::filesystem::path& path)
+{
+	std::ifstream fin(path, std::ios::binary);
+	const std::vector<std::uint8_t> bytes(
+		(std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+	const std::uint8_t* cursor = bytes.data();
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	WaveSnapshot snapshot;
+	if (!Get(cursor, bytes.data() + bytes.size(), magic) || magic != WAVE_FILE_MAGIC ||
+		!Get(cursor, bytes.data() + bytes.size(), version) || version != WAVE_FILE_VERSION ||
+		DecodeWaveSnapshot(cursor, bytes.size() - WAVE_FILE_HEADER_SIZE, snapshot) == 0)
+	{
+		throw std::runtime_error("LoadWaveSnapshot: malformed file " + path.string());
+	}
+
+	return snapshot;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "WaveStorage.h"
+
+namespace DX
+{
+	/**
+	 * \brief Full state of a wave solver at one step: the prev and curr
+	 * planes the next update reads, in the solver's own storage format, plus
+	 * what is needed to interpret them. Restoring prev and curr is enough
+	 * to continue bit for bit, the update has no other state.
+	 */
+	struct WaveSnapshot
+	{
+		std::uint32_t Rows = 0;
+		std::uint32_t Cols = 0;
+		WaveStorage Storage = WaveStorage::Float32;
+
+		// Height per stored int16 unit, 1 for the float formats.
+		float HeightScale = 1.0f;
+		float SimulationConstants[3]{};
+		float TimeStep = 0.0f;
+		float SpatialStep = 0.0f;
+		std::uint64_t StepCount = 0;
+
+		// Rows * Cols elements each, rows tightly packed.
+		std::vector<std::uint8_t> PrevPlane;
+		std::vector<std::uint8_t> CurrPlane;
+
+		[[nodiscard]] size_t GetElementSize() const { return Storage == WaveStorage::Float32 ? 4 : 2; }
+		[[nodiscard]] size_t GetPlaneSize() const { return static_cast<size_t>(Rows) * Cols * GetElementSize(); }
+
+		// Decoded height of a cell of the current plane.
+		[[nodiscard]] float GetHeight(std::uint32_t i, std::uint32_t j) const;
+	};
+
+	/*
+	 * Binary layout, little endian:
+	 *   file:   WAVE_FILE_MAGIC, version, then records back to back
+	 *   record: WAVE_RECORD_MAGIC, header fields of WaveSnapshot, the encoded
+	 *           sizes of both planes, then the two encoded planes
+	 * A plane is encoded by XORing every element with the one before it,
+	 * which zeroes the high bytes of smooth data, splitting the result into
+	 * byte planes and run-length coding the zero bytes. Calm water shrinks
+	 * to almost nothing.
+	 */
+	inline constexpr std::uint32_t WAVE_FILE_MAGIC   = 0x52564157; // "WAVR"
+	inline constexpr std::uint32_t WAVE_RECORD_MAGIC = 0x504e5357; // "WSNP"
+	inline constexpr std::uint32_t WAVE_FILE_VERSION = 1;
+	inline constexpr size_t WAVE_FILE_HEADER_SIZE = 8;
+
+	// Largest row or column count a record may claim, the D3D12 texture limit.
+	inline constexpr std::uint32_t WAVE_SNAPSHOT_MAX_SIZE = 16384;
+
+	// Appends one encoded record to out.
+	void EncodeWaveSnapshot(const WaveSnapshot& snapshot, std::vector<std::uint8_t>& out);
+
+	// Decodes the record at data. Returns the record size, or 0 when the
+	// bytes are not a complete, well-formed record. The planes are only
+	// allocated once their encoded bytes are known to fill them exactly.
+	size_t DecodeWaveSnapshot(const std::uint8_t* data, size_t size, WaveSnapshot& snapshot);
+
+	// Size of the record at data from its header alone, 0 if it is cut short.
+	size_t PeekWaveRecordSize(const std::uint8_t* data, size_t size);
+
+	// A snapshot file is a recording with a single frame. Both throw
+	// std::runtime_error on I/O failure or malformed data.
+	void SaveWaveSnapshot(const std::filesystem::path& path, const WaveSnapshot& snapshot);
+	[[nodiscard]] WaveSnapshot LoadWaveSnapshot(const std::filesystem::path& path);
+}
@@ -0,0 +1,70 @@
+#include "WaveStorage.h"
+
+#include <cstring>
+
+namespace
+{
+	std::uint32_t AsBits(const float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float AsFloat(const std::uint32_t bits)
+	{
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
+
+std::uint16_t DX::FloatToHalf(const float value)
+{
+	const std::uint32_t sign = (AsBits(value) >> 16) & 0x8000u;
+	std::uint32_t bits = AsBits(value) & 0x7fffffffu;
+
+	// 2^16 and above, infinity and NaN.
+	if (bits >= (127u + 16u) << 23)
+	{
+		return static_cast<std::uint16_t>(sign | (bits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+	}
+
+	// Below the smallest normal half: adding a magic value lines the
+	// mantissa up so the float add itself does the rounding.
+	if (bits < 113u << 23)
+	{
+		constexpr std::uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+		const std::uint32_t rounded = AsBits(AsFloat(bits) + AsFloat(denormMagic));
+		return static_cast<std::uint16_t>(sign | (rounded - denormMagic));
+	}
+
+	// Rebias the exponent and round the dropped 13 bits to nearest even;
+	// a carry out of the mantissa correctly rolls over into infinity.
+	const std::uint32_t mantissaOdd = (bits >> 13) & 1u;
+	bits += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+	return static_cast<std::uint16_t>(sign | (bits >> 13));
+}
+
+float DX::HalfToFloat(const std::uint16_t value)
+{
+	constexpr std::uint32_t shiftedExponent = 0x7c00u << 13;
+
+	std::uint32_t bits = (value & 0x7fffu) << 13;
+	const std::uint32_t exponent = bits & shiftedExponent;
+	bits += (127u - 15u) << 23;
+
+	if (exponent == shiftedExponent)
+	{
+		// Infinity and NaN keep an all-ones exponent.
+		bits += (128u - 16u) << 23;
+	}
+	else if (exponent == 0)
+	{
+		// Denormal half, renormalized by the float subtraction.
+		bits += 1u << 23;
+		bits = AsBits(AsFloat(bits) - AsFloat(113u << 23));
+	}
+
+	return AsFloat(bits | (static_cast<std::uint32_t>(value & 0x8000u) << 16));
+}
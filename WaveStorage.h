@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+	// How Waves and CpuWaves keep solution heights. The 16-bit modes halve
+	// the memory and bandwidth of a sweep; the stencil still runs in fp32
+	// and converts on load and store.
+	enum class WaveStorage
+	{
+		Float32,
+		Float16,
+		// Fixed point over [-heightRange, heightRange], see the solver constructors.
+		Int16,
+	};
+
+	// IEEE 754 binary16 conversions, rounding to nearest even like F16C does.
+	[[nodiscard]] std::uint16_t FloatToHalf(float value);
+	[[nodiscard]] float HalfToFloat(std::uint16_t value);
+}
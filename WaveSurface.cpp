@@ -0,0 +1,217 @@
+#include "WaveSurface.h"
+#include "CpuFeatures.h"
+#include "WaveSurfaceKernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVE_SURFACE_SSE2
+#endif
+
+namespace
+{
+	// The AVX2 row kernel when both the processor and the build have it.
+	const DX::WaveSurfaceKernels::DeriveRowKernel gAvx2DeriveRow =
+		DX::GetCpuFeatures().Avx2 ? DX::WaveSurfaceKernels::GetAvx2DeriveRow() : nullptr;
+}
+
+DX::WaveSurface::WaveSurface(const CpuWaves& waves) :
+	mNumRows(waves.GetRowCount()),
+	mNumCols(waves.GetColumnCount()),
+	mSpatialStep(waves.GetSpatialStep()),
+	mInvTimeStep(1.0f / waves.GetTimeStep()),
+	mRowPitch((static_cast<size_t>(waves.GetColumnCount()) + 2 + 15) / 16 * 16)
+{
+	// Until the first Update both buffers describe a flat surface at rest.
+	const size_t planeSize = static_cast<size_t>(mNumRows) * mRowPitch;
+	for (auto& buffer : mBuffers)
+	{
+		buffer.Heights.assign((static_cast<size_t>(mNumRows) + 2) * mRowPitch, 0.0f);
+		buffer.Cells.assign(planeSize * WaveSurfaceView::CELL_STRIDE, 0.0f);
+		buffer.NormalX.assign(planeSize, 0.0f);
+		buffer.NormalY.assign(planeSize, 1.0f);
+		buffer.NormalZ.assign(planeSize, 0.0f);
+		buffer.TangentX.assign(planeSize, 1.0f);
+		buffer.TangentY.assign(planeSize, 0.0f);
+	}
+}
+
+void DX::WaveSurface::Update(const CpuWaves& waves)
+{
+	assert(waves.GetRowCount() == mNumRows && waves.GetColumnCount() == mNumCols);
+
+	ThreadPool* threadPool = mThreadPool != nullptr ? mThreadPool : waves.GetThreadPool();
+
+	const uint32 back = 1 - mFront.load(std::memory_order_relaxed);
+	Buffer& buffer = mBuffers[back];
+
+	// Readers still holding a view of this slot see an odd sequence from here on.
+	mSequences[back].store(mSequences[back].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	// Heights first, the differences of a tile read the rows around it.
+	ForEachTile(threadPool, [this, &waves, &buffer](const uint32 tile)
+	{
+		const uint32 first = tile * TILE_ROWS;
+		const uint32 last = std::min(first + TILE_ROWS, mNumRows);
+		std::vector<float> prevHeights(mNumCols);
+		for (uint32 i = first; i < last; ++i)
+		{
+			float* heights = &buffer.Heights[(i + 1) * mRowPitch + 1];
+			float* cells = &buffer.Cells[i * mRowPitch * WaveSurfaceView::CELL_STRIDE];
+			waves.GetSolutionRow(i, heights);
+			waves.GetPrevSolutionRow(i, prevHeights.data());
+
+			for (uint32 j = 0; j < mNumCols; ++j)
+			{
+				cells[j * WaveSurfaceView::CELL_STRIDE] = heights[j];
+				cells[j * WaveSurfaceView::CELL_STRIDE + 1] = (heights[j] - prevHeights[j]) * mInvTimeStep;
+			}
+		}
+	});
+
+	ForEachTile(threadPool, [this, &buffer](const uint32 tile)
+	{
+		const uint32 first = tile * TILE_ROWS;
+		DeriveRows(buffer, first, std::min(first + TILE_ROWS, mNumRows));
+	});
+
+	mEpochs[back].store(waves.GetStepCount(), std::memory_order_relaxed);
+	mSequences[back].store(mSequences[back].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	mFront.store(back, std::memory_order_release);
+}
+
+DX::WaveSurfaceView DX::WaveSurface::Acquire() const
+{
+	const uint32 slot = mFront.load(std::memory_order_acquire);
+	const Buffer& buffer = mBuffers[slot];
+
+	WaveSurfaceView view;
+	view.Sequence = mSequences[slot].load(std::memory_order_acquire);
+	view.Epoch = mEpochs[slot].load(std::memory_order_relaxed);
+	view.Slot = slot;
+	view.Rows = mNumRows;
+	view.Cols = mNumCols;
+	view.SpatialStep = mSpatialStep;
+	view.RowPitch = mRowPitch;
+	view.Heights = &buffer.Heights[mRowPitch + 1];
+	view.Cells = buffer.Cells.data();
+	view.NormalX = buffer.NormalX.data();
+	view.NormalY = buffer.NormalY.data();
+	view.NormalZ = buffer.NormalZ.data();
+	view.TangentX = buffer.TangentX.data();
+	view.TangentY = buffer.TangentY.data();
+	return view;
+}
+
+bool DX::WaveSurface::IsIntact(const WaveSurfaceView& view) const
+{
+	// Orders the caller's reads of the planes before the sequence check.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const std::uint64_t sequence = mSequences[view.Slot].load(std::memory_order_relaxed);
+	return sequence == view.Sequence && (sequence & 1) == 0;
+}
+
+void DX::WaveSurface::ForEachTile(ThreadPool* threadPool, const std::function<void(uint32)>& body) const
+{
+	const uint32 tileCount = (mNumRows + TILE_ROWS - 1) / TILE_ROWS;
+	if (threadPool != nullptr)
+	{
+		threadPool->ParallelFor(tileCount, body);
+		return;
+	}
+
+	for (uint32 tile = 0; tile < tileCount; ++tile)
+	{
+		body(tile);
+	}
+}
+
+void DX::WaveSurface::DeriveRows(Buffer& buffer, const uint32 first, const uint32 last) const
+{
+	for (uint32 i = first; i < last; ++i)
+	{
+		const float* heights = &buffer.Heights[(i + 1) * mRowPitch + 1];
+		const size_t offset = i * mRowPitch;
+		DeriveRowSimd(heights, mRowPitch, mSpatialStep, &buffer.NormalX[offset], &buffer.NormalY[offset],
+			&buffer.NormalZ[offset], &buffer.TangentX[offset], &buffer.TangentY[offset], mNumCols);
+
+		float* cells = &buffer.Cells[offset * WaveSurfaceView::CELL_STRIDE];
+		for (size_t j = 0; j < mNumCols; ++j)
+		{
+			cells[j * WaveSurfaceView::CELL_STRIDE + 2] = heights[j - 1] - heights[j + 1];
+			cells[j * WaveSurfaceView::CELL_STRIDE + 3] = heights[j + mRowPitch] - heights[j - mRowPitch];
+		}
+	}
+}
+
+// Same differences as wavesVS.hlsl: n = (l - r, 2 * dx, b - t), where b is
+// the next row. The tangent (2 * dx, r - l, 0) is perpendicular to it.
+void DX::WaveSurface::DeriveRowScalar(const float* heights, const size_t pitch, const float spatialStep,
+	float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY, const size_t count)
+{
+	const float twoDx = 2.0f * spatialStep;
+
+	for (size_t x = 0; x < count; ++x)
+	{
+		const float nx = heights[x - 1] - heights[x + 1];
+		const float nz = heights[x + pitch] - heights[x - pitch];
+		const float invLength = 1.0f / std::sqrt(nx * nx + twoDx * twoDx + nz * nz);
+
+		normalX[x] = nx * invLength;
+		normalY[x] = twoDx * invLength;
+		normalZ[x] = nz * invLength;
+
+		const float ty = -nx;
+		const float invTangentLength = 1.0f / std::sqrt(twoDx * twoDx + ty * ty);
+
+		tangentX[x] = twoDx * invTangentLength;
+		tangentY[x] = ty * invTangentLength;
+	}
+}
+
+void DX::WaveSurface::DeriveRowSimd(const float* heights, const size_t pitch, const float spatialStep,
+	float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY, const size_t count)
+{
+	size_t x = 0;
+
+	if (gAvx2DeriveRow != nullptr)
+	{
+		x = gAvx2DeriveRow(heights, pitch, spatialStep, normalX, normalY, normalZ, tangentX, tangentY, count);
+	}
+#if defined(WAVE_SURFACE_SSE2)
+	else
+	{
+		const __m128 twoDx = _mm_set1_ps(2.0f * spatialStep);
+		const __m128 twoDxSq = _mm_mul_ps(twoDx, twoDx);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; x + 4 <= count; x += 4)
+		{
+			const __m128 nx = _mm_sub_ps(_mm_loadu_ps(heights + x - 1), _mm_loadu_ps(heights + x + 1));
+			const __m128 nz = _mm_sub_ps(_mm_loadu_ps(heights + x + pitch), _mm_loadu_ps(heights + x - pitch));
+
+			const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), twoDxSq), _mm_mul_ps(nz, nz));
+			const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+			_mm_storeu_ps(normalX + x, _mm_mul_ps(nx, invLength));
+			_mm_storeu_ps(normalY + x, _mm_mul_ps(twoDx, invLength));
+			_mm_storeu_ps(normalZ + x, _mm_mul_ps(nz, invLength));
+
+			const __m128 ty = _mm_sub_ps(zero, nx);
+			const __m128 invTangentLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(twoDxSq, _mm_mul_ps(ty, ty))));
+
+			_mm_storeu_ps(tangentX + x, _mm_mul_ps(twoDx, invTangentLength));
+			_mm_storeu_ps(tangentY + x, _mm_mul_ps(ty, invTangentLength));
+		}
+	}
+#endif
+
+	// Remainder, and the whole row on targets without SIMD.
+	DeriveRowScalar(heights + x, pitch, spatialStep, normalX + x, normalY + x, normalZ + x,
+		tangentX + x, tangentY + x, count - x);
+}
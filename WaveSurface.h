@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "CpuWaves.h"
+#include "ThreadPool.h"
+
+namespace DX
+{
+	// Read-only view of one published step. Cell (i, j) of every plane is
+	// at i * RowPitch + j. Heights also has a ring of zero cells around the
+	// grid, so index -1 and Rows / Cols are readable there.
+	struct WaveSurfaceView
+	{
+		std::uint64_t Epoch = 0;
+		std::uint64_t Sequence = 0;
+		std::uint32_t Slot = 0;
+
+		std::uint32_t Rows = 0;
+		std::uint32_t Cols = 0;
+		float SpatialStep = 0.0f;
+		size_t RowPitch = 0;
+
+		const float* Heights = nullptr;
+
+		// What a lookup needs of cell (i, j), interleaved at
+		// CELL_STRIDE * (i * RowPitch + j), so one cache line holds it for
+		// two neighbouring cells: the height, its rate of change over the
+		// last step, (curr - prev) / dt, and the x and z of the unnormalized
+		// normal, (l - r, 2 * dx, b - t).
+		const float* Cells = nullptr;
+		static constexpr size_t CELL_STRIDE = 4;
+
+		const float* NormalX = nullptr;
+		const float* NormalY = nullptr;
+		const float* NormalZ = nullptr;
+
+		// Unit tangent along +x (columns); its z component is always 0.
+		const float* TangentX = nullptr;
+		const float* TangentY = nullptr;
+	};
+
+	/**
+	 * \brief Derives heights, velocities, normals and tangents from a
+	 * CpuWaves solution once per simulation step, using the same central
+	 * differences as wavesVS.hlsl, and publishes them for CPU consumers such
+	 * as physics or AI. Results are double-buffered: Update fills the back buffer in
+	 * parallel row tiles and then flips an atomic index, so Acquire never
+	 * blocks and any number of threads can read at once.
+	 *
+	 * A view stays intact until Update has run twice more. Readers that can
+	 * be slower than that check IsIntact after reading and retry if false.
+	 */
+	class WaveSurface
+	{
+	public:
+
+		using uint32 = std::uint32_t;
+
+		explicit WaveSurface(const CpuWaves& waves);
+		WaveSurface(const WaveSurface&) = delete;
+		WaveSurface(const WaveSurface&&) = delete;
+		WaveSurface& operator=(const WaveSurface&) = delete;
+		WaveSurface& operator=(const WaveSurface&&) = delete;
+		~WaveSurface() = default;
+
+		// Tiles run on this pool, or on the solver's when none is set.
+		void SetThreadPool(ThreadPool* threadPool) { mThreadPool = threadPool; }
+
+		// Called by the simulation thread after the solver stepped.
+		void Update(const CpuWaves& waves);
+
+		[[nodiscard]] WaveSurfaceView Acquire() const;
+		[[nodiscard]] bool IsIntact(const WaveSurfaceView& view) const;
+
+		static constexpr uint32 TILE_ROWS = 32;
+
+	private:
+		struct Buffer
+		{
+			std::vector<float> Heights;
+			std::vector<float> Cells;
+			std::vector<float> NormalX;
+			std::vector<float> NormalY;
+			std::vector<float> NormalZ;
+			std::vector<float> TangentX;
+			std::vector<float> TangentY;
+		};
+
+		void ForEachTile(ThreadPool* threadPool, const std::function<void(uint32)>& body) const;
+		void DeriveRows(Buffer& buffer, uint32 first, uint32 last) const;
+
+		static void DeriveRowScalar(const float* heights, size_t pitch, float spatialStep,
+			float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY, size_t count);
+		static void DeriveRowSimd(const float* heights, size_t pitch, float spatialStep,
+			float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY, size_t count);
+
+	private:
+		uint32 mNumRows;
+		uint32 mNumCols;
+		float mSpatialStep;
+		float mInvTimeStep;
+		size_t mRowPitch;
+
+		ThreadPool* mThreadPool = nullptr;
+
+		std::array<Buffer, 2> mBuffers;
+
+		// Even while a slot is readable, odd while Update rewrites it.
+		std::array<std::atomic<std::uint64_t>, 2> mSequences{};
+		std::array<std::atomic<std::uint64_t>, 2> mEpochs{};
+		std::atomic<uint32> mFront = 0;
+	};
+}
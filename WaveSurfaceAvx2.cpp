@@ -0,0 +1,48 @@
+#include "WaveSurfaceKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+	size_t DeriveRow(const float* heights, const size_t pitch, const float spatialStep,
+		float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY, const size_t count)
+	{
+		const __m256 twoDx = _mm256_set1_ps(2.0f * spatialStep);
+		const __m256 twoDxSq = _mm256_mul_ps(twoDx, twoDx);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			const __m256 nx = _mm256_sub_ps(_mm256_loadu_ps(heights + x - 1), _mm256_loadu_ps(heights + x + 1));
+			const __m256 nz = _mm256_sub_ps(_mm256_loadu_ps(heights + x + pitch), _mm256_loadu_ps(heights + x - pitch));
+
+			const __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), twoDxSq), _mm256_mul_ps(nz, nz));
+			const __m256 invLength = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSq));
+
+			_mm256_storeu_ps(normalX + x, _mm256_mul_ps(nx, invLength));
+			_mm256_storeu_ps(normalY + x, _mm256_mul_ps(twoDx, invLength));
+			_mm256_storeu_ps(normalZ + x, _mm256_mul_ps(nz, invLength));
+
+			const __m256 ty = _mm256_sub_ps(zero, nx);
+			const __m256 invTangentLength = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(twoDxSq, _mm256_mul_ps(ty, ty))));
+
+			_mm256_storeu_ps(tangentX + x, _mm256_mul_ps(twoDx, invTangentLength));
+			_mm256_storeu_ps(tangentY + x, _mm256_mul_ps(ty, invTangentLength));
+		}
+		return x;
+	}
+}
+
+DX::WaveSurfaceKernels::DeriveRowKernel DX::WaveSurfaceKernels::GetAvx2DeriveRow()
+{
+	return DeriveRow;
+}
+#else
+DX::WaveSurfaceKernels::DeriveRowKernel DX::WaveSurfaceKernels::GetAvx2DeriveRow()
+{
+	return nullptr;
+}
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+	namespace WaveSurfaceKernels
+	{
+		// Derives the normals and tangents of count cells of a row from the
+		// heights around them, eight cells at a time, and returns how many it
+		// did; WaveSurface finishes the row with its scalar kernel, which
+		// evaluates the same expressions in the same order. Built with AVX2
+		// in WaveSurfaceAvx2.cpp.
+		using DeriveRowKernel = size_t (*)(const float* heights, size_t pitch, float spatialStep,
+			float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY, size_t count);
+
+		// nullptr when the file was built without AVX2. Only call it once
+		// GetCpuFeatures reports AVX2.
+		DeriveRowKernel GetAvx2DeriveRow();
+	}
+}
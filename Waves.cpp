@@ -2,16 +2,46 @@
 #include "3rdparty/DirectXTK12/Inc/ResourceUploadBatch.h"
 
 DX::Waves::Waves(ID3D12Device* device, ID3D12CommandQueue* cmdQueue,
-                 const int m, const int n, const float dx, const float dt, const float speed, const float damping) :
+                 const int m, const int n, const float dx, const float dt, const float speed, const float damping,
+                 const WaveStorage storage, const float heightRange) :
 	mNumRows(m),
 	mNumCols(n),
 	mVertexCount(m * n),
 	mTriangleCount((m - 1) * (n - 1) * 2),
 	mTimeStep(dt),
 	mSpatialStep(dx),
+	mClock(dt),
+	mStorage(storage),
+	mDisplacementRange(heightRange),
 	md3dDevice(device)
 {
-	assert((m * n) % 256 == 0);
+	assert(m > 0 && n > 0);
+	assert(heightRange > 0.0f);
+
+	if (mStorage == WaveStorage::Float16) mFormat = DXGI_FORMAT_R16_FLOAT;
+	if (mStorage == WaveStorage::Int16)   mFormat = DXGI_FORMAT_R16_SNORM;
+
+	// The update shader reads its inputs through typed UAVs, which only R32_FLOAT guarantees.
+	if (mFormat != DXGI_FORMAT_R32_FLOAT)
+	{
+		D3D12_FEATURE_DATA_FORMAT_SUPPORT formatSupport = { mFormat, D3D12_FORMAT_SUPPORT1_NONE, D3D12_FORMAT_SUPPORT2_NONE };
+		ThrowIfFailed(md3dDevice->CheckFeatureSupport(D3D12_FEATURE_FORMAT_SUPPORT,
+			&formatSupport, sizeof(formatSupport)));
+
+		if ((formatSupport.Support2 & D3D12_FORMAT_SUPPORT2_UAV_TYPED_LOAD) == 0)
+		{
+			OutputDebugStringA("Waves: typed UAV loads unsupported for the requested storage, using R32_FLOAT.\n");
+			mStorage = WaveStorage::Float32;
+			mFormat = DXGI_FORMAT_R32_FLOAT;
+		}
+	}
+
+	if (mStorage == WaveStorage::Int16)
+	{
+		mHeightScale = heightRange;
+		mInvHeightScale = 1.0f / heightRange;
+		mDisplacementRange = 1.0f;
+	}
 
 	const float d = damping * dt + 2.0f;
 	const float e = (speed * speed) * (dt * dt) / (dx * dx);
@@ -25,7 +55,7 @@ DX::Waves::Waves(ID3D12Device* device, ID3D12CommandQueue* cmdQueue,
 void DX::Waves::BuildResource(ID3D12CommandQueue* cmdQueue)
 {
 	const auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-	auto texDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_FLOAT, 
+	auto texDesc = CD3DX12_RESOURCE_DESC::Tex2D(mFormat, 
 		mNumCols, mNumRows, 1, 1);
 	texDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
@@ -50,14 +80,28 @@ void DX::Waves::BuildResource(ID3D12CommandQueue* cmdQueue)
 		nullptr,
 		IID_PPV_ARGS(&mNextSol)));
 
+	// Filled by UpdateNormals before the first frame draws the waves.
+	auto normalDesc = CD3DX12_RESOURCE_DESC::Tex2D(NORMAL_MAP_FORMAT, mNumCols, mNumRows, 1, 1);
+	normalDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(&heapProp,
+		D3D12_HEAP_FLAG_NONE,
+		&normalDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mNormalMap)));
+
 	mPrevSol->SetName(L"Simulation Solution0");
 	mCurrSol->SetName(L"Simulation Solution1");
 	mNextSol->SetName(L"Simulation Solution2");
+	mNormalMap->SetName(L"Simulation Normals");
 
-	std::vector heights(mNumRows * mNumCols, 0.0f);
+	// Zero is all zero bits in every storage format.
+	const UINT elementSize = mFormat == DXGI_FORMAT_R32_FLOAT ? 4 : 2;
+	std::vector<BYTE> heights(static_cast<size_t>(mNumRows) * mNumCols * elementSize, 0);
 	D3D12_SUBRESOURCE_DATA initData;
 	initData.pData      = heights.data();
-	initData.RowPitch   = static_cast<LONG_PTR>(mNumCols * sizeof(float));
+	initData.RowPitch   = static_cast<LONG_PTR>(mNumCols) * elementSize;
 	initData.SlicePitch = initData.RowPitch * mNumRows;
 
 	DirectX::ResourceUploadBatch upload1(md3dDevice);
@@ -83,13 +127,13 @@ void DX::Waves::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuDesc, CD3DX12
 {
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
 	srvDesc.Shader4ComponentMapping   = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format                    = DXGI_FORMAT_R32_FLOAT;
+	srvDesc.Format                    = mFormat;
 	srvDesc.ViewDimension             = D3D12_SRV_DIMENSION_TEXTURE2D;
 	srvDesc.Texture2D.MostDetailedMip = 0;
 	srvDesc.Texture2D.MipLevels       = 1;
 
 	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
-	uavDesc.Format             = DXGI_FORMAT_R32_FLOAT;
+	uavDesc.Format             = mFormat;
 	uavDesc.ViewDimension      = D3D12_UAV_DIMENSION_TEXTURE2D;
 	uavDesc.Texture2D.MipSlice = 0;
 
@@ -101,39 +145,55 @@ void DX::Waves::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE hCpuDesc, CD3DX12
 	md3dDevice->CreateUnorderedAccessView(mCurrSol.Get(), nullptr, &uavDesc, hCpuDesc.Offset(1, descSize));
 	md3dDevice->CreateUnorderedAccessView(mNextSol.Get(), nullptr, &uavDesc, hCpuDesc.Offset(1, descSize));
 
+	srvDesc.Format = NORMAL_MAP_FORMAT;
+	uavDesc.Format = NORMAL_MAP_FORMAT;
+	md3dDevice->CreateShaderResourceView(mNormalMap.Get(), &srvDesc, hCpuDesc.Offset(1, descSize));
+	md3dDevice->CreateUnorderedAccessView(mNormalMap.Get(), nullptr, &uavDesc, hCpuDesc.Offset(1, descSize));
+
 	mPrevSolSrv = hGpuDesc;
 	mCurrSolSrv = hGpuDesc.Offset(1, descSize);
 	mNextSolSrv = hGpuDesc.Offset(1, descSize);
 	mPrevSolUav = hGpuDesc.Offset(1, descSize);
 	mCurrSolUav = hGpuDesc.Offset(1, descSize);
 	mNextSolUav = hGpuDesc.Offset(1, descSize);
+	mNormalMapSrv = hGpuDesc.Offset(1, descSize);
+	mNormalMapUav = hGpuDesc.Offset(1, descSize);
 }
 
 void DX::Waves::Update(const GameTimer& gameTimer, ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig,
                        ID3D12PipelineState* pso)
 {
-	static float t = 0.0f;
-	t += gameTimer.DeltaTime();
+	const UINT stepCount = mClock.Advance(gameTimer.DeltaTime());
+	if (stepCount == 0) return;
+	mStepCount += stepCount;
+	mNormalsDirty = true;
 
-	if (t >= mTimeStep)
+	cmdList->SetPipelineState(pso);
+	cmdList->SetComputeRootSignature(rootSig);
+	cmdList->SetComputeRoot32BitConstants(0, 3, mSimulationConstants, 0);
+
+	// Round up; threads of the last groups that fall outside the grid exit early.
+	const UINT groupNumX = (mNumCols + 15) / 16;
+	const UINT groupNumY = (mNumRows + 15) / 16;
+
+	for (UINT step = 0; step < stepCount; ++step)
 	{
 		// prev(unordered access) curr(generic read) next(unordered access)
+		// next was read as prev by the previous substep, so its writes wait on that dispatch.
 		{
-			const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
-				D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-			cmdList->ResourceBarrier(1, &barrier);
+			const CD3DX12_RESOURCE_BARRIER barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+					D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+				CD3DX12_RESOURCE_BARRIER::UAV(mNextSol.Get()),
+			};
+			cmdList->ResourceBarrier(step == 0 ? 1 : _countof(barriers), barriers);
 		}
 
-		cmdList->SetPipelineState(pso);
-		cmdList->SetComputeRootSignature(rootSig);
-		cmdList->SetComputeRoot32BitConstants(0, 3, mSimulationConstants, 0);
 		cmdList->SetComputeRootDescriptorTable(1, mPrevSolUav);
 		cmdList->SetComputeRootDescriptorTable(2, mCurrSolUav);
 		cmdList->SetComputeRootDescriptorTable(3, mNextSolUav);
 
-		const UINT groupNumX = mNumCols / 16;
-		const UINT groupNumY = mNumRows / 16;
-
 		cmdList->Dispatch(groupNumX, groupNumY, 1);
 
 		std::swap(mPrevSol, mCurrSol);
@@ -145,18 +205,54 @@ void DX::Waves::Update(const GameTimer& gameTimer, ID3D12GraphicsCommandList* cm
 		std::swap(mPrevSolUav, mCurrSolUav);
 		std::swap(mCurrSolUav, mNextSolUav);
 
-		t = 0.0f;
-
 		{
 			const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
-			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ);
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ);
 			cmdList->ResourceBarrier(1, &barrier);
 		}
 	}
 }
 
+void DX::Waves::UpdateNormals(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig,
+                              ID3D12PipelineState* pso)
+{
+	if (!mNormalsDirty) return;
+	mNormalsDirty = false;
+
+	cmdList->SetPipelineState(pso);
+	cmdList->SetComputeRootSignature(rootSig);
+	cmdList->SetComputeRoot32BitConstants(0, 1, &mInvHeightScale, 7);
+	cmdList->SetComputeRoot32BitConstants(0, 1, &mSpatialStep, 8);
+	cmdList->SetComputeRootDescriptorTable(2, mCurrSolUav);
+	cmdList->SetComputeRootDescriptorTable(5, mNormalMapUav);
+
+	{
+		const CD3DX12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+				D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(mNormalMap.Get(),
+				D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+		};
+		cmdList->ResourceBarrier(_countof(barriers), barriers);
+	}
+
+	cmdList->Dispatch((mNumCols + 15) / 16, (mNumRows + 15) / 16, 1);
+
+	{
+		const CD3DX12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ),
+			CD3DX12_RESOURCE_BARRIER::Transition(mNormalMap.Get(),
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ),
+		};
+		cmdList->ResourceBarrier(_countof(barriers), barriers);
+	}
+}
+
 void DX::Waves::Disturb(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig, ID3D12PipelineState* pso,
-                        const UINT i, const UINT j, const float magnitude) const
+                        const UINT i, const UINT j, const float magnitude)
 {
 	cmdList->SetPipelineState(pso);
 	cmdList->SetComputeRootSignature(rootSig);
@@ -164,6 +260,7 @@ void DX::Waves::Disturb(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature*
 	const UINT disturbIdx[2] = { j, i };
 	cmdList->SetComputeRoot32BitConstants(0, 1, &magnitude, 3);
 	cmdList->SetComputeRoot32BitConstants(0, 2, disturbIdx, 4);
+	cmdList->SetComputeRoot32BitConstants(0, 1, &mInvHeightScale, 7);
 	cmdList->SetComputeRootDescriptorTable(3, mCurrSolUav);
 
 	{
@@ -179,4 +276,180 @@ void DX::Waves::Disturb(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature*
 			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ);
 		cmdList->ResourceBarrier(1, &barrier);
 	}
+
+	mNormalsDirty = true;
+}
+
+void DX::Waves::DisturbBatch(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig, ID3D12PipelineState* pso,
+                             std::unique_ptr<UploadBuffer<WaveCellDelta>>& cellBuffer,
+                             const WaveDisturbance* disturbances, const UINT count)
+{
+	CompactDisturbances(disturbances, count, mNumRows, mNumCols, mCellDeltas);
+	if (mCellDeltas.empty()) return;
+
+	const auto cellCount = static_cast<UINT>(mCellDeltas.size());
+	if (cellBuffer->GetElementCount() < cellCount)
+	{
+		// The GPU is done with this frame resource, so its buffer can go.
+		const UINT chunkCount = (cellCount + MAX_DISTURB_CELLS - 1) / MAX_DISTURB_CELLS;
+		cellBuffer = std::make_unique<UploadBuffer<WaveCellDelta>>(md3dDevice, chunkCount * MAX_DISTURB_CELLS, false);
+	}
+	cellBuffer->CopyData(0, mCellDeltas.data(), cellCount);
+
+	cmdList->SetPipelineState(pso);
+	cmdList->SetComputeRootSignature(rootSig);
+	cmdList->SetComputeRoot32BitConstants(0, 1, &mInvHeightScale, 7);
+	cmdList->SetComputeRootDescriptorTable(3, mCurrSolUav);
+
+	{
+		const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+			D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		cmdList->ResourceBarrier(1, &barrier);
+	}
+
+	// Cells are unique after compaction, so threads never race on a texel.
+	// The UAV barrier keeps the chunks in order all the same.
+	const D3D12_GPU_VIRTUAL_ADDRESS cellAddress = cellBuffer->Resource()->GetGPUVirtualAddress();
+	for (UINT first = 0; first < cellCount; first += MAX_DISTURB_CELLS)
+	{
+		if (first > 0)
+		{
+			const auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(mCurrSol.Get());
+			cmdList->ResourceBarrier(1, &barrier);
+		}
+
+		const UINT chunkCells = std::min(cellCount - first, MAX_DISTURB_CELLS);
+		cmdList->SetComputeRoot32BitConstants(0, 1, &chunkCells, 6);
+		cmdList->SetComputeRootShaderResourceView(4, cellAddress + first * sizeof(WaveCellDelta));
+		cmdList->Dispatch((chunkCells + 63) / 64, 1, 1);
+	}
+
+	{
+		const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+			D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ);
+		cmdList->ResourceBarrier(1, &barrier);
+	}
+
+	mNormalsDirty = true;
+}
+
+void DX::Waves::CopyStateToReadback(ID3D12GraphicsCommandList* cmdList)
+{
+	if (mReadback[0] == nullptr)
+	{
+		const auto texDesc = mCurrSol->GetDesc();
+		UINT64 totalBytes = 0;
+		md3dDevice->GetCopyableFootprints(&texDesc, 0, 1, 0, &mReadbackFootprint, nullptr, nullptr, &totalBytes);
+
+		const auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+		const auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(totalBytes);
+		for (auto& readback : mReadback)
+		{
+			ThrowIfFailed(md3dDevice->CreateCommittedResource(&heapProp,
+				D3D12_HEAP_FLAG_NONE,
+				&bufferDesc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(&readback)));
+		}
+		mReadback[0]->SetName(L"Simulation Readback0");
+		mReadback[1]->SetName(L"Simulation Readback1");
+	}
+
+	// prev(unordered access) curr(generic read)
+	{
+		const CD3DX12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(mPrevSol.Get(),
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+				D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE),
+		};
+		cmdList->ResourceBarrier(_countof(barriers), barriers);
+	}
+
+	ID3D12Resource* sources[2] = { mPrevSol.Get(), mCurrSol.Get() };
+	for (int p = 0; p < 2; ++p)
+	{
+		const CD3DX12_TEXTURE_COPY_LOCATION dest(mReadback[p].Get(), mReadbackFootprint);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(sources[p], 0);
+		cmdList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+	}
+
+	{
+		const CD3DX12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(mPrevSol.Get(),
+				D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(mCurrSol.Get(),
+				D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_GENERIC_READ),
+		};
+		cmdList->ResourceBarrier(_countof(barriers), barriers);
+	}
+
+	mReadbackStepCount = mStepCount;
+}
+
+void DX::Waves::ReadSnapshot(WaveSnapshot& snapshot) const
+{
+	assert(mReadback[0] != nullptr);
+
+	snapshot.Rows = mNumRows;
+	snapshot.Cols = mNumCols;
+	snapshot.Storage = mStorage;
+	snapshot.HeightScale = mStorage == WaveStorage::Int16 ? mHeightScale / 32767.0f : 1.0f;
+	std::copy_n(mSimulationConstants, 3, snapshot.SimulationConstants);
+	snapshot.TimeStep = mTimeStep;
+	snapshot.SpatialStep = mSpatialStep;
+	snapshot.StepCount = mReadbackStepCount;
+
+	// Readback rows are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, snapshot rows are not.
+	const size_t rowBytes = mNumCols * snapshot.GetElementSize();
+	const UINT rowPitch = mReadbackFootprint.Footprint.RowPitch;
+	std::vector<std::uint8_t>* planes[2] = { &snapshot.PrevPlane, &snapshot.CurrPlane };
+	for (int p = 0; p < 2; ++p)
+	{
+		planes[p]->resize(snapshot.GetPlaneSize());
+
+		BYTE* mapped = nullptr;
+		const D3D12_RANGE readRange = { 0, static_cast<SIZE_T>(rowPitch) * mNumRows };
+		ThrowIfFailed(mReadback[p]->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+		for (UINT i = 0; i < mNumRows; ++i)
+		{
+			memcpy(planes[p]->data() + i * rowBytes, mapped + mReadbackFootprint.Offset + i * rowPitch, rowBytes);
+		}
+		const D3D12_RANGE writeRange = { 0, 0 };
+		mReadback[p]->Unmap(0, &writeRange);
+	}
+}
+
+void DX::Waves::Restore(ID3D12CommandQueue* cmdQueue, const WaveSnapshot& snapshot)
+{
+	assert(snapshot.Rows == mNumRows && snapshot.Cols == mNumCols && snapshot.Storage == mStorage);
+
+	D3D12_SUBRESOURCE_DATA planeData[2];
+	const std::vector<std::uint8_t>* planes[2] = { &snapshot.PrevPlane, &snapshot.CurrPlane };
+	for (int p = 0; p < 2; ++p)
+	{
+		planeData[p].pData      = planes[p]->data();
+		planeData[p].RowPitch   = static_cast<LONG_PTR>(mNumCols * snapshot.GetElementSize());
+		planeData[p].SlicePitch = planeData[p].RowPitch * mNumRows;
+	}
+
+	DirectX::ResourceUploadBatch upload(md3dDevice);
+	upload.Begin();
+	upload.Transition(mPrevSol.Get(),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST);
+	upload.Transition(mCurrSol.Get(),
+		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST);
+	upload.Upload(mPrevSol.Get(), 0, &planeData[0], 1);
+	upload.Upload(mCurrSol.Get(), 0, &planeData[1], 1);
+	upload.Transition(mPrevSol.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	upload.Transition(mCurrSol.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+	upload.End(cmdQueue).wait();
+
+	mStepCount = snapshot.StepCount;
+	mNormalsDirty = true;
 }
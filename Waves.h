@@ -1,7 +1,12 @@
 #pragma once
 
 #include "D3DUtil.h"
+#include "FixedStepClock.h"
 #include "GameTimer.h"
+#include "UploadBuffer.h"
+#include "WaveDisturbance.h"
+#include "WaveSnapshot.h"
+#include "WaveStorage.h"
 
 namespace DX
 {
@@ -9,8 +14,11 @@ namespace DX
 	{
 	public:
 
+		// Int16 is stored as R16_SNORM covering [-heightRange, heightRange]. 16-bit
+		// modes the device cannot load from a typed UAV fall back to Float32.
 		Waves(ID3D12Device* device, ID3D12CommandQueue* cmdQueue, 
-		     int m, int n, float dx, float dt, float speed, float damping);
+		     int m, int n, float dx, float dt, float speed, float damping,
+		     WaveStorage storage = WaveStorage::Float32, float heightRange = 8.0f);
 		Waves(const Waves&) = delete;
 		Waves(const Waves&&) = delete;
 		Waves& operator=(const Waves&) = delete;
@@ -30,14 +38,52 @@ namespace DX
 		[[nodiscard]] auto GetDepth()           const { return static_cast<float>(mNumRows) * mSpatialStep; }
 		[[nodiscard]] auto GetSpatialStep()     const { return mSpatialStep; }
 		[[nodiscard]] auto GetDisplacementMap() const { return mCurrSolSrv; }
+		[[nodiscard]] auto GetNormalMap()       const { return mNormalMapSrv; }
+		[[nodiscard]] auto GetInterpolationAlpha() const { return mClock.GetAlpha(); }
+		[[nodiscard]] auto GetStorage()         const { return mStorage; }
+		[[nodiscard]] auto GetStepCount()       const { return mStepCount; }
+
+		// Factor turning a displacement map sample into a height.
+		[[nodiscard]] auto GetDisplacementScale() const { return mHeightScale; }
+
+		// Largest magnitude of a displacement map sample: 1 for the R16_SNORM
+		// map, heightRange for the float ones. Float heights are not clamped,
+		// but the drops MyGame makes keep them well inside it.
+		[[nodiscard]] auto GetDisplacementRange() const { return mDisplacementRange; }
+
+		void SetMaxSubsteps(UINT maxSubsteps) { mClock.SetMaxSubsteps(maxSubsteps); }
 
 		void Update(const GameTimer& gameTimer, ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig,
 		            ID3D12PipelineState* pso);
 
+		// Rederives the normal map from the current heights if they changed
+		// since the last call. Call once per frame, after Update and any drops.
+		void UpdateNormals(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig, ID3D12PipelineState* pso);
+
 		void Disturb(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig, ID3D12PipelineState* pso,
-					 UINT i, UINT j, float magnitude) const;
+					 UINT i, UINT j, float magnitude);
+
+		// Applies all drops of a frame in one pass. The drops are merged into
+		// unique cell deltas and written to cellBuffer, one dispatch per
+		// MAX_DISTURB_CELLS of them. cellBuffer must belong to the current
+		// frame resource, so call this at most once per frame; it is
+		// recreated larger when the deltas do not fit.
+		void DisturbBatch(ID3D12GraphicsCommandList* cmdList, ID3D12RootSignature* rootSig, ID3D12PipelineState* pso,
+						  std::unique_ptr<UploadBuffer<WaveCellDelta>>& cellBuffer,
+						  const WaveDisturbance* disturbances, UINT count);
+
+		// Records a copy of prev and curr into readback memory. Once the GPU
+		// has executed cmdList, ReadSnapshot turns that copy into a snapshot.
+		void CopyStateToReadback(ID3D12GraphicsCommandList* cmdList);
+		void ReadSnapshot(WaveSnapshot& snapshot) const;
 
-		static constexpr int SRV_UAV_COUNT = 6;
+		// Uploads a snapshot taken from Waves or CpuWaves with the same size
+		// and storage and waits for it. The GPU must be done with the waves.
+		void Restore(ID3D12CommandQueue* cmdQueue, const WaveSnapshot& snapshot);
+
+		static constexpr int SRV_UAV_COUNT = 8;
+		static constexpr DXGI_FORMAT NORMAL_MAP_FORMAT = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		static constexpr UINT MAX_DISTURB_CELLS = 4096 * 5;
 
 	private:
 		UINT mNumRows;
@@ -48,6 +94,16 @@ namespace DX
 		float mSimulationConstants[3]{};
 		float mTimeStep;
 		float mSpatialStep;
+		FixedStepClock mClock;
+		UINT64 mStepCount = 0;
+
+		WaveStorage mStorage;
+		DXGI_FORMAT mFormat = DXGI_FORMAT_R32_FLOAT;
+
+		// Height per stored unit; the inverse goes to root constant 7.
+		float mHeightScale = 1.0f;
+		float mInvHeightScale = 1.0f;
+		float mDisplacementRange;
 
 		ID3D12Device* md3dDevice;
 
@@ -62,5 +118,17 @@ namespace DX
 		Microsoft::WRL::ComPtr<ID3D12Resource> mPrevSol;
 		Microsoft::WRL::ComPtr<ID3D12Resource> mCurrSol;
 		Microsoft::WRL::ComPtr<ID3D12Resource> mNextSol;
+
+		// xyz unit normal per cell, read by wavesVS instead of differencing heights per vertex.
+		Microsoft::WRL::ComPtr<ID3D12Resource> mNormalMap;
+		CD3DX12_GPU_DESCRIPTOR_HANDLE mNormalMapSrv;
+		CD3DX12_GPU_DESCRIPTOR_HANDLE mNormalMapUav;
+		bool mNormalsDirty = true;
+
+		std::vector<WaveCellDelta> mCellDeltas;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> mReadback[2];
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT mReadbackFootprint{};
+		UINT64 mReadbackStepCount = 0;
 	};
 }
@@ -17,6 +17,7 @@
 
 Texture2D<float4> gDiffuseMap : register(t0);
 Texture2D<float> gDisplacementMap : register(t1);
+Texture2D<float4> gNormalMap : register(t2);
 
 SamplerState gSamPointWrap        : register(s0);
 SamplerState gSamPointClamp       : register(s1);
@@ -32,6 +33,7 @@ cbuffer cbPerObect : register(b0)
     float4x4 gWorldInvTranspose;
     float2 gDisplacementMapTexelSize;
     float  gGridSpatialStep;
+    float  gDisplacementScale;
 }
 
 cbuffer cbPass : register(b1)